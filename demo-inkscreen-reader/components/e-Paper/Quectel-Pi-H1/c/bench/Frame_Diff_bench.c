@@ -0,0 +1,176 @@
+/*****************************************************************************
+* | File      	:   Frame_Diff_bench.c
+* | Function    :   Cost of finding what changed between two panel frames
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Frame_Diff_bench [diffs]
+*   Random changes (single bytes, spans, scattered rows, whole frames)
+*   are made to an 800x480 frame; Frame_Diff() must report exactly the
+*   rows and columns a byte by byte comparison finds and leave the
+*   previous frame equal to the new one. Then identical frames, a
+*   changed footer and a new page are diffed, best of BENCH_RUNS runs,
+*   against a byte by byte comparison followed by a full copy.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_FrameDiff.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DIFFS     2000
+#define BENCH_RUNS      5
+#define BENCH_WB        (800 / 8)
+#define BENCH_HEIGHT    480
+#define BENCH_SIZE      (BENCH_WB * BENCH_HEIGHT)
+#define BENCH_CHECKS    2000
+
+static UBYTE frame[BENCH_SIZE], prev[BENCH_SIZE], copy[BENCH_SIZE];
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Byte by byte, the reference and the baseline
+static int plain_diff(const UBYTE *a, UBYTE *b, FRAME_DIFF *d)
+{
+    int x, y, changed = 0, in_run = 0;
+
+    d->Runs = 0;
+    d->Xstart = BENCH_WB * 8;
+    d->Xend = 0;
+    for (y = 0; y < BENCH_HEIGHT; y++) {
+        int row = 0;
+        for (x = 0; x < BENCH_WB; x++) {
+            if (a[y * BENCH_WB + x] != b[y * BENCH_WB + x]) {
+                row = 1;
+                if (x * 8 < d->Xstart) d->Xstart = x * 8;
+                if (x * 8 + 8 > d->Xend) d->Xend = x * 8 + 8;
+            }
+        }
+        if (row && in_run) {
+            d->Run[d->Runs - 1].Yend = y + 1;
+        } else if (row) {
+            if (d->Runs < FRAME_DIFF_RUNS) {
+                d->Run[d->Runs].Ystart = y;
+                d->Run[d->Runs++].Yend = y + 1;
+            } else {
+                d->Run[d->Runs - 1].Yend = y + 1;
+            }
+        }
+        in_run = row;
+        changed |= row;
+    }
+    memcpy(b, a, BENCH_SIZE);
+    if (!changed)
+        d->Xstart = d->Xend = 0;
+    return d->Runs;
+}
+
+static void change(int kind)
+{
+    int i, n, y, x;
+
+    switch (kind) {
+    case 0:     // Nothing
+        break;
+    case 1:     // One byte
+        frame[rand() % BENCH_SIZE] ^= 1 << (rand() % 8);
+        break;
+    case 2:     // A box
+        y = rand() % BENCH_HEIGHT;
+        x = rand() % BENCH_WB;
+        n = 1 + rand() % (BENCH_HEIGHT - y);
+        for (i = 0; i < n; i++)
+            memset(frame + (y + i) * BENCH_WB + x, rand(), 1 + rand() % (BENCH_WB - x));
+        break;
+    case 3:     // Scattered rows, more runs than kept
+        for (i = 0; i < 20; i++)
+            frame[(rand() % BENCH_HEIGHT) * BENCH_WB + rand() % BENCH_WB] ^= 0x80;
+        break;
+    default:    // Everything
+        for (i = 0; i < BENCH_SIZE; i++)
+            frame[i] = rand();
+        break;
+    }
+}
+
+static int same(const FRAME_DIFF *a, const FRAME_DIFF *b)
+{
+    int i;
+
+    if (a->Runs != b->Runs || a->Xstart != b->Xstart || a->Xend != b->Xend)
+        return 0;
+    for (i = 0; i < a->Runs; i++)
+        if (a->Run[i].Ystart != b->Run[i].Ystart || a->Run[i].Yend != b->Run[i].Yend)
+            return 0;
+    return 1;
+}
+
+static double best_of(int simd, int kind, int diffs)
+{
+    FRAME_DIFF d;
+    double best = 1e9;
+    int run, n;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+        double t = 0;
+        for (n = 0; n < diffs; n++) {
+            double t0;
+            memcpy(prev, copy, BENCH_SIZE);
+            memcpy(frame, copy, BENCH_SIZE);
+            if (kind == 1)      // Footer: the page count
+                memset(frame + 460 * BENCH_WB + 80, n, 10);
+            else if (kind == 2) // New page: all rows below the header
+                memset(frame + 35 * BENCH_WB, n, (BENCH_HEIGHT - 35) * BENCH_WB);
+            t0 = now_sec();
+            if (simd)
+                Frame_Diff(frame, prev, BENCH_WB, BENCH_HEIGHT, &d);
+            else
+                plain_diff(frame, prev, &d);
+            t += now_sec() - t0;
+        }
+        best = t < best ? t : best;
+    }
+    return best / diffs * 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *names[] = { "identical", "footer", "new page" };
+    int diffs = argc > 1 ? atoi(argv[1]) : BENCH_DIFFS;
+    FRAME_DIFF got, want;
+    int n, k, bad = 0;
+
+    if (diffs <= 0)
+        return 1;
+    srand(3);
+    for (n = 0; n < BENCH_SIZE; n++)
+        frame[n] = prev[n] = rand();
+    for (n = 0; n < BENCH_CHECKS; n++) {
+        change(rand() % 5);
+        memcpy(copy, prev, BENCH_SIZE);
+        plain_diff(frame, copy, &want);
+        Frame_Diff(frame, prev, BENCH_WB, BENCH_HEIGHT, &got);
+        if (!same(&got, &want) || memcmp(prev, frame, BENCH_SIZE) != 0)
+            bad++;
+    }
+    if (bad) {
+        printf("%d of %d diffs wrong\n", bad, BENCH_CHECKS);
+        return 1;
+    }
+    printf("%d diffs identical to a byte by byte comparison\n", BENCH_CHECKS);
+
+    memcpy(copy, frame, BENCH_SIZE);
+    for (k = 0; k < 3; k++)
+        printf("%-10s bytes + copy %7.1f us, Frame_Diff %6.1f us\n", names[k],
+               best_of(0, k, diffs), best_of(1, k, diffs));
+    return 0;
+}
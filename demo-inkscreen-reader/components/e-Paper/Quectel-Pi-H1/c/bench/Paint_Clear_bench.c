@@ -0,0 +1,166 @@
+/*****************************************************************************
+* | File      	:   Paint_Clear_bench.c
+* | Function    :   Cost of clearing an image and a window of it
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Paint_Clear_bench [clears]
+*   Random windows of a random 800x480 image are cleared with
+*   Paint_ClearWindows() for Scale 2, 4 and 16, every rotation and
+*   mirror; the image must equal the same window cleared pixel by pixel
+*   with Paint_SetPixel(), as Paint_ClearWindows() used to do. Then the
+*   page clear of the reader (800x440 below the header) and a whole
+*   Paint_Clear() are timed both ways, best of BENCH_RUNS runs.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_CLEARS    200
+#define BENCH_RUNS      5
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    480
+#define BENCH_HEADER    40
+#define BENCH_WINDOWS   200
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Paint_ClearWindows() as it was, one pixel at a time
+static void clear_pixels(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+{
+    UWORD X, Y;
+
+    for (Y = Ystart; Y < Yend; Y++)
+        for (X = Xstart; X < Xend; X++)
+            Paint_SetPixel(X, Y, Color);
+}
+
+// Paint_Clear() as it was for Scale 2, one byte at a time
+static void clear_bytes(UWORD Color)
+{
+    UWORD X, Y;
+
+    for (Y = 0; Y < Paint.HeightByte; Y++)
+        for (X = 0; X < Paint.WidthByte; X++)
+            Paint.Image[X + Y * Paint.WidthByte] = Color;
+}
+
+static void new_image(UBYTE *image, UWORD rotate, UBYTE mirror, UBYTE scale)
+{
+    Paint_NewImage(image, BENCH_WIDTH, BENCH_HEIGHT, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+    Paint_SetScale(scale);
+}
+
+/* Random windows cleared both ways into a random image; returns the
+   number of windows for which the images differ */
+static int check(UWORD rotate, UBYTE mirror, UBYTE scale, UBYTE *image, UBYTE *expected, size_t size)
+{
+    int n, bad = 0;
+
+    srand(rotate + mirror * 7 + scale * 31);
+    for (n = 0; n < (int)size; n++)
+        image[n] = expected[n] = (UBYTE)rand();
+    for (n = 0; n < BENCH_WINDOWS; n++) {
+        UWORD x0, y0, x1, y1, color;
+
+        new_image(image, rotate, mirror, scale);
+        x0 = rand() % Paint.Width;
+        y0 = rand() % Paint.Height;
+        x1 = x0 + rand() % (Paint.Width - x0 + 1);
+        y1 = y0 + rand() % (Paint.Height - y0 + 1);
+        color = scale == 2 ? (rand() & 1 ? WHITE : BLACK) : rand() % scale;
+        Paint_ClearWindows(x0, y0, x1, y1, color);
+
+        new_image(expected, rotate, mirror, scale);
+        clear_pixels(x0, y0, x1, y1, color);
+        bad += memcmp(image, expected, size) != 0;
+    }
+    return bad;
+}
+
+static double best_of(void (*clear)(UWORD, UWORD, UWORD, UWORD, UWORD), int clears)
+{
+    double best = 1e9;
+    int run, n;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+        double t = now_sec();
+        for (n = 0; n < clears; n++)
+            clear(0, BENCH_HEADER, BENCH_WIDTH, BENCH_HEIGHT, n & 1 ? WHITE : BLACK);
+        t = now_sec() - t;
+        best = t < best ? t : best;
+    }
+    return best / clears * 1e6;
+}
+
+static double best_of_full(void (*clear)(UWORD), int clears)
+{
+    double best = 1e9;
+    int run, n;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+        double t = now_sec();
+        for (n = 0; n < clears; n++)
+            clear(n & 1 ? WHITE : BLACK);
+        t = now_sec() - t;
+        best = t < best ? t : best;
+    }
+    return best / clears * 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    static const UWORD rotates[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+    static const UBYTE scales[] = { 2, 4, 16 };
+    int clears = argc > 1 ? atoi(argv[1]) : BENCH_CLEARS;
+    size_t size = (size_t)BENCH_WIDTH / 2 * BENCH_HEIGHT;   // Largest, at Scale 16
+    UBYTE *image = malloc(size), *expected = malloc(size);
+    int r, m, s, bad = 0;
+
+    if (!image || !expected || clears <= 0)
+        return 1;
+
+    for (s = 0; s < 3; s++)
+        for (r = 0; r < 4; r++)
+            for (m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++) {
+                int n = check(rotates[r], m, scales[s], image, expected, size);
+                if (n) {
+                    printf("%d windows differ: scale %d, rotate %d, mirror %d\n", n, scales[s], rotates[r], m);
+                    bad++;
+                }
+            }
+    if (bad)
+        return 1;
+    printf("%d windows per scale, rotation and mirror cleared identically\n", BENCH_WINDOWS);
+
+    for (s = 0; s < 3; s++)
+        for (r = 0; r < 4; r += 2) {
+            double t_pixels, t_spans;
+
+            new_image(image, rotates[r], MIRROR_NONE, scales[s]);
+            t_pixels = best_of(clear_pixels, clears);
+            t_spans = best_of(Paint_ClearWindows, clears);
+            printf("Scale %-2d ROTATE_%-3d %dx%d window: pixels %8.1f us, spans %6.1f us\n", scales[s], rotates[r],
+                   BENCH_WIDTH, BENCH_HEIGHT - BENCH_HEADER, t_pixels, t_spans);
+        }
+
+    new_image(image, ROTATE_180, MIRROR_NONE, 2);
+    printf("Paint_Clear Scale 2: bytes %6.1f us, memset %6.1f us\n",
+           best_of_full(clear_bytes, clears), best_of_full(Paint_Clear, clears));
+
+    free(image);
+    free(expected);
+    return 0;
+}
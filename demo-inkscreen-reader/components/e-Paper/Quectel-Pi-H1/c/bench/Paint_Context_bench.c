@@ -0,0 +1,179 @@
+/*****************************************************************************
+* | File      	:   Paint_Context_bench.c
+* | Function    :   Pages drawn at once into painter contexts, one per thread
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Paint_Context_bench [pages] [threads]
+*   Reader pages (header, rules, 26 lines of Font16 text, a progress bar
+*   and the page number, drawn upright and flushed at ROTATE_180) are
+*   drawn through the global Paint one after the other. Then each of
+*   several threads draws every n-th page into its own PAINT with the
+*   _Ctx functions, all sharing one glyph atlas; every panel frame must
+*   equal the one drawn through Paint. Both ways are timed, best of
+*   BENCH_RUNS runs.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define BENCH_PAGES     64
+#define BENCH_THREADS   4
+#define BENCH_RUNS      5
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    480
+#define BENCH_BYTES     (BENCH_WIDTH / 8 * BENCH_HEIGHT)
+#define BENCH_HEADER    30      // As in the reader
+#define BENCH_FOOTER    (BENCH_HEIGHT - 30)
+
+typedef struct {
+    int First;          // Pages First, First + Step, ...
+    int Step;
+    int Pages;
+    UBYTE Image[BENCH_BYTES];
+    UBYTE *Frames;      // Pages x BENCH_BYTES
+} BENCH_THREAD;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void page_line(char *buf, size_t size, int page, int line)
+{
+    snprintf(buf, size, "%3d.%02d The quick brown fox jumps over the lazy dog, %d times.",
+             page, line, page * 31 + line);
+}
+
+// A page through the global Paint
+static void draw_global(UBYTE *image, UBYTE *frame, int page, int pages)
+{
+    char buf[96];
+    int line, y;
+
+    Paint_NewImage(image, BENCH_WIDTH, BENCH_HEIGHT, ROTATE_180, WHITE);
+    Paint_DeferRotation();
+    Paint_PrepareFont_EN(&Font16);
+    Paint_Clear(WHITE);
+    Paint_DrawString_EN(10, 8, "Book title", &Font16, WHITE, BLACK);
+    Paint_DrawLine(0, BENCH_HEADER, BENCH_WIDTH - 1, BENCH_HEADER, BLACK, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    for (line = 0, y = BENCH_HEADER + 5; y + Font16.Height <= BENCH_FOOTER; line++, y += Font16.Height + 4) {
+        page_line(buf, sizeof(buf), page, line);
+        Paint_DrawString_EN(20, y, buf, &Font16, WHITE, BLACK);
+    }
+    Paint_DrawLine(0, BENCH_FOOTER, BENCH_WIDTH - 1, BENCH_FOOTER, BLACK, DOT_PIXEL_1X1, LINE_STYLE_DOTTED);
+    Paint_DrawRectangle(20, BENCH_FOOTER + 10, 20 + 500 * (page + 1) / pages, BENCH_FOOTER + 20,
+                        BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_DrawNum(BENCH_WIDTH - 100, BENCH_FOOTER + 8, page + 1, &Font16, BLACK, WHITE);
+    Paint_FlushImage(frame);
+}
+
+// The same page into a context of its own
+static void draw_ctx(PAINT *paint, UBYTE *image, UBYTE *frame, int page, int pages)
+{
+    char buf[96];
+    int line, y;
+
+    Paint_NewImage_Ctx(paint, image, BENCH_WIDTH, BENCH_HEIGHT, ROTATE_180, WHITE);
+    Paint_DeferRotation_Ctx(paint);
+    Paint_PrepareFont_EN_Ctx(paint, &Font16);
+    Paint_Clear_Ctx(paint, WHITE);
+    Paint_DrawString_EN_Ctx(paint, 10, 8, "Book title", &Font16, WHITE, BLACK);
+    Paint_DrawLine_Ctx(paint, 0, BENCH_HEADER, BENCH_WIDTH - 1, BENCH_HEADER, BLACK, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    for (line = 0, y = BENCH_HEADER + 5; y + Font16.Height <= BENCH_FOOTER; line++, y += Font16.Height + 4) {
+        page_line(buf, sizeof(buf), page, line);
+        Paint_DrawString_EN_Ctx(paint, 20, y, buf, &Font16, WHITE, BLACK);
+    }
+    Paint_DrawLine_Ctx(paint, 0, BENCH_FOOTER, BENCH_WIDTH - 1, BENCH_FOOTER, BLACK, DOT_PIXEL_1X1, LINE_STYLE_DOTTED);
+    Paint_DrawRectangle_Ctx(paint, 20, BENCH_FOOTER + 10, 20 + 500 * (page + 1) / pages, BENCH_FOOTER + 20,
+                            BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_DrawNum_Ctx(paint, BENCH_WIDTH - 100, BENCH_FOOTER + 8, page + 1, &Font16, BLACK, WHITE);
+    Paint_FlushImage_Ctx(paint, frame);
+}
+
+static void *draw_pages(void *arg)
+{
+    BENCH_THREAD *t = arg;
+    PAINT paint;
+    int page;
+
+    for (page = t->First; page < t->Pages; page += t->Step)
+        draw_ctx(&paint, t->Image, t->Frames + (size_t)page * BENCH_BYTES, page, t->Pages);
+    return NULL;
+}
+
+// All pages drawn by threads contexts; returns the time taken
+static double draw_threads(BENCH_THREAD *threads, int count)
+{
+    pthread_t id[BENCH_THREADS];
+    double t0 = now_sec();
+    int i;
+
+    for (i = 0; i < count; i++)
+        pthread_create(&id[i], NULL, draw_pages, &threads[i]);
+    for (i = 0; i < count; i++)
+        pthread_join(id[i], NULL);
+    return now_sec() - t0;
+}
+
+int main(int argc, char **argv)
+{
+    int pages = argc > 1 ? atoi(argv[1]) : BENCH_PAGES;
+    int count = argc > 2 ? atoi(argv[2]) : BENCH_THREADS;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    UBYTE *expected, *frames;
+    static UBYTE image[BENCH_BYTES];
+    static BENCH_THREAD threads[BENCH_THREADS];
+    double t_global = 1e9, t_ctx = 1e9, t;
+    int run, page, i, bad = 0;
+
+    if (pages <= 0 || count <= 0 || count > BENCH_THREADS)
+        return 1;
+    expected = malloc((size_t)pages * BENCH_BYTES);
+    frames = malloc((size_t)pages * BENCH_BYTES);
+    if (!expected || !frames)
+        return 1;
+    for (i = 0; i < count; i++) {
+        threads[i].First = i;
+        threads[i].Step = count;
+        threads[i].Pages = pages;
+        threads[i].Frames = frames;
+    }
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+        t = now_sec();
+        for (page = 0; page < pages; page++)
+            draw_global(image, expected + (size_t)page * BENCH_BYTES, page, pages);
+        t = now_sec() - t;
+        t_global = t < t_global ? t : t_global;
+
+        memset(frames, 0, (size_t)pages * BENCH_BYTES);
+        t = draw_threads(threads, count);
+        t_ctx = t < t_ctx ? t : t_ctx;
+        for (page = 0; page < pages; page++)
+            bad += memcmp(frames + (size_t)page * BENCH_BYTES, expected + (size_t)page * BENCH_BYTES,
+                          BENCH_BYTES) != 0;
+    }
+    if (bad) {
+        printf("%d pages drawn in contexts differ from Paint\n", bad);
+        return 1;
+    }
+    printf("%d pages, %d runs: every context frame identical to Paint\n", pages, BENCH_RUNS);
+    printf("Paint, one page after another %6.3f ms/page\n", t_global / pages * 1e3);
+    printf("%d threads, a context each     %6.3f ms/page  %.1fx  (%ld CPUs)\n", count,
+           t_ctx / pages * 1e3, t_global / t_ctx, cpus);
+
+    free(expected);
+    free(frames);
+    return 0;
+}
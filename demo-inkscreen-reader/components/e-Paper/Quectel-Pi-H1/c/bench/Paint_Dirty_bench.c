@@ -0,0 +1,188 @@
+/*****************************************************************************
+* | File      	:   Paint_Dirty_bench.c
+* | Function    :   Panel bytes sent per refresh with dirty boxes
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Paint_Dirty_bench
+*   Random points, lines, rectangles, clears and strings are drawn into
+*   an 800x480 image at every rotation and mirror, drawn directly and
+*   upright (Paint_DeferRotation()); every byte of the panel frame that
+*   changed must lie in a box from Paint_GetDirty(). Then page turns
+*   and a page count update are drawn as the reader does, clearing only
+*   the text rows and footer of the page before, and the bytes of their
+*   bounding box are set against a full frame.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    480
+#define BENCH_ROUNDS    50
+#define BENCH_HEADER    30      // As in the reader
+#define BENCH_FOOTER    (BENCH_HEIGHT - 30)
+
+static UBYTE image[BENCH_WIDTH / 8 * BENCH_HEIGHT];
+static UBYTE before[BENCH_WIDTH / 8 * BENCH_HEIGHT];
+static UBYTE after[BENCH_WIDTH / 8 * BENCH_HEIGHT];
+
+static void frame(UBYTE *out)
+{
+    if (Paint.Deferred)
+        Paint_FlushImage(out);
+    else
+        memcpy(out, image, sizeof(image));
+}
+
+static void draw_random(void)
+{
+    UWORD x0 = rand() % Paint.Width, y0 = rand() % Paint.Height;
+    UWORD x1 = rand() % Paint.Width, y1 = rand() % Paint.Height;
+    UWORD color = rand() & 1 ? WHITE : BLACK;
+
+    switch (rand() % 6) {
+    case 0:
+        Paint_SetPixel(x0, y0, color);
+        break;
+    case 1:
+        Paint_DrawLine(x0, y0, x1, y1, color, 1 + rand() % 3, rand() % 2);
+        break;
+    case 2:
+        Paint_DrawRectangle(x0, y0, x1, y1, color, 1 + rand() % 3, rand() % 2);
+        break;
+    case 3:
+        Paint_ClearWindows(x0, y0, x1, y1, color);
+        break;
+    case 4:
+        Paint_DrawString_EN(x0, y0, "Dirty", &Font16, color, rand() & 1 ? FONT_BACKGROUND : BLACK);
+        break;
+    default:
+        Paint_DrawCircle(x0, y0, rand() % 40, color, DOT_PIXEL_1X1, rand() % 2);
+        break;
+    }
+}
+
+/* Bytes of the frame that changed outside the boxes */
+static int uncovered(const PAINT_RECT *rects, int n)
+{
+    int x, y, i, bad = 0;
+
+    for (y = 0; y < BENCH_HEIGHT; y++)
+        for (x = 0; x < BENCH_WIDTH / 8; x++) {
+            if (before[y * (BENCH_WIDTH / 8) + x] == after[y * (BENCH_WIDTH / 8) + x])
+                continue;
+            for (i = 0; i < n; i++)
+                if (x * 8 >= rects[i].Xstart && x * 8 + 8 <= rects[i].Xend &&
+                    y >= rects[i].Ystart && y < rects[i].Yend)
+                    break;
+            bad += i == n;
+        }
+    return bad;
+}
+
+static int check(UWORD rotate, UBYTE mirror, int deferred)
+{
+    PAINT_RECT rects[PAINT_DIRTY_MAX], box;
+    int round, n, bad = 0;
+
+    Paint_NewImage(image, BENCH_WIDTH, BENCH_HEIGHT, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+    if (deferred)
+        Paint_DeferRotation();
+    srand(rotate + mirror * 7 + deferred * 31);
+    Paint_Clear(WHITE);
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        int shapes = 1 + rand() % 8, i;
+
+        frame(before);
+        Paint_ClearDirty();
+        for (i = 0; i < shapes; i++)
+            draw_random();
+        frame(after);
+        n = Paint_GetDirty(rects, PAINT_DIRTY_MAX);
+        bad += uncovered(rects, n) != 0;
+        n = Paint_GetDirty(&box, 1);
+        bad += uncovered(&box, n) != 0;
+    }
+    return bad;
+}
+
+static void report(const char *name)
+{
+    PAINT_RECT box;
+    long bytes = 0;
+
+    if (Paint_GetDirty(&box, 1))
+        bytes = (long)(box.Xend - box.Xstart) / 8 * (box.Yend - box.Ystart);
+    printf("%-28s %3dx%-3d at (%3d,%3d)  %6ld SPI bytes  %3.0f%% of a full frame\n", name,
+           box.Xend - box.Xstart, box.Yend - box.Ystart, box.Xstart, box.Ystart,
+           bytes, 100.0 * bytes / sizeof(image));
+    Paint_ClearDirty();
+}
+
+// Lines of text down to y_end, as the reader lays out a page; returns the end of the last one
+static int draw_text(int y_end)
+{
+    int y;
+
+    for (y = BENCH_HEADER + 5; y + Font16.Height <= y_end; y += Font16.Height + 4)
+        Paint_DrawString_EN(20, y, "The quick brown fox jumps over the lazy dog, again and again.",
+                            &Font16, WHITE, BLACK);
+    return y;
+}
+
+/* A page turn as draw_page() does it: the text rows down to *text_end and the footer of the
+   page before are cleared, then the new page down to y_end is drawn */
+static void turn_page(int *text_end, int y_end, const char *footer)
+{
+    Paint_ClearWindows(0, BENCH_HEADER + 5, BENCH_WIDTH, *text_end, BLACK);
+    Paint_ClearWindows(BENCH_WIDTH - 150, BENCH_FOOTER + 5, BENCH_WIDTH - 10, BENCH_FOOTER + 5 + Font16.Height, BLACK);
+    *text_end = draw_text(y_end);
+    Paint_DrawString_EN(BENCH_WIDTH - 150, BENCH_FOOTER + 5, footer, &Font16, BLACK, WHITE);
+}
+
+int main(void)
+{
+    static const UWORD rotates[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+    int r, m, d, bad = 0, text_end;
+
+    for (d = 0; d < 2; d++)
+        for (r = 0; r < 4; r++)
+            for (m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++) {
+                int n = check(rotates[r], m, d);
+                if (n) {
+                    printf("%d rounds with changes outside the boxes: rotate %d, mirror %d%s\n",
+                           n, rotates[r], m, d ? ", deferred" : "");
+                    bad++;
+                }
+            }
+    if (bad)
+        return 1;
+    printf("Every changed byte inside the dirty boxes, %d rounds per rotation and mirror\n", BENCH_ROUNDS);
+
+    // The reader: ROTATE_180 drawn upright
+    Paint_NewImage(image, BENCH_WIDTH, BENCH_HEIGHT, ROTATE_180, WHITE);
+    Paint_DeferRotation();
+    Paint_ClearDirty();
+    Paint_ClearWindows(0, BENCH_HEADER + 5, BENCH_WIDTH, BENCH_HEIGHT, BLACK);
+    text_end = draw_text(BENCH_FOOTER);
+    Paint_DrawString_EN(BENCH_WIDTH - 150, BENCH_FOOTER + 5, "Page 11 / 340", &Font16, BLACK, WHITE);
+    report("First page, all cleared");
+
+    turn_page(&text_end, BENCH_FOOTER, "Page 12 / 340");
+    report("Page turn");
+    turn_page(&text_end, BENCH_HEADER + 5 + 6 * (Font16.Height + 4), "Page 13 / 340");
+    report("Page turn to 6 lines");
+    turn_page(&text_end, BENCH_HEADER + 5 + 4 * (Font16.Height + 4), "Page 14 / 340");
+    report("6 lines to 4 lines");
+
+    Paint_DrawString_EN(BENCH_WIDTH - 150, BENCH_FOOTER + 5, "Page 12 / 341", &Font16, BLACK, WHITE);
+    report("Footer only");
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*****************************************************************************
+* | File      	:   Paint_Flush_bench.c
+* | Function    :   Cost of turning an upright frame into panel order
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Paint_Flush_bench [frames]
+*   A random 800x480 frame is drawn upright (Paint_DeferRotation()) and
+*   flushed for every rotation and mirror; the result must equal the
+*   frame drawn pixel by pixel into an image with that rotation and
+*   mirror. Odd sizes, which take the pixel path, are checked too. Then
+*   the flush of each rotation is timed, best of BENCH_RUNS runs.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_FRAMES    1000
+#define BENCH_RUNS      5
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    480
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t frame_size(int width, int height)
+{
+    return (size_t)((width + 7) / 8) * height;
+}
+
+/* Random pixels drawn upright into a deferred image, then each through
+   Paint_SetPixel() into a turned one; returns 0 if the frames agree */
+static int check(int width, int height, UWORD rotate, UBYTE mirror, UBYTE *upright, UBYTE *frame, UBYTE *expected)
+{
+    UWORD w, h, x, y, wb;
+
+    Paint_NewImage(upright, width, height, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+    if (Paint_DeferRotation() != 0)
+        return -1;
+    Paint_Clear(BLACK);
+    w = Paint.Width;
+    h = Paint.Height;
+    wb = Paint.WidthByte;
+    srand(width * 7 + rotate + mirror);
+    for (y = 0; y < h; y++)
+        for (x = 0; x < w; x++)
+            if (rand() & 1)
+                Paint_SetPixel(x, y, WHITE);
+    memset(frame, 0x5A, frame_size(width, height));
+    Paint_FlushImage(frame);
+
+    Paint_NewImage(expected, width, height, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+    Paint_Clear(BLACK);
+    for (y = 0; y < h; y++)
+        for (x = 0; x < w; x++)
+            if (upright[y * wb + x / 8] & (0x80 >> (x % 8)))
+                Paint_SetPixel(x, y, WHITE);
+    return memcmp(frame, expected, frame_size(width, height)) != 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const UWORD rotates[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+    static const int sizes[][2] = { { BENCH_WIDTH, BENCH_HEIGHT }, { 122, 250 }, { 64, 40 } };
+    int frames = argc > 1 ? atoi(argv[1]) : BENCH_FRAMES;
+    size_t size = frame_size(BENCH_WIDTH, BENCH_HEIGHT);
+    UBYTE *upright = malloc(size), *frame = malloc(size), *expected = malloc(size);
+    int r, m, s, n, run, bad = 0;
+
+    if (!upright || !frame || !expected || frames <= 0)
+        return 1;
+
+    for (s = 0; s < 3; s++)
+        for (r = 0; r < 4; r++)
+            for (m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++)
+                if (check(sizes[s][0], sizes[s][1], rotates[r], m, upright, frame, expected) != 0) {
+                    printf("Frames differ: %dx%d, rotate %d, mirror %d\n", sizes[s][0], sizes[s][1], rotates[r], m);
+                    bad++;
+                }
+    if (bad)
+        return 1;
+    printf("%dx%d, %d frames, flushed frames identical\n", BENCH_WIDTH, BENCH_HEIGHT, frames);
+
+    for (n = 0; n < (int)size; n++)
+        upright[n] = (UBYTE)rand();
+    for (r = 0; r < 4; r++) {
+        double best = 1e9;
+
+        Paint_NewImage(upright, BENCH_WIDTH, BENCH_HEIGHT, rotates[r], WHITE);
+        Paint_DeferRotation();
+        for (run = 0; run < BENCH_RUNS; run++) {
+            double t = now_sec();
+            for (n = 0; n < frames; n++)
+                Paint_FlushImage(frame);
+            t = now_sec() - t;
+            best = t < best ? t : best;
+        }
+        printf("ROTATE_%-3d flush %7.1f us/frame\n", rotates[r], best / frames * 1e6);
+    }
+
+    free(upright);
+    free(frame);
+    free(expected);
+    return 0;
+}
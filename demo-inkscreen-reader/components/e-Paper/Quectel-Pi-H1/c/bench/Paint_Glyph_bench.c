@@ -0,0 +1,248 @@
+/*****************************************************************************
+* | File      	:   Paint_Glyph_bench.c
+* | Function    :   Cost of drawing a full page of text, per pixel and blitted
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Paint_Glyph_bench [book] [pages]
+*   The printable text of the book (default books/test.txt) fills every
+*   cell of an 800x480 image in Font16, 72 x 30 characters, or 43 x 50 at
+*   90 degrees, and the page is drawn as the reader does: with a copy of
+*   the Paint_SetPixel() loop Paint_DrawChar() used to run, through the
+*   row blitter, and from a glyph atlas (Paint_PrepareFont_EN()). Each
+*   way is timed on its own, without clearing the image, and the best of
+*   BENCH_RUNS runs is kept. Before timing, every way is drawn for every
+*   rotation and mirror, with and without a background color, and with
+*   glyphs cut by the image edges; the images must be identical. CN glyphs
+*   of Font12CN are checked the same way.
+*----------------
+* |	This version:   V1.1
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_BOOK      "../../../../books/test.txt"
+#define BENCH_PAGES     200
+#define BENCH_RUNS      5
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    480
+#define BENCH_CHARS     (BENCH_WIDTH / 11 * (BENCH_WIDTH / 16))    // Font16 is 11 x 16, any rotation
+#define BENCH_BYTES     (BENCH_WIDTH / 8 * BENCH_HEIGHT)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A glyph bit by bit through Paint_SetPixel(), as Paint_DrawChar() used to
+static void reference_glyph(int x, int y, const unsigned char *ptr, int width, int height,
+                            UWORD fg, UWORD bg)
+{
+    int i, j, stride = (width + 7) / 8;
+
+    for (j = 0; j < height; j++, ptr += stride) {
+        for (i = 0; i < width; i++) {
+            if (ptr[i / 8] & (0x80 >> (i % 8)))
+                Paint_SetPixel(x + i, y + j, fg);
+            else if (FONT_BACKGROUND != bg)
+                Paint_SetPixel(x + i, y + j, bg);
+        }
+    }
+}
+
+static const unsigned char *en_bitmap(sFONT *font, UWORD glyph)
+{
+    return &font->table[(glyph - ' ') * font->Height * ((font->Width + 7) / 8)];
+}
+
+// Printable text of the book, white space squeezed
+static int load_page(const char *path, UWORD *page)
+{
+    FILE *fp = fopen(path, "rb");
+    int c, n = 0, space = 1;
+
+    if (!fp)
+        return -1;
+    while (n < BENCH_CHARS && (c = fgetc(fp)) != EOF) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            if (!space)
+                page[n++] = ' ';
+            space = 1;
+        } else if (c > ' ' && c <= '~') {
+            page[n++] = (UWORD)c;
+            space = 0;
+        }
+    }
+    fclose(fp);
+    if (n == 0)
+        return -1;
+    for (c = n; c < BENCH_CHARS; c++)   // Short books repeat
+        page[c] = page[c % n];
+    return 0;
+}
+
+// One glyph per cell of the image at its current rotation, returns the number of glyphs
+static int draw_page_reference(const UWORD *page, UWORD fg, UWORD bg)
+{
+    int cols = Paint.Width / Font16.Width, rows = Paint.Height / Font16.Height;
+    int row, col;
+
+    for (row = 0; row < rows; row++)
+        for (col = 0; col < cols; col++)
+            reference_glyph(col * Font16.Width, row * Font16.Height, en_bitmap(&Font16, page[row * cols + col]),
+                            Font16.Width, Font16.Height, fg, bg);
+    return rows * cols;
+}
+
+static int draw_page(const UWORD *page, UWORD fg, UWORD bg)
+{
+    int cols = Paint.Width / Font16.Width, rows = Paint.Height / Font16.Height;
+    int row;
+
+    for (row = 0; row < rows; row++)
+        Paint_DrawGlyphs_EN(0, row * Font16.Height, page + row * cols, cols, &Font16, fg, bg);
+    return rows * cols;
+}
+
+static void new_image(UBYTE *image, UWORD rotate, UBYTE mirror, int atlas)
+{
+    Paint_ReleaseFonts();
+    Paint_NewImage(image, BENCH_WIDTH, BENCH_HEIGHT, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+    if (atlas && (Paint_PrepareFont_EN(&Font16) != 0 || Paint_PrepareFont_CN(&Font12CN) != 0)) {
+        printf("Out of memory\n");
+        exit(1);
+    }
+    Paint_Clear(0x5A);
+}
+
+// Reference and drawn images for every rotation and mirror, returns the number of mismatches
+static int check(const UWORD *page, UBYTE *a, UBYTE *b)
+{
+    static const UWORD rotates[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+    static const UWORD colors[][2] = { { WHITE, BLACK }, { BLACK, WHITE } };
+    unsigned char buf[FONT_CN_GLYPH_MAX];
+    int r, m, c, k, atlas, bad = 0;
+
+    for (atlas = 0; atlas < 2; atlas++) {
+        for (r = 0; r < 4; r++) {
+            for (m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++) {
+                for (c = 0; c < 2; c++) {
+                    UWORD fg = colors[c][0], bg = colors[c][1];
+
+                    new_image(a, rotates[r], m, 0);
+                    draw_page_reference(page, fg, bg);
+                    new_image(b, rotates[r], m, atlas);
+                    draw_page(page, fg, bg);
+                    if (memcmp(a, b, BENCH_BYTES) != 0) {
+                        printf("EN page differs: atlas %d, rotate %d, mirror %d, colors %d\n", atlas, rotates[r], m, c);
+                        bad++;
+                    }
+
+                    // CN glyphs at odd offsets
+                    new_image(a, rotates[r], m, 0);
+                    for (k = 0; k < Font12CN.size * 8; k++)
+                        reference_glyph(k * 37 % (Paint.Width - Font12CN.Width), k * 53 % (Paint.Height - Font12CN.Height),
+                                        Font_CN_Bitmap(&Font12CN, k % Font12CN.size, buf),
+                                        Font12CN.Width, Font12CN.Height, fg, bg);
+                    new_image(b, rotates[r], m, atlas);
+                    for (k = 0; k < Font12CN.size * 8; k++) {
+                        UWORD glyph = GLYPH_CN + k % Font12CN.size;
+                        Paint_DrawGlyphs_CN(k * 37 % (Paint.Width - Font12CN.Width), k * 53 % (Paint.Height - Font12CN.Height),
+                                            &glyph, 1, &Font12CN, fg, bg);
+                    }
+                    if (memcmp(a, b, BENCH_BYTES) != 0) {
+                        printf("CN glyphs differ: atlas %d, rotate %d, mirror %d, colors %d\n", atlas, rotates[r], m, c);
+                        bad++;
+                    }
+                }
+            }
+        }
+
+        // Glyphs cut by the right and bottom edges, as the reader draws them
+        new_image(a, ROTATE_180, MIRROR_NONE, 0);
+        for (k = 0; k < Font16.Width + 2; k++) {
+            reference_glyph(BENCH_WIDTH - k, k * Font16.Height, en_bitmap(&Font16, '#'), Font16.Width, Font16.Height, WHITE, BLACK);
+            reference_glyph(k * Font16.Width, BENCH_HEIGHT - k, en_bitmap(&Font16, '#'), Font16.Width, Font16.Height, WHITE, BLACK);
+            reference_glyph(k * Font16.Width, BENCH_HEIGHT - k - Font16.Height, Font_CN_Bitmap(&Font12CN, k % Font12CN.size, buf),
+                            Font12CN.Width, Font12CN.Height, WHITE, BLACK);
+        }
+        new_image(b, ROTATE_180, MIRROR_NONE, atlas);
+        for (k = 0; k < Font16.Width + 2; k++) {
+            UWORD glyph = GLYPH_CN + k % Font12CN.size;
+            Paint_DrawChar(BENCH_WIDTH - k, k * Font16.Height, '#', &Font16, WHITE, BLACK);
+            Paint_DrawChar(k * Font16.Width, BENCH_HEIGHT - k, '#', &Font16, WHITE, BLACK);
+            Paint_DrawGlyphs_CN(k * Font16.Width, BENCH_HEIGHT - k - Font16.Height, &glyph, 1, &Font12CN, WHITE, BLACK);
+        }
+        if (memcmp(a, b, BENCH_BYTES) != 0) {
+            printf("Clipped glyphs differ: atlas %d\n", atlas);
+            bad++;
+        }
+    }
+    Paint_ReleaseFonts();
+    return bad;
+}
+
+static double time_pages(int (*draw)(const UWORD *, UWORD, UWORD), const UWORD *page, int pages, int *glyphs)
+{
+    double best = 1e9;
+    int run, n;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+        double t = now_sec();
+        for (n = 0; n < pages; n++)
+            *glyphs = draw(page, WHITE, BLACK);
+        t = now_sec() - t;
+        best = t < best ? t : best;
+    }
+    return best / pages * 1e3;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : BENCH_BOOK;
+    int pages = argc > 2 ? atoi(argv[2]) : BENCH_PAGES;
+    static UWORD page[BENCH_CHARS];
+    UBYTE *a = malloc(BENCH_BYTES), *b = malloc(BENCH_BYTES);
+    double t_ref, t_blit, t_atlas;
+    int glyphs;
+
+    if (!a || !b || pages <= 0)
+        return 1;
+    if (load_page(path, page) != 0) {
+        printf("Cannot read %s\n", path);
+        return 1;
+    }
+    if (check(page, a, b) != 0)
+        return 1;
+    printf("%d pages, images identical\n", pages);
+
+    // The reader's setup: ROTATE_180, glyphs drawn with a background
+    new_image(a, ROTATE_180, MIRROR_NONE, 0);
+    t_ref = time_pages(draw_page_reference, page, pages, &glyphs);
+    t_blit = time_pages(draw_page, page, pages, &glyphs);
+    new_image(a, ROTATE_180, MIRROR_NONE, 1);
+    t_atlas = time_pages(draw_page, page, pages, &glyphs);
+    printf("ROTATE_180 %4d glyphs  per pixel %6.3f ms/page  blit %6.3f ms/page %5.1fx  atlas %6.3f ms/page %5.1fx\n",
+           glyphs, t_ref, t_blit, t_ref / t_blit, t_atlas, t_ref / t_atlas);
+
+    new_image(a, ROTATE_90, MIRROR_NONE, 0);
+    t_ref = time_pages(draw_page_reference, page, pages, &glyphs);
+    t_blit = time_pages(draw_page, page, pages, &glyphs);
+    new_image(a, ROTATE_90, MIRROR_NONE, 1);
+    t_atlas = time_pages(draw_page, page, pages, &glyphs);
+    printf("ROTATE_90  %4d glyphs  per pixel %6.3f ms/page  blit %6.3f ms/page %5.1fx  atlas %6.3f ms/page %5.1fx\n",
+           glyphs, t_ref, t_blit, t_ref / t_blit, t_atlas, t_ref / t_atlas);
+
+    Paint_ReleaseFonts();
+    free(a);
+    free(b);
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*****************************************************************************
+* | File      	:   Paint_Line_bench.c
+* | Function    :   Cost of drawing lines and rectangles
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Paint_Line_bench [shapes]
+*   Random lines (horizontal, vertical and slanted, solid and dotted, 1 to
+*   8 px wide) and rectangles (empty and filled) are drawn into a random
+*   800x480 image for Scale 2, 4 and 16, every rotation and mirror; the
+*   image must equal the same shapes drawn point by point, as
+*   Paint_DrawLine() and Paint_DrawRectangle() used to do. Then a header
+*   rule, a dotted rule, a 3 px frame and a filled progress bar are timed
+*   both ways, best of BENCH_RUNS runs.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SHAPES    2000
+#define BENCH_RUNS      5
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    480
+#define BENCH_CHECKS    100
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Paint_DrawPoint() as it was, one pixel at a time
+static void ref_point(UWORD Xpoint, UWORD Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel)
+{
+    int16_t XDir_Num, YDir_Num;
+
+    for (XDir_Num = 0; XDir_Num < 2 * Dot_Pixel - 1; XDir_Num++) {
+        for (YDir_Num = 0; YDir_Num < 2 * Dot_Pixel - 1; YDir_Num++) {
+            if (Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
+                break;
+            Paint_SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
+        }
+    }
+}
+
+// Paint_DrawLine() as it was, a point per step
+static void ref_line(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                     UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    UWORD Xpoint = Xstart, Ypoint = Ystart;
+    int dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
+    int dy = (int)Yend - (int)Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
+    int XAddway = Xstart < Xend ? 1 : -1;
+    int YAddway = Ystart < Yend ? 1 : -1;
+    int Esp = dx + dy;
+    char Dotted_Len = 0;
+
+    for (;;) {
+        Dotted_Len++;
+        if (Line_Style == LINE_STYLE_DOTTED && Dotted_Len % 3 == 0) {
+            ref_point(Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width);
+            Dotted_Len = 0;
+        } else {
+            ref_point(Xpoint, Ypoint, Color, Line_width);
+        }
+        if (2 * Esp >= dy) {
+            if (Xpoint == Xend)
+                break;
+            Esp += dy;
+            Xpoint += XAddway;
+        }
+        if (2 * Esp <= dx) {
+            if (Ypoint == Yend)
+                break;
+            Esp += dx;
+            Ypoint += YAddway;
+        }
+    }
+}
+
+// Paint_DrawRectangle() as it was, a line per row when filled
+static void ref_rectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                          UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    UWORD Ypoint;
+
+    if (Draw_Fill) {
+        for (Ypoint = Ystart; Ypoint < Yend; Ypoint++)
+            ref_line(Xstart, Ypoint, Xend, Ypoint, Color, Line_width, LINE_STYLE_SOLID);
+    } else {
+        ref_line(Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        ref_line(Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        ref_line(Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        ref_line(Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+    }
+}
+
+typedef struct {
+    UWORD X0, Y0, X1, Y1, Color;
+    DOT_PIXEL Width;
+    int Kind;       // 0 line, 1 dotted line, 2 empty and 3 filled rectangle
+} SHAPE;
+
+/* A random shape; its squares end inside the image, where the old code
+   wrote past the right edge the new one clips */
+static SHAPE random_shape(UBYTE scale)
+{
+    SHAPE s;
+    int w = 1 + rand() % 8, xmax = Paint.Width - w, ymax = Paint.Height - w;
+
+    s.Width = (DOT_PIXEL)w;
+    s.Kind = rand() % 4;
+    // Paint_SetPixel() spills IMAGE_BACKGROUND (0xFF) into the next pixel at
+    // Scale 16, so the old dotted lines are no reference there
+    if (scale == 16 && s.Kind == 1)
+        s.Kind = 0;
+    s.X0 = rand() % (xmax + 1);
+    s.Y0 = rand() % (ymax + 1);
+    s.X1 = rand() % (xmax + 1);
+    s.Y1 = rand() % (ymax + 1);
+    if (s.Kind < 2) {
+        int axis = rand() % 3;     // Horizontal, vertical or slanted
+        if (axis == 0)
+            s.Y1 = s.Y0;
+        else if (axis == 1)
+            s.X1 = s.X0;
+    }
+    s.Color = scale == 2 ? (rand() & 1 ? WHITE : BLACK) : rand() % scale;
+    return s;
+}
+
+static void draw_shape(const SHAPE *s, int ref)
+{
+    if (s->Kind < 2) {
+        LINE_STYLE style = s->Kind ? LINE_STYLE_DOTTED : LINE_STYLE_SOLID;
+        if (ref)
+            ref_line(s->X0, s->Y0, s->X1, s->Y1, s->Color, s->Width, style);
+        else
+            Paint_DrawLine(s->X0, s->Y0, s->X1, s->Y1, s->Color, s->Width, style);
+    } else {
+        DRAW_FILL fill = s->Kind == 3 ? DRAW_FILL_FULL : DRAW_FILL_EMPTY;
+        if (ref)
+            ref_rectangle(s->X0, s->Y0, s->X1, s->Y1, s->Color, s->Width, fill);
+        else
+            Paint_DrawRectangle(s->X0, s->Y0, s->X1, s->Y1, s->Color, s->Width, fill);
+    }
+}
+
+static void new_image(UBYTE *image, UWORD rotate, UBYTE mirror, UBYTE scale)
+{
+    Paint_NewImage(image, BENCH_WIDTH, BENCH_HEIGHT, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+    Paint_SetScale(scale);
+}
+
+/* Random shapes drawn both ways into a random image; returns the number
+   of shapes after which the images differ */
+static int check(UWORD rotate, UBYTE mirror, UBYTE scale, UBYTE *image, UBYTE *expected, size_t size)
+{
+    int n, bad = 0;
+
+    srand(rotate + mirror * 7 + scale * 31);
+    for (n = 0; n < (int)size; n++)
+        image[n] = expected[n] = (UBYTE)rand();
+    for (n = 0; n < BENCH_CHECKS; n++) {
+        SHAPE s;
+
+        new_image(image, rotate, mirror, scale);
+        s = random_shape(scale);
+        draw_shape(&s, 0);
+        new_image(expected, rotate, mirror, scale);
+        draw_shape(&s, 1);
+        if (memcmp(image, expected, size) != 0) {
+            memcpy(expected, image, size);
+            bad++;
+        }
+    }
+    return bad;
+}
+
+// The chrome of a reader page
+static void draw_chrome(int ref)
+{
+    static const SHAPE shapes[] = {
+        { 10, 40, 790, 40, BLACK, DOT_PIXEL_1X1, 0 },       // Header rule
+        { 10, 450, 790, 450, BLACK, DOT_PIXEL_1X1, 1 },     // Dotted footer rule
+        { 5, 5, 794, 474, BLACK, DOT_PIXEL_3X3, 2 },        // Frame
+        { 100, 460, 700, 470, BLACK, DOT_PIXEL_1X1, 3 },    // Progress bar
+    };
+    int i;
+
+    for (i = 0; i < (int)(sizeof(shapes) / sizeof(shapes[0])); i++)
+        draw_shape(&shapes[i], ref);
+}
+
+static double best_of(int ref, int shapes)
+{
+    double best = 1e9;
+    int run, n;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+        double t = now_sec();
+        for (n = 0; n < shapes; n++)
+            draw_chrome(ref);
+        t = now_sec() - t;
+        best = t < best ? t : best;
+    }
+    return best / shapes * 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    static const UWORD rotates[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+    static const UBYTE scales[] = { 2, 4, 16 };
+    int shapes = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    size_t size = (size_t)BENCH_WIDTH / 2 * BENCH_HEIGHT;   // Largest, at Scale 16
+    UBYTE *image = malloc(size), *expected = malloc(size);
+    int r, m, s, bad = 0;
+
+    if (!image || !expected || shapes <= 0)
+        return 1;
+
+    for (s = 0; s < 3; s++)
+        for (r = 0; r < 4; r++)
+            for (m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++) {
+                int n = check(rotates[r], m, scales[s], image, expected, size);
+                if (n) {
+                    printf("%d shapes differ: scale %d, rotate %d, mirror %d\n", n, scales[s], rotates[r], m);
+                    bad++;
+                }
+            }
+    if (bad)
+        return 1;
+    printf("%d shapes per scale, rotation and mirror drawn identically\n", BENCH_CHECKS);
+
+    new_image(image, ROTATE_180, MIRROR_NONE, 2);
+    Paint_Clear(WHITE);
+    printf("Page chrome (2 rules, 3 px frame, progress bar): points %8.1f us, spans %6.1f us\n",
+           best_of(1, shapes / 20 + 1), best_of(0, shapes));
+
+    free(image);
+    free(expected);
+    return 0;
+}
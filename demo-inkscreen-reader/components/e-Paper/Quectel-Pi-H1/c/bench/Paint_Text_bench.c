@@ -0,0 +1,172 @@
+/*****************************************************************************
+* | File      	:   Paint_Text_bench.c
+* | Function    :   Cost of drawing a page of CN text against font size
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Paint_Text_bench [pages]
+*   CN fonts of growing size are built from the Font12CN bitmaps: the
+*   real font, then 1000 and all 8836 cells of the GB2312 grid,
+*   with the ASCII entries last as in the shipped fonts. For each font a
+*   page of 1500 characters (one in ten ASCII) is drawn with
+*   Paint_DrawString_CN() into an 800x480 image, and the character
+*   lookups alone are timed against the linear table search that
+*   Paint_DrawString_CN() used to do.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_PAGES     200
+#define BENCH_CHARS     1500
+#define BENCH_WIDTH     800
+#define BENCH_HEIGHT    480
+#define BENCH_GB2312    (94 * 94)   // Cells of the GB2312 grid
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Linear search, as Paint_DrawString_CN() did before the lookup table
+static int linear_find(const cFONT *font, unsigned char hi, unsigned char lo)
+{
+    int Num;
+
+    for (Num = 0; Num < font->size; Num++) {
+        if ((unsigned char)font->table[Num].index[0] == hi &&
+            (hi < 0x80 || (unsigned char)font->table[Num].index[1] == lo))
+            return Num;
+    }
+    return -1;
+}
+
+// A font with cn_count GB2312 cells followed by the ASCII entries of Font12CN
+static cFONT make_font(int cn_count)
+{
+    cFONT font = Font12CN;
+    CH_CN *table;
+    int n = 0, i, ascii = 0;
+
+    for (i = 0; i < Font12CN.size; i++)
+        ascii += (unsigned char)Font12CN.table[i].index[0] < 0x80;
+    table = calloc(cn_count + ascii, sizeof(CH_CN));
+    if (!table)
+        exit(1);
+
+    for (i = 0; i < cn_count; i++) {
+        char code[2] = { (char)(0xA1 + i / 94), (char)(0xA1 + i % 94) };
+        memcpy((char *)table[n].index, code, 2);
+        memcpy((char *)table[n].matrix, Font12CN.table[i % Font12CN.size].matrix, sizeof(table[n].matrix));
+        n++;
+    }
+    for (i = 0; i < Font12CN.size; i++) {
+        if ((unsigned char)Font12CN.table[i].index[0] < 0x80)
+            memcpy(&table[n++], &Font12CN.table[i], sizeof(CH_CN));
+    }
+
+    font.table = table;
+    font.size = n;
+    font.Lookup = NULL;
+    return font;
+}
+
+// A line of text made of the font's own characters
+static void make_text(const cFONT *font, char *text, int chars)
+{
+    int i, len = 0;
+
+    srand(7);
+    for (i = 0; i < chars; i++) {
+        const CH_CN *ch = &font->table[rand() % font->size];
+        if (i % 10 == 9) {
+            text[len++] = 'a' + rand() % 3;
+        } else if ((unsigned char)ch->index[0] >= 0x80) {
+            text[len++] = ch->index[0];
+            text[len++] = ch->index[1];
+        } else {
+            text[len++] = ch->index[0];
+        }
+    }
+    text[len] = 0;
+}
+
+static void bench(const char *name, cFONT *font, UBYTE *image, int pages)
+{
+    static char text[BENCH_CHARS * 2 + 1];
+    char line[BENCH_WIDTH / 16 * 2 + 1];
+    const unsigned char *p;
+    volatile int sink = 0;
+    int page, rep, reps = 200;
+    double t_linear, t_table, t_page;
+
+    make_text(font, text, BENCH_CHARS);
+
+    // Lookups alone, the old way and through the table
+    t_linear = now_sec();
+    for (rep = 0; rep < reps; rep++)
+        for (p = (const unsigned char *)text; *p; p += *p < 0x80 ? 1 : 2)
+            sink += linear_find(font, p[0], p[1]);
+    t_linear = now_sec() - t_linear;
+
+    t_table = now_sec();
+    for (rep = 0; rep < reps; rep++)
+        for (p = (const unsigned char *)text; *p; p += *p < 0x80 ? 1 : 2)
+            sink += Font_CN_Find(font, p[0], p[1]);
+    t_table = now_sec() - t_table;
+
+    // Whole pages, cut into lines that fit the image
+    Paint_NewImage(image, BENCH_WIDTH, BENCH_HEIGHT, ROTATE_180, WHITE);
+    t_page = now_sec();
+    for (page = 0; page < pages; page++) {
+        int y = 0, len = 0, width = 0;
+        Paint_Clear(WHITE);
+        for (p = (const unsigned char *)text; ; ) {
+            int bytes = *p < 0x80 ? 1 : 2;
+            int advance = *p < 0x80 ? font->ASCII_Width : font->Width;
+            if (!*p || width + advance > BENCH_WIDTH) {
+                line[len] = 0;
+                Paint_DrawString_CN(0, y, line, font, WHITE, BLACK);
+                y = (y + font->Height) % (BENCH_HEIGHT - font->Height);
+                len = width = 0;
+                if (!*p)
+                    break;
+            }
+            memcpy(line + len, p, bytes);
+            len += bytes;
+            width += advance;
+            p += bytes;
+        }
+    }
+    t_page = now_sec() - t_page;
+
+    printf("%-10s %6d glyphs  lookup: linear %8.1f ns/char, table %5.1f ns/char  page: %6.2f ms\n",
+           name, font->size, t_linear / reps / BENCH_CHARS * 1e9, t_table / reps / BENCH_CHARS * 1e9,
+           t_page / pages * 1e3);
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    int pages = argc > 1 ? atoi(argv[1]) : BENCH_PAGES;
+    UBYTE *image = malloc(BENCH_WIDTH / 8 * BENCH_HEIGHT);
+    cFONT mid = make_font(1000), full = make_font(BENCH_GB2312);
+
+    if (!image || pages <= 0)
+        return 1;
+    printf("%d characters per page, %d pages per font\n", BENCH_CHARS, pages);
+    bench("Font12CN", &Font12CN, image, pages);
+    bench("1000", &mid, image, pages);
+    bench("GB2312", &full, image, pages);
+
+    free(image);
+    return 0;
+}
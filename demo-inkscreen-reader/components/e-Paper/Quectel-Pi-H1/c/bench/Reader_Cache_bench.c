@@ -0,0 +1,218 @@
+/*****************************************************************************
+* | File      	:   Reader_Cache_bench.c
+* | Function    :   Page turns served from pages rendered ahead
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Reader_Cache_bench [turns] [ahead] [behind] [budget KB]
+*   Reader pages (white text on black below the header, as the reader
+*   draws them) and random frames must come back whole from the row by
+*   row PackBits packing; their packed size is reported. Then pages are
+*   turned mostly forward, now and then back. Each turn takes its page
+*   from a Reader_Cache or draws it on the spot, then waits
+*   BENCH_REFRESH_MS as the panel would while the worker renders the next
+*   [ahead] and the [behind] previous pages within [budget KB]. Every
+*   frame shown must equal the page drawn directly. The time from key to
+*   frame is set against drawing every page on the spot.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_Paint.h"
+#include "Reader_Cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_TURNS         100
+#define BENCH_PAGES         64
+#define BENCH_AHEAD         16
+#define BENCH_BEHIND        8
+#define BENCH_BUDGET_KB     384
+#define BENCH_REFRESH_MS    20      // A partial refresh takes far longer, this is enough for a page
+#define BENCH_PAGE_BYTES    1000    // Keys are text offsets, pages this far apart
+#define BENCH_WIDTH         800
+#define BENCH_HEIGHT        480
+#define BENCH_WB            (BENCH_WIDTH / 8)
+#define BENCH_BYTES         (BENCH_WB * BENCH_HEIGHT)
+#define BENCH_HEADER        30      // As in the reader
+#define BENCH_FOOTER        (BENCH_HEIGHT - 30)
+
+static UBYTE worker_image[BENCH_BYTES], main_image[BENCH_BYTES];
+static PAINT worker_paint, main_paint;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Glyph IDs of an ASCII string, as the reader keeps its text
+static const UWORD *glyphs(const char *s)
+{
+    static __thread UWORD ids[96];
+    int i;
+
+    for (i = 0; s[i] && i < 96; i++)
+        ids[i] = (UBYTE)s[i];
+    return ids;
+}
+
+static void draw_page(PAINT *paint, int page, UBYTE *frame)
+{
+    char buf[96];
+    int line, y;
+
+    Paint_Clear_Ctx(paint, WHITE);
+    Paint_DrawString_EN_Ctx(paint, 10, 8, "Book title", &Font16, WHITE, BLACK);
+    Paint_DrawLine_Ctx(paint, 10, BENCH_HEADER, BENCH_WIDTH - 10, BENCH_HEADER, BLACK, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    Paint_ClearWindows_Ctx(paint, 0, BENCH_HEADER + 5, BENCH_WIDTH, BENCH_HEIGHT, BLACK);
+    for (line = 0, y = BENCH_HEADER + 5; y + Font16.Height <= BENCH_FOOTER; line++, y += Font16.Height + 4) {
+        snprintf(buf, sizeof(buf), "%3d.%02d The quick brown fox jumps over the lazy dog, %d times.",
+                 page, line, page * 31 + line);
+        Paint_DrawGlyphs_EN_Ctx(paint, 20, y, glyphs(buf), strlen(buf), &Font16, WHITE, BLACK);
+    }
+    snprintf(buf, sizeof(buf), "Page %d / %d", page + 1, BENCH_PAGES);
+    Paint_DrawString_EN_Ctx(paint, BENCH_WIDTH - 10 - (int)strlen(buf) * Font16.Width, BENCH_FOOTER + 5,
+                            buf, &Font16, BLACK, WHITE);
+    Paint_ClearDirty_Ctx(paint);
+    Paint_FlushImage_Ctx(paint, frame);
+}
+
+static int render(void *arg, uint32_t key, uint8_t *frame, uint32_t *next)
+{
+    (void)arg;
+    draw_page(&worker_paint, key / BENCH_PAGE_BYTES, frame);
+    *next = key + BENCH_PAGE_BYTES;
+    return 0;
+}
+
+static void new_paint(PAINT *paint, UBYTE *image)
+{
+    Paint_NewImage_Ctx(paint, image, BENCH_WIDTH, BENCH_HEIGHT, ROTATE_180, WHITE);
+    Paint_DeferRotation_Ctx(paint);
+}
+
+// Pages to have ready around page, as the reader asks for them
+static void want_around(READER_CACHE *cache, int page, int ahead, int behind)
+{
+    uint32_t keys[READER_CACHE_SLOTS];
+    int count = 0, k;
+
+    for (k = 1; k <= ahead && page + k < BENCH_PAGES && count < READER_CACHE_SLOTS; k++)
+        keys[count++] = (page + k) * BENCH_PAGE_BYTES;
+    for (k = 1; k <= behind && page - k >= 0 && count < READER_CACHE_SLOTS; k++)
+        keys[count++] = (page - k) * BENCH_PAGE_BYTES;
+    Reader_Cache_Want(cache, keys, count);
+}
+
+// All turns, cached or not; returns the frames that differ, sets the mean time to a frame
+static int turn_pages(READER_CACHE *cache, const UBYTE *expected, int turns, int ahead, int behind,
+                      double *turn_ms)
+{
+    static UBYTE frame[BENCH_BYTES];
+    double total = 0;
+    int turn, page = 0, bad = 0;
+
+    srand(5);
+    for (turn = 0; turn < turns; turn++) {
+        uint32_t next;
+        double t0;
+
+        // Forward, one in eight back
+        if (rand() % 8 == 0)
+            page = page > 0 ? page - 1 : 0;
+        else
+            page = page + 1 < BENCH_PAGES ? page + 1 : 0;
+
+        t0 = now_sec();
+        if (!cache || !Reader_Cache_Take(cache, page * BENCH_PAGE_BYTES, frame, &next))
+            draw_page(&main_paint, page, frame);
+        total += now_sec() - t0;
+        bad += memcmp(frame, expected + (size_t)page * BENCH_BYTES, BENCH_BYTES) != 0;
+
+        usleep(BENCH_REFRESH_MS * 1000);    // The panel refreshing, the worker at work
+        if (cache)
+            want_around(cache, page, ahead, behind);
+    }
+    *turn_ms = total / turns * 1e3;
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    int turns = argc > 1 ? atoi(argv[1]) : BENCH_TURNS;
+    int ahead = argc > 2 ? atoi(argv[2]) : BENCH_AHEAD;
+    int behind = argc > 3 ? atoi(argv[3]) : BENCH_BEHIND;
+    int budget_kb = argc > 4 ? atoi(argv[4]) : BENCH_BUDGET_KB;
+    static UBYTE packed[BENCH_HEIGHT * (BENCH_WB + BENCH_WB / 128 + 1)], unpacked[BENCH_BYTES];
+    uint32_t size, most = 0, total = 0;
+    static READER_CACHE cache;
+    READER_CACHE_STATS stats;
+    double t_drawn, t_cached;
+    UBYTE *expected;
+    int page, bad;
+
+    if (turns <= 0 || ahead < 0 || behind < 0 || ahead + behind + 1 > READER_CACHE_SLOTS || budget_kb <= 0)
+        return 1;
+    expected = malloc((size_t)BENCH_PAGES * BENCH_BYTES);
+    if (!expected)
+        return 1;
+    new_paint(&worker_paint, worker_image);
+    new_paint(&main_paint, main_image);
+    for (page = 0; page < BENCH_PAGES; page++)
+        draw_page(&main_paint, page, expected + (size_t)page * BENCH_BYTES);
+
+    // Packing: the pages, then random bytes with runs in them
+    bad = 0;
+    for (page = 0; page < BENCH_PAGES; page++) {
+        size = Reader_Cache_PackRows(expected + (size_t)page * BENCH_BYTES, BENCH_WB, BENCH_HEIGHT, packed);
+        bad += Reader_Cache_UnpackRows(packed, size, BENCH_WB, BENCH_HEIGHT, unpacked) != BENCH_HEIGHT ||
+               memcmp(unpacked, expected + (size_t)page * BENCH_BYTES, BENCH_BYTES) != 0;
+        most = size > most ? size : most;
+        total += size;
+    }
+    srand(9);
+    for (page = 0; page < 200; page++) {
+        int i;
+        for (i = 0; i < BENCH_BYTES; i++)
+            unpacked[i] = rand() % (2 + page % 6) ? (UBYTE)(i / (1 + page)) : rand();
+        memcpy(worker_image, unpacked, BENCH_BYTES);
+        size = Reader_Cache_PackRows(worker_image, BENCH_WB, BENCH_HEIGHT, packed);
+        bad += size > sizeof(packed) ||
+               Reader_Cache_UnpackRows(packed, size, BENCH_WB, BENCH_HEIGHT, unpacked) != BENCH_HEIGHT ||
+               memcmp(unpacked, worker_image, BENCH_BYTES) != 0;
+        bad += Reader_Cache_UnpackRows(packed, size - 1, BENCH_WB, BENCH_HEIGHT, unpacked) == BENCH_HEIGHT;
+    }
+    if (bad) {
+        printf("%d frames did not come back from packing\n", bad);
+        return 1;
+    }
+    printf("Packed pages: %u bytes on average, %u at most, of %d (%.1fx)\n", total / BENCH_PAGES, most,
+           BENCH_BYTES, (double)BENCH_BYTES * BENCH_PAGES / total);
+
+    bad = turn_pages(NULL, expected, turns, 0, 0, &t_drawn);
+    if (Reader_Cache_Init(&cache, ahead + behind + 1, BENCH_WB, BENCH_HEIGHT, budget_kb * 1024, render, NULL) != 0)
+        return 1;
+    bad += turn_pages(&cache, expected, turns, ahead, behind, &t_cached);
+    Reader_Cache_GetStats(&cache, &stats);
+    Reader_Cache_Free(&cache);
+    free(expected);
+    if (bad) {
+        printf("%d page turns showed the wrong frame\n", bad);
+        return 1;
+    }
+
+    printf("%d page turns, every frame identical to the page drawn directly\n", turns);
+    printf("Cache depth +%d/-%d: %u hits, %u misses (%.0f%%), %u rendered, %u never shown\n",
+           ahead, behind, stats.Hits, stats.Misses, 100.0 * stats.Hits / turns, stats.Rendered, stats.Wasted);
+    printf("%u pages kept in %u KB of %d KB, %u KB unpacked\n", stats.Pages, stats.Bytes / 1024, budget_kb,
+           stats.Pages * BENCH_BYTES / 1024);
+    printf("Key to frame, drawn on the spot %6.3f ms\n", t_drawn);
+    printf("Key to frame, rendered ahead    %6.3f ms  %.1fx\n", t_cached, t_drawn / t_cached);
+    return 0;
+}
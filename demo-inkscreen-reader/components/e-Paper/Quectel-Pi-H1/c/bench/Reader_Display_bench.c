@@ -0,0 +1,190 @@
+/*****************************************************************************
+* | File      	:   Reader_Display_bench.c
+* | Function    :   Key presses while the panel refreshes, with a display thread
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Reader_Display_bench [turns] [key ms] [refresh ms]
+*   A fake panel takes [refresh ms] for a partial refresh and four times
+*   that for a full one. Keys come every [key ms]; each draws a page into
+*   one frame and hands its window to the panel. Called directly, every
+*   key waits out the refresh before the next one is read; through a
+*   Reader_Display the key thread only queues. Every window the panel
+*   gets must hold the page of its key, in order, although the frame is
+*   drawn over right after queueing. The panel is put to sleep once on
+*   the way and must be woken before the next page. Per-command queued
+*   and refresh times come from Reader_Display_GetStats().
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Display.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_TURNS         40
+#define BENCH_KEY_MS        30      // Key repeat
+#define BENCH_REFRESH_MS    40      // Scaled down from a real partial refresh
+#define BENCH_WB            100
+#define BENCH_HEIGHT        480
+#define BENCH_BYTES         (BENCH_WB * BENCH_HEIGHT)
+#define BENCH_WAKE_PART     1
+
+typedef struct {
+    int RefreshMs;
+    int Asleep;
+    int Shown[BENCH_TURNS * 4];     // Page of each window refreshed, in order
+    int Count;
+    int Bad;                        // Drawn while asleep, or a torn window
+} BENCH_PANEL;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void panel_full(void *arg, const uint8_t *frame)
+{
+    BENCH_PANEL *p = arg;
+    p->Bad += p->Asleep;
+    (void)frame;
+    usleep(p->RefreshMs * 4000);
+}
+
+static void panel_window(void *arg, const uint8_t *frame, uint16_t x_start, uint16_t y_start,
+                         uint16_t x_end, uint16_t y_end)
+{
+    BENCH_PANEL *p = arg;
+    int y, x, page = frame[y_start * BENCH_WB + x_start / 8];
+
+    p->Bad += p->Asleep;
+    for (y = y_start; y < y_end; y++)
+        for (x = x_start / 8; x < x_end / 8; x++)
+            p->Bad += frame[y * BENCH_WB + x] != page;
+    if (p->Count < (int)(sizeof(p->Shown) / sizeof(p->Shown[0])))
+        p->Shown[p->Count++] = page;
+    usleep(p->RefreshMs * 1000);
+}
+
+static void panel_sleep(void *arg)
+{
+    ((BENCH_PANEL *)arg)->Asleep = 1;
+}
+
+static void panel_wake(void *arg, int mode)
+{
+    BENCH_PANEL *p = arg;
+    p->Asleep = 0;
+    usleep(mode == BENCH_WAKE_PART ? 5000 : 20000);
+}
+
+static void panel_clear(void *arg)
+{
+    BENCH_PANEL *p = arg;
+    usleep(p->RefreshMs * 4000);
+}
+
+static const READER_DISPLAY_OPS bench_ops = {
+    panel_full, panel_window, panel_sleep, panel_wake, panel_clear
+};
+
+// A page: its number in the text area, as far as a window needs it
+static void draw(uint8_t *frame, int page)
+{
+    memset(frame + 35 * BENCH_WB, page & 0xff, (BENCH_HEIGHT - 35) * BENCH_WB);
+}
+
+/* Keys every key_ms, direct to the panel or through display; returns the time
+ * until the last key was read, sets the longest a key waited to be read */
+static double press_keys(READER_DISPLAY *display, BENCH_PANEL *panel, int turns, int key_ms, double *late_ms)
+{
+    static uint8_t frame[BENCH_BYTES];
+    double t0 = now_sec(), due, late = 0;
+    int turn;
+
+    for (turn = 0; turn < turns; turn++) {
+        due = t0 + turn * key_ms / 1e3;
+        while (now_sec() < due)
+            usleep(500);
+        late = now_sec() - due > late ? now_sec() - due : late;
+
+        draw(frame, turn + 1);
+        if (turn == turns / 2) {
+            // Off and back on, the next page must wake the panel first
+            if (display)
+                Reader_Display_Sleep(display);
+            else
+                panel_sleep(panel);
+        }
+        if (display) {
+            Reader_Display_Window(display, frame, 16, 35, 784, BENCH_HEIGHT);
+        } else {
+            if (panel->Asleep)
+                panel_wake(panel, BENCH_WAKE_PART);
+            panel_window(panel, frame, 16, 35, 784, BENCH_HEIGHT);
+        }
+        memset(frame, 0xee, sizeof(frame));   // The next page is drawn right away
+    }
+    *late_ms = late * 1e3;
+    return now_sec() - t0;
+}
+
+static int check(BENCH_PANEL *panel, int turns, const char *how)
+{
+    int i, bad = panel->Bad + (panel->Count != turns);
+
+    for (i = 0; i < panel->Count; i++)
+        bad += panel->Shown[i] != i + 1;
+    if (bad)
+        printf("%s: %d windows wrong or out of order, %d shown of %d\n", how, bad, panel->Count, turns);
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    int turns = argc > 1 ? atoi(argv[1]) : BENCH_TURNS;
+    int key_ms = argc > 2 ? atoi(argv[2]) : BENCH_KEY_MS;
+    int refresh_ms = argc > 3 ? atoi(argv[3]) : BENCH_REFRESH_MS;
+    static BENCH_PANEL direct, queued;
+    static READER_DISPLAY display;
+    static const char *names[READER_DISPLAY_COMMANDS] = {"full", "window", "sleep", "wake", "clear"};
+    READER_DISPLAY_STATS stats;
+    double t_direct, t_queued, late_direct, late_queued;
+    int i, bad;
+
+    if (turns <= 0 || turns > BENCH_TURNS * 4 || key_ms <= 0 || refresh_ms <= 0)
+        return 1;
+    direct.RefreshMs = queued.RefreshMs = refresh_ms;
+
+    t_direct = press_keys(NULL, &direct, turns, key_ms, &late_direct);
+    if (Reader_Display_Init(&display, BENCH_WB, BENCH_HEIGHT, &bench_ops, &queued) != 0)
+        return 1;
+    Reader_Display_Wake(&display, BENCH_WAKE_PART);
+    t_queued = press_keys(&display, &queued, turns, key_ms, &late_queued);
+    Reader_Display_Wait(&display);
+    Reader_Display_GetStats(&display, &stats);
+    Reader_Display_Free(&display);
+
+    bad = check(&direct, turns, "Direct") + check(&queued, turns, "Display thread");
+    if (bad)
+        return 1;
+    printf("%d keys every %d ms, %d ms refreshes: every window shown in order, page intact\n",
+           turns, key_ms, refresh_ms);
+    printf("Direct calls    keys read over %7.1f ms, a key waited up to %6.1f ms\n", t_direct * 1e3, late_direct);
+    printf("Display thread  keys read over %7.1f ms, a key waited up to %6.1f ms  (%u panel wake)\n",
+           t_queued * 1e3, late_queued, stats.Woken);
+    for (i = 0; i < READER_DISPLAY_COMMANDS; i++) {
+        READER_DISPLAY_TIMES *t = &stats.Command[i];
+        if (t->Count == 0)
+            continue;
+        printf("  %-6s x%-3u queued %7.1f ms avg %7.1f max, run %6.1f ms avg %6.1f max\n", names[i], t->Count,
+               t->WaitSum / 1e6 / t->Count, t->WaitMax / 1e6, t->RunSum / 1e6 / t->Count, t->RunMax / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*****************************************************************************
+* | File      	:   Reader_Encoding_bench.c
+* | Function    :   Throughput of the UTF-8 validator and encoding detection
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Reader_Encoding_bench [english book] [gb2312 book] [MB]
+*   Three inputs are built by repeating a book up to MB megabytes (default
+*   256): the English book (default books/test.txt), the GB2312 book
+*   (default books/test2.txt) and that book transcoded to UTF-8 with
+*   iconv. Each is validated with every validator this CPU supports and
+*   classified with Reader_Encoding_Detect(). Random input is checked
+*   against the scalar validator first.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Encoding.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iconv.h>
+
+#define BENCH_BOOK_EN   "../../../../books/test.txt"
+#define BENCH_BOOK_CN   "../../../../books/test2.txt"
+#define BENCH_MB        256
+
+static const int scans[] = { READER_SCAN_SCALAR, READER_SCAN_SSSE3, READER_SCAN_AVX2, READER_SCAN_NEON };
+#define SCAN_COUNT  (int)(sizeof(scans) / sizeof(scans[0]))
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    long len;
+    char *buf;
+
+    if (!fp)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = len > 0 ? malloc(len) : NULL;
+    if (!buf || fread(buf, 1, len, fp) != (size_t)len) {
+        free(buf);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *size = (size_t)len;
+    return buf;
+}
+
+static char *to_utf8(const char *gb, size_t size, size_t *out_size)
+{
+    iconv_t cd = iconv_open("UTF-8", "GB18030");
+    size_t cap = size * 2 + 16, in_left = size, out_left = cap;
+    char *out = malloc(cap), *in = (char *)gb, *dst = out;
+
+    if (cd == (iconv_t)-1 || !out) {
+        free(out);
+        return NULL;
+    }
+    if (iconv(cd, &in, &in_left, &dst, &out_left) == (size_t)-1) {
+        iconv_close(cd);
+        free(out);
+        return NULL;
+    }
+    iconv_close(cd);
+    *out_size = cap - out_left;
+    return out;
+}
+
+static char *repeat(const char *book, size_t book_size, size_t target, size_t *size)
+{
+    char *text = malloc(target + book_size);
+    size_t n = 0;
+
+    if (!text)
+        return NULL;
+    while (n < target) {
+        memcpy(text + n, book, book_size);
+        n += book_size;
+    }
+    *size = n;
+    return text;
+}
+
+// Random input built from the bytes that matter to the validator, at every alignment
+static int check_random(void)
+{
+    static const unsigned char alphabet[] = {
+        'a', ' ', 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2, 0xDF,
+        0xE0, 0xE4, 0xED, 0xEF, 0xF0, 0xF4, 0xF5, 0xFF,
+    };
+    static const char *valid[] = {
+        "a", "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xE4\xB8\xAD", "\xED\x9F\xBF",
+        "\xEE\x80\x80", "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF",
+    };
+    char buf[200];
+    int round, s, valid_count = 0;
+
+    srand(1);
+    for (round = 0; round < 400000; round++) {
+        size_t len = 0, limit = 1 + rand() % (sizeof(buf) - 4);
+        // Mostly valid characters so errors land at every position, not just the first few bytes
+        while (len < limit) {
+            if (rand() % 64) {
+                const char *c = valid[rand() % (sizeof(valid) / sizeof(valid[0]))];
+                memcpy(buf + len, c, strlen(c));
+                len += strlen(c);
+            } else {
+                buf[len++] = (char)alphabet[rand() % sizeof(alphabet)];
+            }
+        }
+
+        Reader_Encoding_SetScan(READER_SCAN_SCALAR);
+        int expect = Reader_UTF8_Validate(buf, len);
+        valid_count += expect;
+        for (s = 1; s < SCAN_COUNT; s++) {
+            if (Reader_Encoding_SetScan(scans[s]) != 0)
+                continue;
+            if (Reader_UTF8_Validate(buf, len) != expect) {
+                printf("MISMATCH: %s, round %d, length %zu\n", Reader_Encoding_ScanName(), round, len);
+                return -1;
+            }
+        }
+    }
+    printf("Random input: identical to the scalar validator (%d of %d valid)\n", valid_count, round);
+    return 0;
+}
+
+static void bench(const char *name, const char *text, size_t size)
+{
+    READER_ENCODING enc;
+    int expect = -1;
+
+    for (int s = 0; s < SCAN_COUNT; s++) {
+        if (Reader_Encoding_SetScan(scans[s]) != 0)
+            continue;
+        double t = now_sec();
+        int valid = Reader_UTF8_Validate(text, size);
+        t = now_sec() - t;
+        if (expect < 0)
+            expect = valid;
+        // Invalid input stops at the first bad vector, so only the time means anything
+        if (valid)
+            printf("%-12s %-8s %10.1f MB/s  valid%s\n", name, Reader_Encoding_ScanName(), size / t / 1e6,
+                   valid == expect ? "" : "  RESULT DIFFERS");
+        else
+            printf("%-12s %-8s %10.1f us    invalid%s\n", name, Reader_Encoding_ScanName(), t * 1e6,
+                   valid == expect ? "" : "  RESULT DIFFERS");
+    }
+
+    Reader_Encoding_SetScan(READER_SCAN_AUTO);
+    double t = now_sec();
+    Reader_Encoding_Detect(text, size, &enc);
+    t = now_sec() - t;
+    printf("%-12s detect   %10.1f MB/s  %s, confidence %u%%\n", name, size / t / 1e6,
+           Reader_Encoding_Name(enc.Encoding), enc.Confidence);
+}
+
+int main(int argc, char **argv)
+{
+    const char *en_path = argc > 1 ? argv[1] : BENCH_BOOK_EN;
+    const char *cn_path = argc > 2 ? argv[2] : BENCH_BOOK_CN;
+    size_t target = (size_t)(argc > 3 ? atoi(argv[3]) : BENCH_MB) * 1024 * 1024;
+    size_t en_size, cn_size, utf8_size, size;
+    char *en, *cn, *utf8, *text;
+
+    if (check_random() != 0)
+        return 1;
+
+    en = read_file(en_path, &en_size);
+    cn = read_file(cn_path, &cn_size);
+    if (!en || !cn) {
+        printf("Cannot read %s\n", en ? cn_path : en_path);
+        return 1;
+    }
+    utf8 = to_utf8(cn, cn_size, &utf8_size);
+    if (!utf8) {
+        printf("Cannot transcode %s to UTF-8\n", cn_path);
+        return 1;
+    }
+    printf("Books repeated to %zu MB\n", target >> 20);
+
+    if ((text = repeat(en, en_size, target, &size)) != NULL) {
+        bench("english", text, size);
+        free(text);
+    }
+    if ((text = repeat(utf8, utf8_size, target, &size)) != NULL) {
+        bench("chinese-utf8", text, size);
+        free(text);
+    }
+    if ((text = repeat(cn, cn_size, target, &size)) != NULL) {
+        bench("gb2312", text, size);
+        free(text);
+    }
+
+    free(en);
+    free(cn);
+    free(utf8);
+    return 0;
+}
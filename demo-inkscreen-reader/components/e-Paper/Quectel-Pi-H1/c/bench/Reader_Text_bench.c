@@ -0,0 +1,207 @@
+/*****************************************************************************
+* | File      	:   Reader_Text_bench.c
+* | Function    :   Throughput of the paragraph normalizer
+* | Info        :
+*   Runs on the host, no panel needed:
+*       make bench
+*       ./bin/Reader_Text_bench [book] [MB]
+*   The book (default books/test.txt) is repeated up to MB megabytes
+*   (default 256) and normalized with the byte-at-a-time reference and with
+*   every scanner this CPU supports. The outputs must be identical.
+*   Random malformed input is checked against the reference as well.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Text.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_BOOK  "../../../../books/test.txt"
+#define BENCH_MB    256
+
+static int utf8_char_len(const char *text, size_t size, size_t pos)
+{
+    unsigned char c = (unsigned char)text[pos];
+    (void)size;
+    if (c < 0x80) return 1;
+    if ((c & 0xE0) == 0xC0) return 2;
+    if ((c & 0xF0) == 0xE0) return 3;
+    if ((c & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+static int gb2312_char_len(const char *text, size_t size, size_t pos)
+{
+    unsigned char c = (unsigned char)text[pos];
+    if (c >= 0x80 && pos + 1 < size && (unsigned char)text[pos + 1] >= 0x40)
+        return 2;
+    return 1;
+}
+
+// The normalizer as it was before the vector scan, kept as the reference
+static char *reference_normalize(const char *raw_text, size_t raw_size, READER_CHAR_LEN char_len, size_t *out_size)
+{
+    char *processed = malloc(raw_size + 1);
+    size_t src_idx = 0, dst_idx = 0;
+    int in_paragraph = 0;
+
+    if (!processed) return NULL;
+    while (src_idx < raw_size) {
+        while (src_idx < raw_size && (raw_text[src_idx] == '\n' || raw_text[src_idx] == '\r')) {
+            size_t temp_idx = src_idx;
+            int newline_count = 0;
+            while (temp_idx < raw_size && (raw_text[temp_idx] == '\n' || raw_text[temp_idx] == '\r')) {
+                newline_count++;
+                if (temp_idx + 1 < raw_size &&
+                    ((raw_text[temp_idx] == '\r' && raw_text[temp_idx + 1] == '\n') ||
+                     (raw_text[temp_idx] == '\n' && raw_text[temp_idx + 1] == '\r')))
+                    temp_idx += 2;
+                else
+                    temp_idx++;
+            }
+            if (newline_count >= 2) {
+                if (in_paragraph) {
+                    processed[dst_idx++] = '\n';
+                    in_paragraph = 0;
+                }
+            } else if (in_paragraph) {
+                processed[dst_idx++] = ' ';
+            }
+            src_idx = temp_idx;
+        }
+
+        if (src_idx < raw_size && raw_text[src_idx] != '\n' && raw_text[src_idx] != '\r') {
+            if (!in_paragraph) {
+                while (src_idx < raw_size && raw_text[src_idx] == ' ') src_idx++;
+                if (src_idx >= raw_size) break;
+            }
+            unsigned char c = (unsigned char)raw_text[src_idx];
+            int bytes = char_len(raw_text, raw_size, src_idx);
+            if (c == ' ' && in_paragraph && dst_idx > 0 && processed[dst_idx - 1] == ' ') {
+                // Skip extra spaces
+            } else {
+                for (int i = 0; i < bytes && src_idx + i < raw_size; i++)
+                    processed[dst_idx++] = raw_text[src_idx + i];
+                in_paragraph = 1;
+            }
+            src_idx += bytes;
+        }
+    }
+    processed[dst_idx] = '\0';
+    *out_size = dst_idx;
+    return processed;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Random input rich in line breaks, spaces and broken multi-byte sequences
+static int check_random(void)
+{
+    static const unsigned char alphabet[] = {
+        '\r', '\n', ' ', ' ', 'a', 'b', 0xE4, 0xB8, 0xAD, 0xC3, 0xA9, 0xF0, 0x9F, 0x80, 0xB0, 0xA1, 0xFF,
+    };
+    static const int scans[] = { READER_SCAN_SCALAR, READER_SCAN_SSE2, READER_SCAN_AVX2, READER_SCAN_NEON };
+    char buf[600];
+    int round, s;
+
+    srand(1);
+    for (round = 0; round < 200000; round++) {
+        size_t len = 1 + rand() % (sizeof(buf) - 1);
+        for (size_t i = 0; i < len; i++)
+            buf[i] = (char)alphabet[rand() % sizeof(alphabet)];
+
+        for (int enc = 0; enc < 2; enc++) {
+            READER_CHAR_LEN char_len = enc ? gb2312_char_len : utf8_char_len;
+            size_t ref_size, out_size;
+            char *ref = reference_normalize(buf, len, char_len, &ref_size);
+
+            for (s = 0; s < (int)(sizeof(scans) / sizeof(scans[0])); s++) {
+                if (Reader_Text_SetScan(scans[s]) != 0)
+                    continue;
+                char *out = Reader_Text_Normalize(buf, len, char_len, &out_size, 0);
+                if (out_size != ref_size || memcmp(out, ref, ref_size) != 0) {
+                    printf("MISMATCH: %s, %s, round %d\n", Reader_Text_ScanName(), enc ? "gb2312" : "utf-8", round);
+                    return -1;
+                }
+                free(out);
+            }
+            free(ref);
+        }
+    }
+    printf("Random input: identical to the reference\n");
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : BENCH_BOOK;
+    size_t target = (size_t)(argc > 2 ? atoi(argv[2]) : BENCH_MB) * 1024 * 1024;
+    static const int scans[] = { READER_SCAN_SCALAR, READER_SCAN_SSE2, READER_SCAN_AVX2, READER_SCAN_NEON };
+    FILE *fp;
+    long book_size;
+    char *book, *text;
+    size_t size = 0;
+
+    if (check_random() != 0)
+        return 1;
+
+    fp = fopen(path, "rb");
+    if (!fp) {
+        printf("Cannot open %s\n", path);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    book_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    book = malloc(book_size > 0 ? book_size : 1);
+    if (!book || book_size <= 0 || fread(book, 1, book_size, fp) != (size_t)book_size) {
+        printf("Cannot read %s\n", path);
+        return 1;
+    }
+    fclose(fp);
+
+    text = malloc(target + book_size);
+    if (!text) {
+        printf("Cannot allocate %zu MB\n", target >> 20);
+        return 1;
+    }
+    while (size < target) {
+        memcpy(text + size, book, book_size);
+        size += book_size;
+    }
+    printf("%s repeated to %zu MB\n", path, size >> 20);
+
+    for (int enc = 0; enc < 2; enc++) {
+        READER_CHAR_LEN char_len = enc ? gb2312_char_len : utf8_char_len;
+        size_t ref_size, out_size;
+        double t = now_sec();
+        char *ref = reference_normalize(text, size, char_len, &ref_size);
+        t = now_sec() - t;
+        printf("%-7s reference  %8.1f MB/s\n", enc ? "gb2312" : "utf-8", size / t / 1e6);
+
+        for (int s = 0; s < (int)(sizeof(scans) / sizeof(scans[0])); s++) {
+            if (Reader_Text_SetScan(scans[s]) != 0)
+                continue;
+            t = now_sec();
+            char *out = Reader_Text_Normalize(text, size, char_len, &out_size, 0);
+            t = now_sec() - t;
+            printf("%-7s %-10s %8.1f MB/s%s\n", enc ? "gb2312" : "utf-8", Reader_Text_ScanName(), size / t / 1e6,
+                   (out_size == ref_size && memcmp(out, ref, ref_size) == 0) ? "" : "  OUTPUT DIFFERS");
+            free(out);
+        }
+        free(ref);
+    }
+
+    free(text);
+    free(book);
+    return 0;
+}
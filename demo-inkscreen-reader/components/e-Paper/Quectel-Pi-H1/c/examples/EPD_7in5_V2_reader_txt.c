@@ -3,7 +3,15 @@
 #include "EPD_7in5_V2.h"
 #include "GUI_Paint.h"
 #include "fonts.h"
+#include "fontpack.h"
 #include "GUI_BMPfile.h"
+#include "GUI_FrameDiff.h"
+#include "Reader_Index.h"
+#include "Reader_Glyph.h"
+#include "Reader_Encoding.h"
+#include "Reader_Text.h"
+#include "Reader_Cache.h"
+#include "Reader_Display.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +19,7 @@
 #include <fcntl.h>
 #include <linux/input.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #include <errno.h>
 #include <sys/time.h>
@@ -18,16 +27,19 @@
 #include <sys/ioctl.h>
 #include "DEV_Config.h"
 #include <sys/types.h>  // Add this header to define DT_REG
-#include <poll.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 // Define custom screen off and on signals
 #define CUSTOM_SCREEN_OFF_BTN BTN_LEFT
 #define CUSTOM_SCREEN_ON_BTN BTN_RIGHT
 
 #define BOOK_PATH "/home/pi/e-ink-reader/demo-inkscreen-reader/books"
-#define MAX_BOOK_SIZE (4* 1024 * 1024) // 4MB
+#define CN_FONT_PACK "/home/pi/e-ink-reader/demo-inkscreen-reader/fonts/cn16.fpk"  // Made with tools/fontpack_gen.c
 #define MAX_BOOKS 20
 #define MAX_HISTORY 500 // Record up to 500 page history entries
+#define LONG_PRESS_MS 1000  // Held this long a page key switches books
 
 // Partial refresh area definitions
 #define HEADER_HEIGHT   30
@@ -36,10 +48,17 @@
 #define CONTENT_Y_START   (HEADER_HEIGHT + 5)  // Reduce margin at top of content area
 #define FOOTER_Y_START    (EPD_7IN5_V2_HEIGHT - FOOTER_HEIGHT)
 
+// Pages rendered ahead while the panel is idle: the next PAGE_CACHE_AHEAD and the
+// PAGE_CACHE_BEHIND before the one shown, 0 and 0 turns it off. They are kept packed,
+// a page of text in 10 to 20 KB, within PAGE_CACHE_BUDGET bytes
+#define PAGE_CACHE_AHEAD    16
+#define PAGE_CACHE_BEHIND   8
+#define PAGE_CACHE_BUDGET   (512 * 1024)
+
 // Function declarations
 void safe_truncate_filename(char* dest, const char* src, size_t dest_size);
-char* process_text_content(const char* raw_text, size_t raw_size);
-void calculate_page_info();
+char* process_text_content(const char* raw_text, size_t raw_size, size_t* out_size, int input_mapped);
+void calculate_page_info(const char* path);
 int get_current_page_index(size_t offset);
 int find_eye_control_device();
 void init_eye_control_device();
@@ -52,11 +71,24 @@ static int screen_off = 0;  // Whether currently in screen-off state
 static int anti_flicker_until = 0;  // Unix timestamp until which anti-flicker is active
 
 static char current_file[2048] = {0};  // Reasonable size for file path
-static UBYTE *g_frame_buffer = NULL;
-static UBYTE *g_prev_frame_buffer = NULL; // Used to compare differences between frames for implementing partial refresh
+static UBYTE *g_frame_buffer = NULL;  // Panel frame, filled by flush_frame()
+static UBYTE *g_draw_buffer = NULL;   // Drawn upright, turned for the panel once per refresh
+static UBYTE *g_prev_frame_buffer = NULL; // What the panel shows, kept by flush_frame() for partial refresh
+static FRAME_DIFF g_frame_diff;           // What the last flush_frame() changed
+static int g_panel_shows_draw = 0;        // The panel shows g_draw_buffer as last flushed, not a cached page
+static READER_CACHE g_page_cache;         // Panel frames of the pages around the one shown
+static PAINT g_cache_paint;               // The cache worker draws through its own context
+static UBYTE *g_cache_draw_buffer = NULL; // and into its own upright buffer
+// Text rows and footer box the page last drawn into each context covers, all below the header at first
+#define PAGE_INK_ALL {{0, CONTENT_Y_START, EPD_7IN5_V2_WIDTH, EPD_7IN5_V2_HEIGHT}, {0, 0, 0, 0}}
+static PAINT_RECT g_page_ink[2] = PAGE_INK_ALL;
+static PAINT_RECT g_cache_page_ink[2] = PAGE_INK_ALL;
+static READER_DISPLAY g_display;          // The display thread, the only one talking to the panel
 static int key1_fd = -1; // event3: next page / long press: next book
 static int key2_fd = -1; // event1: prev page / long press: prev book
 static int eye_key_fd = -1; // New: eye_page_turner virtual device
+static int long_press_fd = -1; // timerfd, armed while a page key is held
+static int long_press_key = 0; // and the key it is armed for
 static int first_display_done = 0;
 static int book_changed = 0;  // Flag to mark whether book has changed
 static int header_drawn = 0;  // New: flag to mark if Header area has been drawn
@@ -65,26 +97,33 @@ static char book_list[MAX_BOOKS][2048];  // Reasonable size for file path
 static int book_count = 0;
 static int current_book_index = 0;
 
-// Global text
-static char* g_full_text = NULL;
+// Global text: the raw book is only mapped while it is being loaded
+static const char* g_full_text = NULL;
 static size_t g_text_size = 0;
-// New: Processed plain text content with extra line breaks removed
-static char* g_processed_text = NULL;
+// Processed text (extra line breaks removed) as glyph IDs, the text itself is not kept
+static READER_GLYPHS g_glyphs;
 static size_t g_processed_text_size = 0;
 
 // Current page starting offset (in bytes)
 static size_t g_current_char_offset = 0;
 
 // History stack: record starting offset of each page (for precise backward navigation)
+// The top entry is the page shown, g_current_char_offset is where the one after it starts
 static size_t history_stack[MAX_HISTORY];
 static int history_top = -1;
 
+// Page turns asked for while the panel was busy, forward positive, back negative
+static int pending_turns = 0;
+
 // Flag to mark if book title needs redrawing
 static int title_drawn = 0;
 
 // New: Used for accurate calculation of current page number
-static size_t *page_offsets = NULL;  // Store starting offset of each page
-static int total_pages = 0;          // Total number of pages
+static READER_INDEX page_index;              // Line and page tables, mapped from the book's sidecar index when possible
+static const READER_LINE *book_lines = NULL; // Laid out lines of the book
+static const uint32_t *page_lines = NULL;    // First line of each page
+static uint32_t line_count = 0;              // Number of laid out lines
+static int total_pages = 0;                  // Total number of pages
 static int current_page_index = 0;
 
 
@@ -159,37 +198,6 @@ static inline int gb2312_char_len(const char* text, size_t size, size_t pos) {
     return 1;
 }
 
-// Add: File encoding detection function
-static int detect_file_encoding(const char* data, size_t size) {
-    // Check BOM marker
-    if (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) {
-        return 1; // UTF-8 with BOM
-    }
-
-    // Check for obvious GB2312 characteristics (double-byte characters)
-    for (size_t i = 0; i < size && i < 1024; i++) {
-        unsigned char c = (unsigned char)data[i];
-        if (c >= 0x80) {
-            // Check if it conforms to GB2312 specification: first byte ≥0x80 and second byte ≥0x40
-            if (i + 1 < size && (unsigned char)data[i+1] >= 0x40) {
-                return 0; // Likely GB2312
-            }
-            // If it's UTF-8, it should conform to UTF-8 encoding rules
-            else if ((c & 0xE0) == 0xC0 && i + 1 < size) {
-                return 1; // UTF-8
-            }
-            else if ((c & 0xF0) == 0xE0 && i + 2 < size) {
-                return 1; // UTF-8
-            }
-            else if ((c & 0xF8) == 0xF0 && i + 3 < size) {
-                return 1; // UTF-8
-            }
-        }
-    }
-
-    return 1; // Default to UTF-8 (English text)
-}
-
 // Modify: Add UTF-8 character length detection helper function, keeping interface consistent
 static inline int utf8_char_len_pos(const char* text, size_t size, size_t pos) {
     if (pos >= size) return 1;
@@ -206,204 +214,238 @@ typedef struct {
 
 // Add: Global character processor
 static CharProcessor char_processor = {gb2312_char_len, 1};
+// Encoding of the current book, detected once and remembered in its page index
+static READER_ENCODING book_encoding;
+// CN font: the font pack when there is one, the few built-in demo glyphs otherwise
+static cFONT cn_pack;
+static cFONT *cn_font = &Font12CN;
+
+// Process text content: merge paragraphs, remove extra line breaks.
+// When input_mapped is set, raw_text is a read-only file mapping released as the pass goes.
+char* process_text_content(const char* raw_text, size_t raw_size, size_t* out_size, int input_mapped) {
+    return Reader_Text_Normalize(raw_text, raw_size, char_processor.char_len, out_size, input_mapped);
+}
 
-// Process text content: merge paragraphs, remove extra line breaks
-char* process_text_content(const char* raw_text, size_t raw_size) {
-    if (!raw_text || raw_size == 0) return NULL;
-
-    // Create temporary buffer to store processed text
-    char* processed = malloc(raw_size + 1);  // Initialize to original size, may be slightly larger
-    if (!processed) return NULL;
-
-    size_t src_idx = 0, dst_idx = 0;
-    int in_paragraph = 0;  // Flag to mark if in middle of paragraph
-
-    while (src_idx < raw_size) {
-        // Skip consecutive newlines and whitespace characters
-        while (src_idx < raw_size && (raw_text[src_idx] == '\n' || raw_text[src_idx] == '\r')) {
-            // Check if it's a paragraph separator (two consecutive newlines)
-            size_t temp_idx = src_idx;
-            int newline_count = 0;
-            while (temp_idx < raw_size && (raw_text[temp_idx] == '\n' || raw_text[temp_idx] == '\r')) {
-                if (raw_text[temp_idx] == '\n' || raw_text[temp_idx] == '\r') {
-                    newline_count++;
-                    // Skip \r\n or \n\r sequences
-                    if (temp_idx+1 < raw_size && 
-                        ((raw_text[temp_idx]=='\r' && raw_text[temp_idx+1]=='\n') ||
-                         (raw_text[temp_idx]=='\n' && raw_text[temp_idx+1]=='\r'))) {
-                        temp_idx += 2;
-                    } else {
-                        temp_idx++;
-                    }
-                }
-            }
-            
-            // If it's a paragraph separator (at least two newlines), add a newline to mark end of paragraph
-            if (newline_count >= 2) {
-                if (in_paragraph) {
-                    processed[dst_idx++] = '\n';  // Paragraph end marker
-                    in_paragraph = 0;
-                }
-            } else if (in_paragraph) {
-                // Replace line breaks between lines with spaces
-                processed[dst_idx++] = ' ';
-            }
-            
-            src_idx = temp_idx;
-        }
-
-        // Process regular characters
-        if (src_idx < raw_size && raw_text[src_idx] != '\n' && raw_text[src_idx] != '\r') {
-            // Skip leading whitespace characters (if not in paragraph)
-            if (!in_paragraph) {
-                while (src_idx < raw_size && raw_text[src_idx] == ' ') src_idx++;
-                if (src_idx >= raw_size) break;
-            }
+// Layout shared by pagination and rendering, set up in calculate_page_info
+#define MAX_PAGE_LINES 64  // Lines on one page, well above what the panel fits
+static READER_LAYOUT text_layout;
+
+// Background pagination: the worker lays out the book page by page and publishes
+// the lines of each page as it goes, page_lock protects page_index, book_lines,
+// page_lines, line_count, total_pages and paginated_bytes
+static pthread_mutex_t page_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t paginate_thread;
+static int paginate_thread_running = 0;
+static volatile int paginate_stop = 0;  // Set to make the worker give up early
+static int pages_complete = 0;          // page_lines covers the whole book
+static size_t paginated_bytes = 0;      // Text covered by the published pages
+static READER_INDEX_KEY paginate_key;
+static int paginate_have_key = 0;
+static char paginate_path[2048];
+
+// Grow a table to hold at least need entries, returns NULL and leaves it untouched on failure
+static void* grow_table(void* table, uint32_t* capacity, uint32_t need, size_t entry_size) {
+    if (need <= *capacity) return table;
+    uint32_t grown_capacity = *capacity + *capacity / 2;
+    if (grown_capacity < need) grown_capacity = need;
+    void* grown = realloc(table, entry_size * grown_capacity);
+    if (grown) *capacity = grown_capacity;
+    return grown;
+}
 
-            // Copy characters
-            unsigned char c = (unsigned char)raw_text[src_idx];
-            int bytes = char_processor.char_len(raw_text, raw_size, src_idx);
+// Worker thread: lay out the whole book, publishing each page as soon as it is known
+static void* paginate_worker(void* arg) {
+    (void)arg;
+    uint32_t glyph = 0;
+    uint32_t line_capacity = g_processed_text_size / 40 + 100;
+    uint32_t page_capacity = g_processed_text_size / 1000 + 100;
+    READER_LINE *page = malloc(sizeof(READER_LINE) * MAX_PAGE_LINES);
+    READER_LINE *lines = malloc(sizeof(READER_LINE) * line_capacity);
+    uint32_t *pages = malloc(sizeof(uint32_t) * page_capacity);
+    if (!page || !lines || !pages) {
+        printf("Error: Could not allocate memory for page layout\n");
+        free(page);
+        free(lines);
+        free(pages);
+        return NULL;
+    }
 
-            // Copy character (skip extra spaces within paragraph)
-            if (c == ' ' && in_paragraph && dst_idx > 0 && processed[dst_idx-1] == ' ') {
-                // Skip extra spaces
-            } else {
-                for (int i = 0; i < bytes && src_idx+i < raw_size; i++) {
-                    processed[dst_idx++] = raw_text[src_idx + i];
-                }
-                in_paragraph = 1;
-            }
+    pthread_mutex_lock(&page_lock);
+    book_lines = lines;
+    page_lines = pages;
+    pthread_mutex_unlock(&page_lock);
 
-            src_idx += bytes;
+    uint32_t nlines = 0;
+    int count = 0;
+    while (glyph < g_glyphs.Count && !paginate_stop) {
+        uint32_t next;
+        int n = Reader_Layout_Page(&text_layout, &g_glyphs, glyph, page, MAX_PAGE_LINES, &next);
+
+        pthread_mutex_lock(&page_lock);
+        READER_LINE *grown_lines = grow_table(lines, &line_capacity, nlines + n, sizeof(READER_LINE));
+        if (grown_lines) lines = grown_lines;
+        uint32_t *grown_pages = grow_table(pages, &page_capacity, count + 1, sizeof(uint32_t));
+        if (grown_pages) pages = grown_pages;
+        book_lines = lines;
+        page_lines = pages;
+        if (!grown_lines || !grown_pages) {
+            pthread_mutex_unlock(&page_lock);
+            printf("Warning: Could not expand memory for page layout, stop calculation at page %d\n", count);
+            break;
         }
+        memcpy(lines + nlines, page, sizeof(READER_LINE) * n);
+        pages[count++] = nlines;
+        nlines += n;
+        line_count = nlines;
+        total_pages = count;
+        paginated_bytes = Reader_Line_End(&page[n - 1]);
+        pthread_mutex_unlock(&page_lock);
+
+        glyph = next;
+    }
+    free(page);
+
+    pthread_mutex_lock(&page_lock);
+    if (paginate_stop) {
+        // Book is being closed, load_txt_file frees the partial tables
+        Reader_Index_Adopt(&page_index, lines, nlines, pages, count);
+        pthread_mutex_unlock(&page_lock);
+        return NULL;
     }
 
-    processed[dst_idx] = '\0';
-    // Reallocate to appropriate size
-    char* result = realloc(processed, dst_idx + 1);
-    if (!result) result = processed;  // If realloc fails, return original pointer
-    return result;
+    // Shrink tables to exact size, under the lock since the renderer may be reading them
+    READER_LINE *exact_lines = realloc(lines, sizeof(READER_LINE) * (nlines > 0 ? nlines : 1));
+    if (exact_lines) lines = exact_lines;
+    uint32_t *exact_pages = realloc(pages, sizeof(uint32_t) * (count > 0 ? count : 1));
+    if (exact_pages) pages = exact_pages;
+    Reader_Index_Adopt(&page_index, lines, nlines, pages, count);
+    book_lines = page_index.Lines;
+    page_lines = page_index.Pages;
+    pages_complete = 1;
+    pthread_mutex_unlock(&page_lock);
+    printf("Successfully calculated %d pages (%u lines)\n", count, nlines);
+
+    // Save the layout so the next open of this book skips pagination
+    if (paginate_have_key && count > 0) {
+        Reader_Index_Save(paginate_path, &paginate_key, &book_encoding, lines, nlines, pages, count);
+    }
+    return NULL;
 }
 
-// Calculate total number of pages and store starting offset of each page
-void calculate_page_info() {
-    if (!g_processed_text) return;
-    
-    // Free previous page offset array
-    if (page_offsets) {
-        free(page_offsets);
-        page_offsets = NULL;
+// Stop the pagination worker of the current book, if any
+static void stop_pagination(void) {
+    if (paginate_thread_running) {
+        paginate_stop = 1;
+        pthread_join(paginate_thread, NULL);
+        paginate_thread_running = 0;
+        paginate_stop = 0;
     }
+}
+
+// Lay out the book: line table plus the first line of each page
+void calculate_page_info(const char* path) {
+    if (!g_glyphs.Ids) return;
     
-    // Temporary storage for page offsets, using larger buffer
-    size_t *temp_offsets = malloc(sizeof(size_t) * (g_processed_text_size / 1000 + 100));
-    if (!temp_offsets) {
-        printf("Error: Could not allocate memory for temporary page offsets\n");
+    // Free previous line and page tables
+    stop_pagination();
+    Reader_Index_Free(&page_index);
+    book_lines = NULL;
+    page_lines = NULL;
+    line_count = 0;
+    total_pages = 0;
+    pages_complete = 0;
+    paginated_bytes = 0;
+
+    text_layout.LeftMargin = 0;
+    text_layout.MaxX = EPD_7IN5_V2_WIDTH;
+    text_layout.Indent = Font16.Width * 2;   // Indent two character widths
+    text_layout.Top = CONTENT_Y_START;
+    text_layout.Bottom = FOOTER_Y_START - 5; // Ensure sufficient spacing from footer
+    // ASCII in CN lines is drawn with the CN font, reserve whichever is wider
+    text_layout.EnWidth = Font16.Width > cn_font->ASCII_Width ? Font16.Width : cn_font->ASCII_Width;
+    text_layout.EnHeight = Font16.Height;
+    text_layout.CnWidth = cn_font->Width;
+    text_layout.CnHeight = cn_font->Height;
+
+    // Everything that moves line or page breaks, a change here invalidates saved page indexes
+    const int32_t layout[] = {
+        EPD_7IN5_V2_WIDTH, EPD_7IN5_V2_HEIGHT, text_layout.LeftMargin, text_layout.MaxX, text_layout.Indent,
+        text_layout.Top, text_layout.Bottom, text_layout.EnWidth, text_layout.EnHeight,
+        text_layout.CnWidth, text_layout.CnHeight, MAX_PAGE_LINES, char_processor.is_gb2312,
+    };
+
+    // Reopening a known book: map the saved tables instead of laying it out again.
+    // The key hashes the glyph stream, which is all the layout ever sees.
+    paginate_have_key = Reader_Index_MakeKey(path, Reader_Glyph_Hash(&g_glyphs), layout, sizeof(layout), &paginate_key) == 0;
+    if (paginate_have_key && Reader_Index_Load(path, &paginate_key, &page_index) == 0) {
+        book_lines = page_index.Lines;
+        page_lines = page_index.Pages;
+        line_count = page_index.LineCount;
+        total_pages = page_index.Count;
+        paginated_bytes = g_processed_text_size;
+        pages_complete = 1;
+        printf("Loaded %d pages from page index\n", total_pages);
         return;
     }
-    
-    int count = 0;
-    size_t offset = 0;
-    
-    // Loop to calculate starting offset of each page
-    while (offset < g_processed_text_size) {
-        if(count >= (g_processed_text_size / 1000 + 100)) {
-            // If array capacity is insufficient, reallocate larger space
-            size_t *new_temp_offsets = realloc(temp_offsets, sizeof(size_t) * (count + 1000));
-            if(new_temp_offsets) {
-                temp_offsets = new_temp_offsets;
-            } else {
-                printf("Warning: Could not expand memory for page offsets, stop calculation at page %d\n", count);
-                break;
-            }
-        }
-        
-        temp_offsets[count++] = offset;
-        
-        // Use same display logic to calculate how many characters fit on one page
-        const int left_margin = 0;
-        const int max_x = EPD_7IN5_V2_WIDTH ;
-        
-        const int lh_en = Font16.Height;
-        const int lh_cn = Font12CN.Height;
-        
-        int y = CONTENT_Y_START + 10;
-        const int text_bottom = FOOTER_Y_START - 5;
-
-        // Calculate content for one page
-        int page_has_content = 0; // Flag to mark if this page has content
-        
-        while (offset < g_processed_text_size && y < text_bottom) {
-            int x = left_margin;
-            int has_cn = 0;
-
-            // Build a line of text until reaching maximum width or encountering paragraph end marker
-            while (offset < g_processed_text_size) {
-                unsigned char c = (unsigned char)g_processed_text[offset];
-                // Encounter paragraph end marker, move to next line
-                if (c == '\n') {
-                    offset++;  // Skip paragraph end marker
-                    // First line after paragraph needs indent, so set x to indent distance
-                    x = left_margin + (Font16.Width * 30);  // Indent 30 character widths
-                    continue;  // Continue to next iteration
-                }
-
-                // Modify: Use dynamic character length detection
-                int bytes = char_processor.char_len(g_processed_text, g_processed_text_size, offset);
 
-                int width = (bytes > 1) ? Font12CN.Width : Font16.Width;
-
-                if (x + width > max_x)
-                    break;  // Reached line width limit, move to next line
+    // Otherwise paginate in the background so the first page can be shown right away
+    snprintf(paginate_path, sizeof(paginate_path), "%s", path);
+    if (pthread_create(&paginate_thread, NULL, paginate_worker, NULL) == 0) {
+        paginate_thread_running = 1;
+    } else {
+        printf("Warning: Could not start pagination thread, paginating now\n");
+        paginate_worker(NULL);
+    }
+}
 
-                if (bytes > 1) has_cn = 1;
-                offset += bytes;
-                x += width;
-            }
+// Estimate the page count from the part of the book paginated so far (page_lock held)
+static int estimate_total_pages(void) {
+    if (pages_complete) return total_pages;
+    if (total_pages > 0 && paginated_bytes > 0) {
+        return (int)((double)g_processed_text_size * total_pages / paginated_bytes + 0.5);
+    }
+    return (g_processed_text_size / 2000) + 1;
+}
 
-            page_has_content = 1; // At least one line of content
-                
-            int lh = has_cn ? lh_cn : lh_en;
-            if (y + lh > text_bottom)
-                break;
+// Find the published page that starts exactly at offset (page_lock held), -1 if none
+static int find_page(size_t offset) {
+    int left = 0, right = total_pages - 1;
 
-            y += lh;
-        }
-        
-        // If this page has no content but there's still remaining text, the text exceeds page space
-        if(!page_has_content && offset < g_processed_text_size) {
-            printf("Warning: No content placed on page %d but text remains\n", count);
-            break;
-        }
-    }
-    
-    // Allocate exact size page offset array
-    total_pages = count;
-    page_offsets = malloc(sizeof(size_t) * total_pages);
-    if (page_offsets) {
-        memcpy(page_offsets, temp_offsets, sizeof(size_t) * total_pages);
-        printf("Successfully calculated %d pages\n", total_pages);
-    } else {
-        printf("Error: Could not allocate memory for page offsets\n");
+    while (left <= right) {
+        int mid = left + (right - left) / 2;
+        size_t start = book_lines[page_lines[mid]].Start;
+        if (start == offset) return mid;
+        if (start < offset) left = mid + 1;
+        else right = mid - 1;
     }
-    
-    free(temp_offsets);
+    return -1;
 }
 
 // Get current page index
 int get_current_page_index(size_t offset) {
-    if (!page_offsets || total_pages == 0) {
+    int result = 0;
+
+    pthread_mutex_lock(&page_lock);
+    if (!page_lines || total_pages == 0) {
         // If unable to get accurate page count, use estimation method
+        pthread_mutex_unlock(&page_lock);
         return (offset / 2000) + 1;
     }
-    
+
+    if (!pages_complete && offset >= paginated_bytes) {
+        // Page turns ran ahead of the worker: extrapolate from the pages known so far
+        size_t avg = paginated_bytes / total_pages;
+        result = total_pages + (int)((offset - paginated_bytes) / (avg ? avg : 1));
+        pthread_mutex_unlock(&page_lock);
+        return result + 1;
+    }
+
     // Binary search for page containing current offset
     int left = 0, right = total_pages - 1;
-    int result = 0;
     
     while (left <= right) {
         int mid = left + (right - left) / 2;
-        if (page_offsets[mid] <= offset) {
+        if (book_lines[page_lines[mid]].Start <= offset) {
             result = mid;
             if (mid < total_pages - 1) {
                 left = mid + 1;
@@ -418,106 +460,404 @@ int get_current_page_index(size_t offset) {
             }
         }
     }
+    pthread_mutex_unlock(&page_lock);
     
     return result + 1; // Page numbers start from 1
 }
 
-// Load entire TXT file to memory (GB2312 encoding)
+// Load a TXT file: map it, detect its encoding, normalize it and transcode it into g_glyphs.
+// Only the glyph stream stays resident, the mapping and the processed text are dropped on the way.
 int load_txt_file(const char* path) {
-    FILE* fp = fopen(path, "rb");
-    if (!fp) {
+    // The cache and pagination workers read the current text, stop them before anything is freed
+    Reader_Cache_Invalidate(&g_page_cache);
+    stop_pagination();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
         printf("Failed to open TXT: %s (errno=%d)\n", path, errno);
         return -1;
     }
 
-    fseek(fp, 0, SEEK_END);
-    long size = ftell(fp);
-    if (size <= 0 || size > MAX_BOOK_SIZE) {
-        fclose(fp);
-        printf("File too large or empty: %ld\n", size);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        printf("Failed to stat TXT: %s (errno=%d)\n", path, errno);
         return -1;
     }
-
-    if (g_full_text) free(g_full_text);
-    g_full_text = (char*)malloc(size + 1);
-    if (!g_full_text) {
-        fclose(fp);
-        printf("Malloc failed for text\n");
+    // Line offsets are 32-bit, that is the only size limit
+    if (st.st_size <= 0 || (uint64_t)st.st_size > UINT32_MAX) {
+        close(fd);
+        printf("File too large or empty: %lld\n", (long long)st.st_size);
         return -1;
     }
 
-    fseek(fp, 0, SEEK_SET);
-    size_t read_bytes = fread(g_full_text, 1, size, fp);
-    fclose(fp);
-
-    if (read_bytes != (size_t)size) {
-        free(g_full_text);
-        g_full_text = NULL;
+    size_t size = (size_t)st.st_size;
+    char* raw = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (raw == MAP_FAILED) {
+        printf("Failed to map TXT: %s (errno=%d)\n", path, errno);
         return -1;
     }
-    g_full_text[read_bytes] = '\0';
-    g_text_size = read_bytes;
-
-    // Add: Detect file encoding
-    int is_gb2312 = detect_file_encoding(g_full_text, g_text_size);
+    madvise(raw, size, MADV_SEQUENTIAL);
+    g_full_text = raw;
+    g_text_size = size;
+
+    // Detect the encoding over the whole file, unless the page index already knows it
+    int cached = Reader_Index_LoadEncoding(path, &book_encoding) == 0;
+    if (!cached)
+        Reader_Encoding_Detect(g_full_text, g_text_size, &book_encoding);
+    // GBK shares the GB2312 character lengths
+    int is_gb2312 = book_encoding.Encoding != READER_ENCODING_UTF8;
     char_processor.char_len = is_gb2312 ? 
         (int (*)(const char*, size_t, size_t))gb2312_char_len : 
         utf8_char_len_pos;
     char_processor.is_gb2312 = is_gb2312;
     
-    printf("Detected file encoding: %s\n", is_gb2312 ? "GB2312" : "UTF-8");
+    printf("%s file encoding: %s (confidence %u%%)\n", cached ? "Cached" : "Detected",
+           Reader_Encoding_Name(book_encoding.Encoding), book_encoding.Confidence);
 
     // Process text: remove extra line breaks, merge paragraphs
-    if (g_processed_text) free(g_processed_text);
-    g_processed_text = process_text_content(g_full_text, g_text_size);
-    if (!g_processed_text) {
+    Reader_Glyph_Free(&g_glyphs);
+    char* processed = process_text_content(g_full_text, g_text_size, &g_processed_text_size, 1);
+    munmap(raw, size);
+    g_full_text = NULL;
+    if (!processed) {
         printf("Failed to process text content\n");
         return -1;
     }
-    g_processed_text_size = strlen(g_processed_text);
+
+    // Decode every character once, layout and drawing only see glyph IDs from here on
+    int transcoded = Reader_Glyph_Transcode(processed, g_processed_text_size, book_encoding.Encoding,
+                                            cn_font, &g_glyphs);
+    free(processed);
+    if (transcoded != 0) {
+        printf("Failed to transcode text content\n");
+        return -1;
+    }
 
     // Reset status
     g_current_char_offset = 0;
     history_top = -1; // Clear history
+    pending_turns = 0;
     first_display_done = 0;
     
     // Calculate page info
-    calculate_page_info();
+    calculate_page_info(path);
     current_page_index = 1;  // Reset to first page
 
-    printf("Loaded %zu bytes from %s, processed to %zu bytes\n", g_text_size, path, g_processed_text_size);
+    printf("Loaded %zu bytes from %s, processed to %zu bytes (%u glyphs)\n", g_text_size, path,
+           g_processed_text_size, g_glyphs.Count);
     return 0;
 }
 
+// Turn what was drawn into the panel frame, the only per-pixel work of a rotated screen
+static UBYTE *flush_frame(void)
+{
+    Paint_FlushImage(g_frame_buffer);
+    Paint_ClearDirty();  // All of it goes to the panel
+    Frame_Diff(g_frame_buffer, g_prev_frame_buffer, EPD_7IN5_V2_WIDTH / 8, EPD_7IN5_V2_HEIGHT, &g_frame_diff);
+    g_panel_shows_draw = 1;
+    return g_frame_buffer;
+}
+
+// Partial refresh of one window of g_frame_buffer, every partial refresh runs a whole waveform
+static void refresh_window(const PAINT_RECT *box, const char *from)
+{
+    // The window covers whole bytes; its rows are copied for the display thread, the next
+    // page is prepared while the panel refreshes
+    UDOUBLE bytes = (UDOUBLE)(box->Xend - box->Xstart) / 8 * (box->Yend - box->Ystart);
+
+    Reader_Display_Window(&g_display, g_frame_buffer, box->Xstart, box->Ystart, box->Xend, box->Yend);
+    printf("Refresh %dx%d at (%d,%d) from %s: %lu SPI bytes, %.0f%% of the screen\n",
+           box->Xend - box->Xstart, box->Yend - box->Ystart, box->Xstart, box->Ystart, from, (unsigned long)bytes,
+           100.0 * bytes / (EPD_7IN5_V2_WIDTH / 8 * EPD_7IN5_V2_HEIGHT));
+}
+
+// Partial refresh of the rows and columns g_frame_diff found changed in g_frame_buffer
+static void refresh_diff(void)
+{
+    PAINT_RECT box;
+
+    if (g_frame_diff.Runs == 0) {
+        printf("Refresh: frame unchanged, skipped\n");
+        return;
+    }
+    box.Xstart = g_frame_diff.Xstart;
+    box.Xend = g_frame_diff.Xend;
+    box.Ystart = g_frame_diff.Ystart;
+    box.Yend = g_frame_diff.Yend;
+    refresh_window(&box, "frame compare");
+}
+
+/* Partial refresh of what was drawn since the last refresh. Over the frame the panel shows,
+ * only the boxes drawn can have changed: their union is the window and only its rows are
+ * kept as the previous frame. After a page from the cache the frames are compared instead */
+static void refresh_dirty(void)
+{
+    PAINT_RECT box;
+    UDOUBLE row_bytes = EPD_7IN5_V2_WIDTH / 8;
+
+    if (Paint_GetDirty(&box, 1) == 0) {
+        printf("Refresh: nothing drawn\n");
+        return;
+    }
+    if (!g_panel_shows_draw) {
+        flush_frame();
+        refresh_diff();
+        return;
+    }
+    Paint_FlushImage(g_frame_buffer);
+    Paint_ClearDirty();
+    memcpy(g_prev_frame_buffer + box.Ystart * row_bytes, g_frame_buffer + box.Ystart * row_bytes,
+           (box.Yend - box.Ystart) * row_bytes);
+    refresh_window(&box, "dirty boxes");
+}
+
+// Whatever drew over g_draw_buffer below the header, the next page clears all of it
+static void forget_page_ink(void)
+{
+    static const PAINT_RECT all[2] = PAGE_INK_ALL;
+
+    memcpy(g_page_ink, all, sizeof(g_page_ink));
+}
+
+// Panel operations of the display thread, each returns once the panel is idle. Frames go
+// out with the _Async calls, the driver's watcher thread then waits out BUSY
+#define PANEL_WAKE_FAST 0  // For full refreshes
+#define PANEL_WAKE_PART 1  // For page turns
+
+static void panel_full(void *arg, const uint8_t *frame)
+{
+    (void)arg;
+    EPD_7IN5_V2_Display_Async(frame);
+    EPD_7IN5_V2_WaitIdle();
+}
+
+static void panel_window(void *arg, const uint8_t *frame, uint16_t x_start, uint16_t y_start,
+                         uint16_t x_end, uint16_t y_end)
+{
+    (void)arg;
+    EPD_7IN5_V2_Display_Window_Async(frame, x_start, y_start, x_end, y_end);
+    EPD_7IN5_V2_WaitIdle();
+}
+
+static void panel_sleep(void *arg)
+{
+    (void)arg;
+    EPD_7IN5_V2_Sleep();
+}
+
+static void panel_wake(void *arg, int mode)
+{
+    (void)arg;
+    if (mode == PANEL_WAKE_FAST)
+        EPD_7IN5_V2_Init_Fast();
+    else
+        EPD_7IN5_V2_Init_Part();
+}
+
+static void panel_clear(void *arg)
+{
+    (void)arg;
+    EPD_7IN5_V2_Clear();
+}
+
+static const READER_DISPLAY_OPS panel_ops = {
+    panel_full, panel_window, panel_sleep, panel_wake, panel_clear
+};
+
+// Queued to started and started to idle, for the commands that refresh the panel
+static void report_display(void)
+{
+    static const char *names[READER_DISPLAY_COMMANDS] = {"full", "window", "sleep", "wake", "clear"};
+    READER_DISPLAY_STATS stats;
+    int i;
+
+    Reader_Display_GetStats(&g_display, &stats);
+    for (i = 0; i < READER_DISPLAY_COMMANDS; i++) {
+        READER_DISPLAY_TIMES *t = &stats.Command[i];
+        if (t->Count == 0)
+            continue;
+        printf("Display %-6s x%-4u queued %6.1f ms avg %6.1f max, refresh %6.1f ms avg %6.1f max\n",
+               names[i], t->Count, t->WaitSum / 1e6 / t->Count, t->WaitMax / 1e6,
+               t->RunSum / 1e6 / t->Count, t->RunMax / 1e6);
+    }
+}
+
 void show_error(const char* msg) {
     printf("ERROR: %s\n", msg);
-    if (g_frame_buffer == NULL) return;
-    Paint_SelectImage(g_frame_buffer);
+    if (g_frame_buffer == NULL || g_draw_buffer == NULL) return;
+    Reader_Cache_Invalidate(&g_page_cache);  // The worker copies the header from g_draw_buffer
+    Paint_SelectImage(g_draw_buffer);
     Paint_Clear(WHITE);
+    forget_page_ink();
     Paint_DrawString_EN(10, 10, "ERROR", &Font16, BLACK, WHITE);
     Paint_DrawString_EN(10, 40, msg, &Font16, BLACK, WHITE);
-    EPD_7IN5_V2_Display(g_frame_buffer);
+    Reader_Display_Full(&g_display, flush_frame());
     sleep(3);
 }
 
+/* Lines of the page at start_offset, from the line table once the worker has laid it
+ * out, else laid out here with the same engine. Sets where the next page starts */
+static int layout_page(size_t start_offset, READER_LINE *lines, size_t *next_offset)
+{
+    int line_num = 0;
+
+    *next_offset = g_processed_text_size;
+    pthread_mutex_lock(&page_lock);
+    int page_no = find_page(start_offset);
+    if (page_no >= 0) {
+        uint32_t first = page_lines[page_no];
+        uint32_t end = (page_no + 1 < total_pages) ? page_lines[page_no + 1] : line_count;
+        line_num = (int)(end - first);
+        if (line_num > MAX_PAGE_LINES) line_num = MAX_PAGE_LINES;
+        memcpy(lines, book_lines + first, sizeof(READER_LINE) * line_num);
+    }
+    pthread_mutex_unlock(&page_lock);
+
+    if (line_num > 0) {
+        *next_offset = Reader_Line_End(&lines[line_num - 1]);
+    } else {
+        uint32_t next_glyph;
+        line_num = Reader_Layout_Page(&text_layout, &g_glyphs, Reader_Glyph_Find(&g_glyphs, start_offset),
+                                      lines, MAX_PAGE_LINES, &next_glyph);
+        *next_offset = Reader_Glyph_Offset(&g_glyphs, next_glyph);
+    }
+    return line_num;
+}
+
+/* Text and footer of the page at start_offset, into any painter context.
+ * Only the text rows and footer box of the page drawn before are cleared, ink keeps them
+ * per context. The rest below the header stays as cleared, so a page drawn ahead by the
+ * cache worker comes out as a page turn would draw it, and only what the two pages cover
+ * is dirty. Returns starting offset of next page */
+static size_t draw_page(PAINT *paint, PAINT_RECT *ink, size_t start_offset)
+{
+    for (int k = 0; k < 2; k++) {
+        if (ink[k].Yend > ink[k].Ystart)
+            Paint_ClearWindows_Ctx(paint, ink[k].Xstart, ink[k].Ystart, ink[k].Xend, ink[k].Yend, BLACK);
+    }
+
+    /* =====================================================
+     * 4. Text layout drawing
+     * ===================================================== */
+    READER_LINE lines[MAX_PAGE_LINES];
+    size_t next_offset;
+    int line_num = layout_page(start_offset, lines, &next_offset);
+
+    int y = text_layout.Top;
+    for (int k = 0; k < line_num; k++) {
+        int x = text_layout.LeftMargin + ((lines[k].Flags & READER_LINE_INDENT) ? text_layout.Indent : 0);
+        // Lines may come from a sidecar file, never draw past the glyph stream
+        if (lines[k].Glyph <= g_glyphs.Count && lines[k].Glyphs <= g_glyphs.Count - lines[k].Glyph) {
+            const UWORD *glyphs = g_glyphs.Ids + lines[k].Glyph;
+            if (lines[k].Flags & READER_LINE_CN)
+                Paint_DrawGlyphs_CN_Ctx(paint, x, y, glyphs, lines[k].Glyphs, cn_font, WHITE, BLACK);
+            else
+                Paint_DrawGlyphs_EN_Ctx(paint, x, y, glyphs, lines[k].Glyphs, &Font16, WHITE, BLACK);
+        }
+
+        y += lines[k].Height;
+    }
+    ink[0].Xstart = 0;
+    ink[0].Ystart = text_layout.Top;
+    ink[0].Xend = EPD_7IN5_V2_WIDTH;
+    ink[0].Yend = y;
+
+    // Use accurate page count calculation, estimated while the worker is still paginating
+    int cur_page = get_current_page_index(start_offset);
+    pthread_mutex_lock(&page_lock);
+    int complete = pages_complete;
+    int total_pages_calc = estimate_total_pages();
+    pthread_mutex_unlock(&page_lock);
+    if (cur_page > total_pages_calc) total_pages_calc = cur_page;
+
+    char page[64];
+    if (complete)
+        snprintf(page, sizeof(page), "Page %d / %d", cur_page, total_pages_calc);
+    else
+        snprintf(page, sizeof(page), "Page %d / ~%d (estimating)", cur_page, total_pages_calc);
+
+    ink[1].Xstart = EPD_7IN5_V2_WIDTH - 10 - (int)strlen(page) * Font16.Width;
+    ink[1].Ystart = FOOTER_Y_START + 5;  // Adjust page number Y coordinate to avoid overlapping with content
+    ink[1].Xend = EPD_7IN5_V2_WIDTH - 10;
+    ink[1].Yend = ink[1].Ystart + Font16.Height;
+    Paint_DrawString_EN_Ctx(paint, ink[1].Xstart, ink[1].Ystart, page, &Font16, BLACK, WHITE);
+    return next_offset;
+}
+
+// Cache worker: the page at key with the header as shown, drawn as a page turn draws it.
+// Header rows of g_draw_buffer only change after Reader_Cache_Invalidate().
+static int render_cached_page(void *arg, uint32_t key, UBYTE *frame, uint32_t *next)
+{
+    (void)arg;
+    memcpy(g_cache_draw_buffer, g_draw_buffer, (size_t)g_cache_paint.WidthByte * CONTENT_Y_START);
+    *next = (uint32_t)draw_page(&g_cache_paint, g_cache_page_ink, key);
+    Paint_ClearDirty_Ctx(&g_cache_paint);
+    Paint_FlushImage_Ctx(&g_cache_paint, frame);
+    return 0;
+}
+
+// Offset the page after page_no starts at, as draw_page() returns it (page_lock held)
+static uint32_t page_end_offset(int page_no)
+{
+    uint32_t end = (page_no + 1 < total_pages) ? page_lines[page_no + 1] : line_count;
+    return Reader_Line_End(&book_lines[end - 1]);
+}
+
+// Page turn queued: have the cache worker render the pages around the one at start_offset.
+// Only once pagination is done, before that the page count of a footer drawn ahead goes stale.
+static void prefetch_pages(size_t start_offset)
+{
+    uint32_t keys[PAGE_CACHE_AHEAD + PAGE_CACHE_BEHIND + 1];
+    int count = 0;
+
+    pthread_mutex_lock(&page_lock);
+    int page_no = pages_complete ? find_page(start_offset) : -1;
+    if (page_no >= 0) {
+        for (int k = 0; k < PAGE_CACHE_AHEAD && page_no + k + 1 < total_pages; k++)
+            keys[count++] = page_end_offset(page_no + k);
+        for (int k = 1; k <= PAGE_CACHE_BEHIND && page_no - k >= 0; k++)
+            keys[count++] = page_no - k > 0 ? page_end_offset(page_no - k - 1) : 0;
+    }
+    pthread_mutex_unlock(&page_lock);
+    Reader_Cache_Want(&g_page_cache, keys, count);
+}
+
+static void report_page_cache(int hit)
+{
+    READER_CACHE_STATS stats;
+
+    Reader_Cache_GetStats(&g_page_cache, &stats);
+    printf("Page cache %s: %u hits, %u misses (%.0f%%), %u rendered, %u unused, depth +%d/-%d, "
+           "%u pages in %u KB\n",
+           hit ? "hit" : "miss", stats.Hits, stats.Misses,
+           100.0 * stats.Hits / (stats.Hits + stats.Misses ? stats.Hits + stats.Misses : 1),
+           stats.Rendered, stats.Wasted, PAGE_CACHE_AHEAD, PAGE_CACHE_BEHIND, stats.Pages, stats.Bytes / 1024);
+}
+
 /* Core: Draw one page from specified offset and return starting offset of next page */
 size_t display_txt_page_from_offset(size_t start_offset)
 {
     // Use processed text instead of original text
-    if (!g_processed_text || start_offset >= g_processed_text_size) {
-        Paint_SelectImage(g_frame_buffer);
+    if (!g_glyphs.Ids || start_offset >= g_processed_text_size) {
+        Reader_Cache_Invalidate(&g_page_cache);
+        Paint_SelectImage(g_draw_buffer);
         Paint_Clear(WHITE);
-        EPD_7IN5_V2_Display(g_frame_buffer);
+        forget_page_ink();
+        Reader_Display_Full(&g_display, flush_frame());
         return g_processed_text_size;
     }
 
-    Paint_SelectImage(g_frame_buffer);
+    Paint_SelectImage(g_draw_buffer);
 
     /* =====================================================
      * 1. First display or book switch: Full screen initialization
      * ===================================================== */
     if (!first_display_done || book_changed) {
+        Reader_Cache_Invalidate(&g_page_cache);  // Pages drawn ahead carry the old header
         Paint_Clear(WHITE);
+        forget_page_ink();
 
         /* Header —— Permanent area */
         char title[512];
@@ -544,10 +884,10 @@ size_t display_txt_page_from_offset(size_t start_offset)
             DOT_PIXEL_1X1,
             LINE_STYLE_SOLID
         );
-        EPD_7IN5_V2_Init_Fast();
-        EPD_7IN5_V2_Clear();
-        EPD_7IN5_V2_Display(g_frame_buffer);
-        EPD_7IN5_V2_Init_Part();
+        Reader_Display_Wake(&g_display, PANEL_WAKE_FAST);
+        Reader_Display_Clear(&g_display);
+        Reader_Display_Full(&g_display, flush_frame());
+        Reader_Display_Wake(&g_display, PANEL_WAKE_PART);
 
         first_display_done = 1;
         book_changed = 0;
@@ -558,6 +898,7 @@ size_t display_txt_page_from_offset(size_t start_offset)
          * 2. Ensure Header area always exists
          *    Including cases where header needs to be redrawn after screen-off recovery
          * ===================================================== */
+        Reader_Cache_Invalidate(&g_page_cache);  // Pages drawn ahead carry the old header
         // Clear header area
         // Paint_ClearWindows(0, 0, EPD_7IN5_V2_WIDTH, HEADER_HEIGHT + 5, WHITE);
         // Add: Clear content area and footer area
@@ -596,126 +937,27 @@ size_t display_txt_page_from_offset(size_t start_offset)
     }
     else {
         /* =================================================
-         * 3. Page turning: Only clear CONTENT + FOOTER (not Header)
-         *    But skip during screen-off recovery
+         * 3. Page turning: Only CONTENT + FOOTER change (not Header)
+         *    A page the cache worker drew ahead only has to go to the panel
          * ================================================= */
-        Paint_ClearWindows(
-            0,
-            CONTENT_Y_START,
-            EPD_7IN5_V2_WIDTH,
-            EPD_7IN5_V2_HEIGHT-CONTENT_Y_START,
-            BLACK
-        );
-    }
-
-    /* =====================================================
-     * 4. Text layout drawing
-     * ===================================================== */
-    const int left_margin = 0;
-    const int max_x = EPD_7IN5_V2_WIDTH;
-
-    const int lh_en = Font16.Height;
-    const int lh_cn = Font12CN.Height;
-
-    // Modify: Correct content area start Y coordinate to ensure sufficient spacing from footer
-    int y = CONTENT_Y_START;  // Removed +10 extra margin to bring text closer to top
-    const int text_bottom = FOOTER_Y_START-5; // Adjust to -5 to ensure sufficient spacing from footer
-
-    // Use processed text
-    size_t i = start_offset;
-
-    // Record starting position before entering loop
-    size_t initial_i = i;
-
-    while (i < g_processed_text_size && y < text_bottom) {
-        int x = left_margin;
-        char line[512] = {0};
-        int len = 0;
-        int has_cn = 0;
-
-        // Build a line of text until reaching maximum width or encountering paragraph end marker
-        while (i < g_processed_text_size) {
-            unsigned char c = (unsigned char)g_processed_text[i];
-            // Encounter paragraph end marker, move to next line
-            if (c == '\n') {
-                i++;  // Skip paragraph end marker
-                // First line after paragraph needs indent, so set x to indent distance
-                x = left_margin + (Font16.Width * 2);  // Indent two character widths
-                continue;  // Continue to next iteration
-            }
-
-            // Modify: Use boundary-checked character length detection
-            int bytes = char_processor.char_len(g_processed_text, g_processed_text_size, i);
-
-            int width = (bytes > 1) ? Font12CN.Width : Font16.Width;
-
-            if (x + width > max_x)
-                break;  // Reached line width limit, move to next line
-
-            for (int k = 0; k < bytes && i + k < g_processed_text_size; k++)
-                line[len++] = g_processed_text[i + k];
-
-            if (bytes > 1) has_cn = 1;
-            i += bytes;
-            x += width;
+        uint32_t next;
+        // Unpacked row by row into the frame the window is sent from
+        if (Reader_Cache_Take(&g_page_cache, start_offset, g_frame_buffer, &next)) {
+            Frame_Diff(g_frame_buffer, g_prev_frame_buffer, EPD_7IN5_V2_WIDTH / 8, EPD_7IN5_V2_HEIGHT, &g_frame_diff);
+            g_panel_shows_draw = 0;  // g_draw_buffer still holds the page drawn before
+            refresh_diff();
+            report_page_cache(1);
+            prefetch_pages(start_offset);
+            return next;
         }
-
-        if (len > 0) {
-            int lh = has_cn ? lh_cn : lh_en;
-            if (y + lh > text_bottom)
-                break;
-
-            line[len] = '\0';
-            if (has_cn)
-                Paint_DrawString_CN(left_margin, y, line, &Font12CN, WHITE,BLACK);
-            else
-                Paint_DrawString_EN(left_margin, y, line, &Font16, BLACK, WHITE);
-
-            y += lh;
-        }
-
-        // If no progress was made in the loop (i did not increase), break to prevent infinite loop
-        if (i == initial_i && i < g_processed_text_size) {
-            // Skip one character to prevent infinite loop
-            int char_bytes = char_processor.char_len(g_processed_text, g_processed_text_size, i);
-            i += char_bytes;  // Skip the character based on detected encoding
-        }
-    }
-    if (y < FOOTER_Y_START) {
-            Paint_ClearWindows(
-                0,
-                y,
-                EPD_7IN5_V2_WIDTH,
-                FOOTER_Y_START,
-                BLACK
-            );
+        report_page_cache(0);
     }
-        
 
-    // Use accurate page count calculation
-    int cur_page = get_current_page_index(start_offset);
-    int total_pages_calc = total_pages > 0 ? total_pages : (g_processed_text_size / 2000) + 1;
+    size_t next_offset = draw_page(&Paint, g_page_ink, start_offset);
 
-    char page[64];
-    snprintf(page, sizeof(page), "Page %d / %d", cur_page, total_pages_calc);
-
-    Paint_DrawString_EN(
-        EPD_7IN5_V2_WIDTH - 160,
-        FOOTER_Y_START+5,  // Adjust page number Y coordinate to avoid overlapping with content
-        page,
-        &Font16,
-        BLACK,
-        WHITE
-    );
-
-        EPD_7IN5_V2_Display_Part(
-            g_frame_buffer,
-            0,
-            0,  // Starting from top, including Header
-            EPD_7IN5_V2_WIDTH,
-            EPD_7IN5_V2_HEIGHT // Refresh entire screen height
-        );
-    return i;  // Return actual ending offset
+    refresh_dirty();  // Header, content and footer, as far as they were drawn
+    prefetch_pages(start_offset);
+    return next_offset;  // Return actual ending offset
 }
 
 // Enter screen-off mode
@@ -724,16 +966,20 @@ void enter_screen_off_mode() {
 
     printf("Entering screen off mode...\n");
     screen_off = 1;
+    pending_turns = 0;  // Turns asked for before the screen went off are dropped
+    Reader_Cache_Invalidate(&g_page_cache);  // The whole draw buffer, header included, is drawn over
     // Create screen-off image
-    Paint_SelectImage(g_frame_buffer);
+    Paint_SelectImage(g_draw_buffer);
     Paint_Clear(WHITE);
+    forget_page_ink();
     
         // Display screen-off image using GUI_ReadBmp function
     GUI_ReadBmp_Scale_Centered("/home/pi/e-ink-reader/demo-inkscreen-reader/components/e-Paper/Quectel-Pi-H1/c/pic/2.bmp", 0, 0,EPD_7IN5_V2_WIDTH,EPD_7IN5_V2_HEIGHT,0.7) ;
     
     // Display screen-off image
-    EPD_7IN5_V2_Display(g_frame_buffer);
-    // EPD_7IN5_V2_Sleep(); // Enter sleep mode to save power
+    Reader_Display_Full(&g_display, flush_frame());
+    // Reader_Display_Sleep(&g_display); // Enter sleep mode to save power
+    report_display();
 }
 
 // Exit screen-off mode (optimized version)
@@ -743,7 +989,7 @@ void exit_screen_off_mode() {
     printf("Exiting screen off mode...\n");
     screen_off = 0;
     // Fast wake up: only initialize partial refresh mode
-    EPD_7IN5_V2_Init_Part();
+    Reader_Display_Wake(&g_display, PANEL_WAKE_PART);
     
     // Set flags to ensure only content and footer are refreshed
     first_display_done = 1;
@@ -751,7 +997,7 @@ void exit_screen_off_mode() {
     header_drawn = 0;  // Mark only that header needs to be redrawn, handled by display_txt_page_from_offset
 
     // Use fast recovery: directly refresh current page
-      if (g_frame_buffer && g_processed_text) {
+      if (g_frame_buffer && g_glyphs.Ids) {
         // Directly call display_txt_page_from_offset, which will redraw Header based on header_drawn=0
         display_txt_page_from_offset(g_current_char_offset);
     }
@@ -841,6 +1087,59 @@ void prev_book() {
     }
 }
 
+/* Show the page the pending turns lead to. Pages skipped forward are only laid out to find
+ * where the next one starts, and go on the history so that back steps through them */
+static void turn_pages(void)
+{
+    int turns = pending_turns;
+
+    pending_turns = 0;
+    if (turns > 0) {
+        if (g_current_char_offset >= g_processed_text_size) {
+            printf("End of book.\n");
+            return;
+        }
+        size_t start = g_current_char_offset;
+        for (int k = 1; k < turns; k++) {
+            READER_LINE lines[MAX_PAGE_LINES];
+            size_t next;
+            layout_page(start, lines, &next);
+            if (next >= g_processed_text_size) break;  // Stop at the last page
+            if (history_top < MAX_HISTORY - 1) {
+                history_stack[++history_top] = start;
+            }
+            start = next;
+        }
+        if (history_top < MAX_HISTORY - 1) {
+            history_stack[++history_top] = start;
+        }
+        g_current_char_offset = display_txt_page_from_offset(start);
+        printf("Next page (%d turns) at offset %zu\n", turns, start);
+    } else if (turns < 0) {
+        // The top entry is the page shown, the one below it the page before
+        if (history_top < 1) {
+            printf("Already at first page.\n");
+            return;
+        }
+        history_top += turns;
+        if (history_top < 0) history_top = 0;
+        g_current_char_offset = display_txt_page_from_offset(history_stack[history_top]);
+        printf("Back %d pages to offset %zu\n", -turns, history_stack[history_top]);
+    }
+}
+
+/* A next or previous page key. With the panel busy the turn only moves where the next
+ * refresh will land, the main loop shows it once the panel is idle */
+static void request_turn(int dir)
+{
+    pending_turns += dir;
+    if (Reader_Display_Busy(&g_display)) {
+        printf("Panel busy, %d page turns pending\n", pending_turns);
+        return;
+    }
+    turn_pages();
+}
+
 // New: Key state tracking structure
 typedef struct {
     struct timeval press_time;
@@ -848,7 +1147,35 @@ typedef struct {
     int key_id;
 } KeyState;
 
-static KeyState key_states[3] = {0}; // Index 0 unused, 1=KEY1, 2=KEY2
+static KeyState key_states[4] = {0}; // Index 0 unused, 1=KEY1, 2=KEY2, 3=eye control next page
+
+// Arm the long press timer for a page key just pressed, 0 disarms it
+static void arm_long_press(int key_id)
+{
+    struct itimerspec spec = {0};
+
+    if (long_press_fd < 0) return;
+    if (key_id) {
+        spec.it_value.tv_sec = LONG_PRESS_MS / 1000;
+        spec.it_value.tv_nsec = (LONG_PRESS_MS % 1000) * 1000000L;
+    }
+    long_press_key = key_id;
+    timerfd_settime(long_press_fd, 0, &spec, NULL);
+}
+
+// The long press timer went off: the key still held switches books without waiting for its release
+static void handle_long_press(void)
+{
+    uint64_t expirations;
+    int key_id = long_press_key;
+
+    if (read(long_press_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+    long_press_key = 0;
+    if (key_id == 0 || !key_states[key_id].pressed) return;
+    key_states[key_id].pressed = 0;  // Its release is not a page turn
+    if (key_id == 1) next_book();
+    else prev_book();
+}
 
 // New: Key event handling function
 void handle_key_event(int key_id, struct input_event *ev) {
@@ -892,9 +1219,12 @@ void handle_key_event(int key_id, struct input_event *ev) {
     if (ev->value == 1) {  // key down
         gettimeofday(&key_states[key_id].press_time, NULL);
         key_states[key_id].pressed = 1;
+        // A virtual key may never be released, its presses are only timed on release as before
+        if (key_id != 3) arm_long_press(key_id);
     }
     else if (ev->value == 0 && key_states[key_id].pressed) { // key up
         struct timeval now;
+        if (long_press_key == key_id) arm_long_press(0);
         gettimeofday(&now, NULL);
 
         long press_ms =
@@ -903,85 +1233,113 @@ void handle_key_event(int key_id, struct input_event *ev) {
 
         key_states[key_id].pressed = 0;
 
-        if (press_ms > 1000) {
-            if (key_id == 1) next_book();
-            else prev_book();
+        if (press_ms > LONG_PRESS_MS) {  // The timer was not served in time
+            if (key_id == 2) prev_book();
+            else next_book();
         } else {
-            if (key_id == 1) {
-                if (g_current_char_offset < g_processed_text_size) {
-                    if (history_top < MAX_HISTORY - 1) {
-                        history_stack[++history_top] = g_current_char_offset;
-                    }
-                    size_t next_offset = display_txt_page_from_offset(g_current_char_offset);
-                    g_current_char_offset = next_offset;
-                    printf("Next page from key1 at offset %zu\n", g_current_char_offset);
-                } else {
-                    printf("End of book.\n");
-                }
-            } else {
-                if (history_top > -1) {
-                    g_current_char_offset = history_stack[history_top--];
-                    display_txt_page_from_offset(g_current_char_offset);
-                    printf("Back to page at offset %zu\n", g_current_char_offset);
-                } else {
-                    printf("Already at first page.\n");
-                }
-            }
+            request_turn(key_id == 2 ? -1 : 1);
         }
     }
 }
 
-// Modify: Use poll mechanism to handle key events
-void handle_keys(void) {
-    struct pollfd fds[3];
-    struct input_event ev;
+// Events of the eye control device: screen off and on, and next page
+static void handle_eye_event(struct input_event *ev)
+{
+    if (ev->type != EV_KEY) return;
+    if (ev->code == CUSTOM_SCREEN_OFF_BTN && ev->value == 1) {
+        enter_screen_off_mode();
+    } else if (ev->code == CUSTOM_SCREEN_ON_BTN && ev->value == 1) {
+        exit_screen_off_mode();
+    } else if (ev->code == KEY_PAGEDOWN) {
+        handle_key_event(3, ev);  // Next page as KEY1, with a state of its own
+    }
+}
 
-    // Set up poll descriptors
-    fds[0].fd = key1_fd;
-    fds[0].events = POLLIN;
-    fds[1].fd = key2_fd;
-    fds[1].events = POLLIN;
+// What woke the main loop, in epoll_event.data.u32
+#define EVENT_KEY1          1
+#define EVENT_KEY2          2
+#define EVENT_EYE           3
+#define EVENT_LONG_PRESS    4
+#define EVENT_DISPLAY       5   // The display thread finished commands
 
-    // Add eye control device to poll
-    int num_fds = 2;
-    if (eye_key_fd >= 0) {
-        fds[2].fd = eye_key_fd;
-        fds[2].events = POLLIN;
-        num_fds = 3;
-    }
+static int watch_fd(int epfd, int fd, uint32_t event)
+{
+    struct epoll_event ev = {0};
 
-    // Non-blocking polling
-    int ret = poll(fds, num_fds, 0);
-    if (ret <= 0) return;
+    ev.events = EPOLLIN;
+    ev.data.u32 = event;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
 
-    // Handle KEY1 events
-    if (fds[0].revents & POLLIN) {
-        if (read(key1_fd, &ev, sizeof(ev)) == sizeof(ev)) {
-            handle_key_event(1, &ev);
-        }
+// An input device went away: stop watching it, it would otherwise report its hangup forever
+static void drop_fd(int epfd, int *fd, const char *name)
+{
+    printf("%s went away, closing it\n", name);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, *fd, NULL);
+    close(*fd);
+    *fd = -1;
+}
+
+/* Sleep until keys, the eye control device, the long press timer or the display thread
+ * need something, and drain every event of each fd that woke it. Returns on an error,
+ * or when a page key goes away; losing the eye control device only stops watching it */
+static void run_event_loop(void)
+{
+    struct epoll_event events[8];
+    struct input_event ev;
+    uint64_t count;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (epfd < 0 ||
+        watch_fd(epfd, key1_fd, EVENT_KEY1) != 0 ||
+        watch_fd(epfd, key2_fd, EVENT_KEY2) != 0 ||
+        (eye_key_fd >= 0 && watch_fd(epfd, eye_key_fd, EVENT_EYE) != 0) ||
+        (long_press_fd >= 0 && watch_fd(epfd, long_press_fd, EVENT_LONG_PRESS) != 0) ||
+        watch_fd(epfd, Reader_Display_Fd(&g_display), EVENT_DISPLAY) != 0) {
+        perror("epoll");
+        if (epfd >= 0) close(epfd);
+        return;
     }
 
-    // Handle KEY2 events
-    if (fds[1].revents & POLLIN) {
-        if (read(key2_fd, &ev, sizeof(ev)) == sizeof(ev)) {
-            handle_key_event(2, &ev);
+    while (key1_fd >= 0 && key2_fd >= 0) {
+        int n = epoll_wait(epfd, events, sizeof(events) / sizeof(events[0]), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
         }
-    }
+        for (int i = 0; i < n; i++) {
+            int gone = events[i].events & (EPOLLHUP | EPOLLERR);
 
-    // Handle eye control device events
-    if (num_fds > 2 && (fds[2].revents & POLLIN)) {
-        if (read(eye_key_fd, &ev, sizeof(ev)) == sizeof(ev)) {
-            if (ev.type == EV_KEY) {
-                if (ev.code == CUSTOM_SCREEN_OFF_BTN && ev.value == 1) {
-                    enter_screen_off_mode();
-                } else if (ev.code == CUSTOM_SCREEN_ON_BTN && ev.value == 1) {
-                    exit_screen_off_mode();
-                } else if (ev.code == KEY_PAGEDOWN) {
-                    handle_key_event(1, &ev); 
-                }
+            switch (events[i].data.u32) {
+            case EVENT_KEY1:
+                while (key1_fd >= 0 && read(key1_fd, &ev, sizeof(ev)) == sizeof(ev)) handle_key_event(1, &ev);
+                if (gone && key1_fd >= 0) drop_fd(epfd, &key1_fd, "KEY1");
+                break;
+            case EVENT_KEY2:
+                while (key2_fd >= 0 && read(key2_fd, &ev, sizeof(ev)) == sizeof(ev)) handle_key_event(2, &ev);
+                if (gone && key2_fd >= 0) drop_fd(epfd, &key2_fd, "KEY2");
+                break;
+            case EVENT_EYE:
+                // Screen off drains this fd itself, the loop then simply ends
+                while (eye_key_fd >= 0 && read(eye_key_fd, &ev, sizeof(ev)) == sizeof(ev)) handle_eye_event(&ev);
+                if (gone && eye_key_fd >= 0) drop_fd(epfd, &eye_key_fd, "Eye control device");
+                break;
+            case EVENT_LONG_PRESS:
+                handle_long_press();
+                break;
+            case EVENT_DISPLAY:
+                while (read(Reader_Display_Fd(&g_display), &count, sizeof(count)) == sizeof(count)) {}
+                break;
             }
         }
+        // Page turns that came in while the panel was busy, as soon as it is idle
+        if (pending_turns != 0 && !Reader_Display_Busy(&g_display)) {
+            turn_pages();
+        }
     }
+    if (key1_fd < 0 || key2_fd < 0) printf("Page key lost, leaving the event loop\n");
+    close(epfd);
 }
 
 // Main function
@@ -1007,8 +1365,8 @@ void EPD_7in5_V2_reader_txt(void) {
     DEV_GPIO_Init();
 #endif
     // Open physical key device
-    key1_fd = open("/dev/input/event3", O_RDONLY);
-    key2_fd = open("/dev/input/event1", O_RDONLY);
+    key1_fd = open("/dev/input/event3", O_RDONLY | O_NONBLOCK);
+    key2_fd = open("/dev/input/event1", O_RDONLY | O_NONBLOCK);
 
     if (key1_fd < 0 || key2_fd < 0) {
         printf("Physical key devices not found\n");
@@ -1027,6 +1385,14 @@ void EPD_7in5_V2_reader_txt(void) {
         }
     }
 
+    // Full GB2312/GBK coverage needs a font pack, it is only mapped, not read
+    if (Font_Pack_Open(CN_FONT_PACK, &cn_pack) == 0) {
+        cn_font = &cn_pack;
+        printf("CN font pack %s: %u glyphs, %ux%u\n", CN_FONT_PACK, cn_font->size, cn_font->Width, cn_font->Height);
+    } else {
+        printf("Warning: CN font pack %s not found, using the built-in CN font\n", CN_FONT_PACK);
+    }
+
     DIR* dir = opendir(BOOK_PATH);
     if (!dir) {
         show_error("Books dir not found");
@@ -1083,7 +1449,37 @@ void EPD_7in5_V2_reader_txt(void) {
         free(g_frame_buffer);
         goto cleanup;
     }
-    Paint_NewImage(g_frame_buffer, EPD_7IN5_V2_WIDTH, EPD_7IN5_V2_HEIGHT, ROTATE_180, WHITE);
+    memset(g_prev_frame_buffer, 0, Imagesize);  // Panel contents unknown, the first frame is shown whole
+    g_draw_buffer = (UBYTE *)malloc(Imagesize);
+    if (!g_draw_buffer) {
+        printf("Malloc for draw buffer failed\n");
+        goto cleanup;
+    }
+    // Nothing drives the panel yet, without the watcher the _Async calls block as before
+    if (EPD_7IN5_V2_Async_Start(NULL, NULL) < 0) {
+        printf("Warning: No refresh watcher, the display thread polls BUSY itself\n");
+    }
+    // Key handling only queues panel commands, a thread of their own waits out the refreshes
+    if (Reader_Display_Init(&g_display, EPD_7IN5_V2_WIDTH / 8, EPD_7IN5_V2_HEIGHT, &panel_ops, NULL) != 0) {
+        printf("Could not start the display thread\n");
+        goto cleanup;
+    }
+    // Draw upright, ROTATE_180 is applied to whole frames by flush_frame()
+    Paint_NewImage(g_draw_buffer, EPD_7IN5_V2_WIDTH, EPD_7IN5_V2_HEIGHT, ROTATE_180, WHITE);
+    Paint_DeferRotation();
+
+    // Pages around the one shown are drawn ahead by a worker with a context of its own,
+    // without it every page turn is drawn on the spot
+    g_cache_draw_buffer = (UBYTE *)malloc(Imagesize);
+    if (g_cache_draw_buffer && PAGE_CACHE_AHEAD + PAGE_CACHE_BEHIND > 0) {
+        Paint_NewImage_Ctx(&g_cache_paint, g_cache_draw_buffer, EPD_7IN5_V2_WIDTH, EPD_7IN5_V2_HEIGHT, ROTATE_180, WHITE);
+        Paint_DeferRotation_Ctx(&g_cache_paint);
+        // Slots past the pages wanted keep the pages just shown while the budget allows
+        if (Reader_Cache_Init(&g_page_cache, READER_CACHE_SLOTS, EPD_7IN5_V2_WIDTH / 8, EPD_7IN5_V2_HEIGHT,
+                              PAGE_CACHE_BUDGET, render_cached_page, NULL) != 0) {
+            printf("Warning: Could not start the page cache, pages are drawn on each turn\n");
+        }
+    }
 
     // Display first page - Ensure first display is correct
     g_current_char_offset = 0;  // Ensure starting from the beginning of the text
@@ -1094,19 +1490,32 @@ void EPD_7in5_V2_reader_txt(void) {
     }
 
     printf("Reader started. Books: %d\n", book_count);
-    while (1) {
-        handle_keys(); // Handle physical keys and virtual eye control keys
-        usleep(50000);
+    // Long presses are timed while held, not only measured once released
+    long_press_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (long_press_fd < 0) {
+        printf("Warning: No long press timer, books switch when the key is released\n");
     }
+    run_event_loop();
 
 cleanup:
-    free(g_full_text);
-    free(g_processed_text);  // Free processed text
-    free(page_offsets);      // Free page offset array
+    Reader_Cache_Free(&g_page_cache);  // Its worker reads the book, stop it first
+    stop_pagination();
+    Reader_Glyph_Free(&g_glyphs);  // Free glyph stream
+    Reader_Index_Free(&page_index);  // Free or unmap line and page tables
     free(g_frame_buffer);
     free(g_prev_frame_buffer);
+    free(g_draw_buffer);
+    free(g_cache_draw_buffer);
+    if (cn_font == &cn_pack) Font_Pack_Close(&cn_pack);
     if (key1_fd >= 0) close(key1_fd);
     if (key2_fd >= 0) close(key2_fd);
     if (eye_key_fd >= 0) close(eye_key_fd);
-    EPD_7IN5_V2_Sleep();
+    if (long_press_fd >= 0) close(long_press_fd);
+    // The display thread runs what is queued, sleep included, before it stops
+    if (Reader_Display_Sleep(&g_display) != 0)
+        EPD_7IN5_V2_Sleep();
+    Reader_Display_Wait(&g_display);
+    report_display();
+    Reader_Display_Free(&g_display);
+    EPD_7IN5_V2_Async_Stop();
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+/*****************************************************************************
+* | File      	:   fontpack.c
+* | Function    :   Binary CN font packs, mapped at runtime
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "fontpack.h"
+#include "Debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/******************************************************************************
+function:	Unpack PackBits data
+parameter:
+    src      : Packed bytes
+    src_size : Number of packed bytes
+    dst      : Receives the unpacked bytes
+    dst_size : Capacity of dst
+info:
+    A header byte n below 128 is followed by n + 1 literal bytes, one
+    above 128 by a byte repeated 257 - n times; 128 is skipped. Returns
+    the number of bytes unpacked, never more than dst_size.
+******************************************************************************/
+size_t Font_Pack_Unpack(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size)
+{
+    size_t i = 0, n = 0;
+
+    while (i < src_size && n < dst_size) {
+        uint8_t h = src[i++];
+        size_t run;
+
+        if (h < 128) {
+            run = (size_t)h + 1;
+            if (run > src_size - i)
+                run = src_size - i;
+            if (run > dst_size - n)
+                run = dst_size - n;
+            memcpy(dst + n, src + i, run);
+            i += (size_t)h + 1;
+        } else if (h > 128) {
+            if (i >= src_size)
+                break;
+            run = 257 - (size_t)h;
+            if (run > dst_size - n)
+                run = dst_size - n;
+            memset(dst + n, src[i++], run);
+        } else {
+            continue;
+        }
+        n += run;
+    }
+    return n;
+}
+
+/******************************************************************************
+function:	Open a font pack
+parameter:
+    path : .fpk file
+    font : Filled in on success, to be used like any cFONT
+info:
+    Only the header is read; the lookup and the glyphs are paged in as
+    they are used. Returns -1 if the file is missing or malformed.
+******************************************************************************/
+int Font_Pack_Open(const char *path, cFONT *font)
+{
+    const FONT_PACK_HEADER *hdr;
+    FONT_PACK *pack;
+    struct stat st;
+    size_t blocks, stored;
+    void *map;
+    int fd, i;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FONT_PACK_HEADER)) {
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    // Every table has to lie inside the file, the glyphs are only checked when unpacked
+    hdr = (const FONT_PACK_HEADER *)map;
+    blocks = (hdr->Count + FONT_PACK_BLOCK - 1) / FONT_PACK_BLOCK;
+    stored = (hdr->Flags & FONT_PACK_PACKBITS) ? hdr->DataSize : (size_t)hdr->Count * hdr->GlyphBytes;
+    if (hdr->Magic != FONT_PACK_MAGIC || hdr->Version != FONT_PACK_VERSION ||
+        hdr->Count == 0 || hdr->Count >= FONT_CN_NONE ||
+        hdr->Width == 0 || hdr->Width > MAX_WIDTH_FONT || hdr->Height == 0 || hdr->Height > MAX_HEIGHT_FONT ||
+        hdr->GlyphBytes != hdr->Height * ((hdr->Width + 7) / 8) ||
+        hdr->LookupOffset % 2 != 0 ||
+        (uint64_t)hdr->LookupOffset + sizeof(uint16_t) * FONT_CN_SLOTS > (uint64_t)st.st_size ||
+        ((hdr->Flags & FONT_PACK_PACKBITS) &&
+         (hdr->BlockOffset % 4 != 0 ||
+          (uint64_t)hdr->BlockOffset + sizeof(uint32_t) * (blocks + 1) > (uint64_t)st.st_size)) ||
+        hdr->DataSize < stored ||
+        (uint64_t)hdr->DataOffset + hdr->DataSize > (uint64_t)st.st_size) {
+        Debug("Bad font pack %s\r\n", path);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    pack = calloc(1, sizeof(FONT_PACK));
+    if (!pack) {
+        munmap(map, st.st_size);
+        return -1;
+    }
+    pack->Map = map;
+    pack->MapSize = st.st_size;
+    pack->Header = hdr;
+    pack->Data = (const uint8_t *)map + hdr->DataOffset;
+    if (hdr->Flags & FONT_PACK_PACKBITS) {
+        pack->Blocks = (const uint32_t *)((const uint8_t *)map + hdr->BlockOffset);
+        pack->Cache = malloc((size_t)FONT_PACK_CACHE * FONT_PACK_BLOCK * hdr->GlyphBytes);
+        if (!pack->Cache) {
+            free(pack);
+            munmap(map, st.st_size);
+            return -1;
+        }
+        for (i = 0; i < FONT_PACK_CACHE; i++)
+            pack->CacheBlock[i] = -1;
+    }
+    pthread_mutex_init(&pack->Lock, NULL);
+    // Glyphs are drawn in text order, not file order
+    madvise(map, st.st_size, MADV_RANDOM);
+
+    memset(font, 0, sizeof(*font));
+    font->table = NULL;
+    font->size = (uint16_t)hdr->Count;
+    font->ASCII_Width = hdr->ASCII_Width;
+    font->Width = hdr->Width;
+    font->Height = hdr->Height;
+    font->Lookup = (const uint16_t *)((const uint8_t *)map + hdr->LookupOffset);
+    font->Pack = pack;
+    return 0;
+}
+
+/******************************************************************************
+function:	Close a font pack opened with Font_Pack_Open()
+******************************************************************************/
+void Font_Pack_Close(cFONT *font)
+{
+    FONT_PACK *pack = (FONT_PACK *)font->Pack;
+
+    if (!pack)
+        return;
+    pthread_mutex_destroy(&pack->Lock);
+    free(pack->Cache);
+    munmap(pack->Map, pack->MapSize);
+    free(pack);
+    memset(font, 0, sizeof(*font));
+}
+
+/******************************************************************************
+function:	Bitmap of a glyph in a font pack
+parameter:
+    pack : Font pack
+    Num  : Glyph number
+    buf  : FONT_CN_GLYPH_MAX bytes, receives the glyph of a compressed pack
+info:
+    Uncompressed glyphs are returned straight from the mapping. A glyph of
+    a compressed pack is copied out of its unpacked block under the cache
+    lock, so several threads can draw from the same pack.
+******************************************************************************/
+const unsigned char *Font_Pack_Bitmap(const FONT_PACK *pack, int Num, unsigned char *buf)
+{
+    const FONT_PACK_HEADER *hdr = pack->Header;
+    FONT_PACK *cache = (FONT_PACK *)pack;   // The block cache is internal state
+    size_t block_bytes = (size_t)FONT_PACK_BLOCK * hdr->GlyphBytes;
+    int block = Num / FONT_PACK_BLOCK;
+    int slot = block % FONT_PACK_CACHE;
+    uint8_t *unpacked = cache->Cache + (size_t)slot * block_bytes;
+
+    if (Num < 0 || (uint32_t)Num >= hdr->Count)
+        return NULL;
+    if (!pack->Blocks)
+        return pack->Data + (size_t)Num * hdr->GlyphBytes;
+
+    pthread_mutex_lock(&cache->Lock);
+    if (cache->CacheBlock[slot] != block) {
+        uint32_t start = pack->Blocks[block], end = pack->Blocks[block + 1];
+        if (start > end || end > hdr->DataSize) {
+            pthread_mutex_unlock(&cache->Lock);
+            return NULL;
+        }
+        size_t n = Font_Pack_Unpack(pack->Data + start, end - start, unpacked, block_bytes);
+        memset(unpacked + n, 0, block_bytes - n);
+        cache->CacheBlock[slot] = block;
+    }
+    memcpy(buf, unpacked + (size_t)(Num % FONT_PACK_BLOCK) * hdr->GlyphBytes, hdr->GlyphBytes);
+    pthread_mutex_unlock(&cache->Lock);
+    return buf;
+}
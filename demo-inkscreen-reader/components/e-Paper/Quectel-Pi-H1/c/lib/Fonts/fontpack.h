@@ -0,0 +1,79 @@
+/*****************************************************************************
+* | File      	:   fontpack.h
+* | Function    :   Binary CN font packs, mapped at runtime
+* | Info        :
+*   A font pack holds a full GB2312 or GBK font outside the program. It is
+*   memory-mapped, so opening one reads only its header and a glyph costs
+*   a page fault the first time it is drawn. Layout of a .fpk file, all
+*   values little-endian:
+*
+*       FONT_PACK_HEADER
+*       uint16_t lookup[FONT_CN_SLOTS]  glyph number of each code, see Font_CN_Slot()
+*       uint32_t blocks[n + 1]          only if FONT_PACK_PACKBITS: offset of each
+*                                       block of FONT_PACK_BLOCK glyphs in the data
+*       glyph data                      GlyphBytes per glyph, rows padded to bytes
+*
+*   Every glyph is stored at the size of the font's cell (Width x Height)
+*   rather than the 166 bytes of a CH_CN entry: 24 bytes at 12 px, 32 at
+*   16 px, 72 at 24 px. With FONT_PACK_PACKBITS each block is PackBits
+*   compressed; a few unpacked blocks are kept in memory.
+*
+*   Packs are made with tools/fontpack_gen.c (make fontpack).
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __FONTPACK_H
+#define __FONTPACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "fonts.h"
+
+#define FONT_PACK_MAGIC         0x50465045  // "EPFP"
+#define FONT_PACK_VERSION       1
+#define FONT_PACK_PACKBITS      0x01        // Glyph data is PackBits compressed per block
+#define FONT_PACK_BLOCK         64          // Glyphs per compressed block
+#define FONT_PACK_CACHE         32          // Unpacked blocks kept in memory
+
+/**
+ * On-disk header
+**/
+typedef struct {
+    uint32_t Magic;
+    uint32_t Version;
+    uint16_t Width;         // Cell width, advance of CN characters
+    uint16_t Height;        // Cell height
+    uint16_t ASCII_Width;   // Advance of ASCII characters
+    uint16_t GlyphBytes;    // Height * ((Width + 7) / 8)
+    uint32_t Count;         // Number of glyphs
+    uint32_t Flags;         // FONT_PACK_*
+    uint32_t LookupOffset;
+    uint32_t BlockOffset;   // 0 without FONT_PACK_PACKBITS
+    uint32_t DataOffset;
+    uint32_t DataSize;
+    uint32_t Reserved[5];
+} FONT_PACK_HEADER;
+
+/**
+ * Mapped font pack
+**/
+typedef struct _tFontPack {
+    void *Map;
+    size_t MapSize;
+    const FONT_PACK_HEADER *Header;
+    const uint8_t *Data;
+    const uint32_t *Blocks;     // NULL if not compressed
+    pthread_mutex_t Lock;       // Guards the block cache
+    int32_t CacheBlock[FONT_PACK_CACHE];
+    uint8_t *Cache;             // FONT_PACK_CACHE unpacked blocks
+} FONT_PACK;
+
+int Font_Pack_Open(const char *path, cFONT *font);
+void Font_Pack_Close(cFONT *font);
+const unsigned char *Font_Pack_Bitmap(const FONT_PACK *pack, int Num, unsigned char *buf);
+size_t Font_Pack_Unpack(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+#endif
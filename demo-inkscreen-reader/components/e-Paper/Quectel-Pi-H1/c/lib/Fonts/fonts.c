@@ -0,0 +1,115 @@
+/*****************************************************************************
+* | File      	:   fonts.c
+* | Function    :   Character lookup in CN fonts
+* | Info        :
+*   A CN font table is a list of (code, bitmap) entries. Instead of
+*   searching it for every character drawn, a direct index is built once
+*   per font: one slot per ASCII code and one per GBK code, each holding
+*   the table index of that character (see Font_CN_Slot()). The index
+*   takes 48 KB and finding a character costs the same whatever the size
+*   of the font.
+*
+*   Font packs (fontpack.h) carry the same index ready made, mapped
+*   together with the glyphs.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "fonts.h"
+#include "fontpack.h"
+
+#include <stdlib.h>
+
+/******************************************************************************
+function:	Linear search of a CN font table, as Paint_DrawString_CN() used to do
+info:
+    ASCII entries are matched on their first byte only.
+******************************************************************************/
+static int Font_CN_Search(const cFONT *font, unsigned char hi, unsigned char lo)
+{
+    int Num;
+
+    for (Num = 0; Num < font->size && Num < FONT_CN_NONE; Num++) {
+        if ((unsigned char)font->table[Num].index[0] == hi &&
+            (hi < 0x80 || (unsigned char)font->table[Num].index[1] == lo))
+            return Num;
+    }
+    return -1;
+}
+
+/******************************************************************************
+function:	Build the lookup of a CN font table
+******************************************************************************/
+static uint16_t *Font_CN_Build(const cFONT *font)
+{
+    uint16_t *lookup = malloc(sizeof(uint16_t) * FONT_CN_SLOTS);
+    int Num, slot;
+
+    if (!lookup)
+        return NULL;
+    for (slot = 0; slot < FONT_CN_SLOTS; slot++)
+        lookup[slot] = FONT_CN_NONE;
+
+    for (Num = 0; Num < font->size && Num < FONT_CN_NONE; Num++) {
+        slot = Font_CN_Slot((unsigned char)font->table[Num].index[0],
+                            (unsigned char)font->table[Num].index[1]);
+        if (slot >= 0 && lookup[slot] == FONT_CN_NONE)  // First entry wins, as with a linear search
+            lookup[slot] = (uint16_t)Num;
+    }
+    return lookup;
+}
+
+/******************************************************************************
+function:	Find a character in a CN font
+parameter:
+    font : CN font
+    hi   : First byte of the GB code, or an ASCII code
+    lo   : Second byte of the GB code, ignored for ASCII
+info:
+    Returns the glyph number in the font, or -1 when the font has no such
+    character. The lookup of a table font is built on the first call;
+    concurrent first calls are safe, only one lookup is kept.
+******************************************************************************/
+int Font_CN_Find(cFONT *font, unsigned char hi, unsigned char lo)
+{
+    const uint16_t *lookup = __atomic_load_n(&font->Lookup, __ATOMIC_ACQUIRE);
+    int slot;
+
+    if (!lookup) {
+        const uint16_t *expected = NULL;
+        uint16_t *built = Font_CN_Build(font);
+
+        if (!built)
+            return Font_CN_Search(font, hi, lo);
+        if (__atomic_compare_exchange_n(&font->Lookup, &expected, (const uint16_t *)built, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            lookup = built;
+        } else {
+            free(built);
+            lookup = expected;
+        }
+    }
+
+    slot = Font_CN_Slot(hi, lo);
+    // Pack lookups come from a file, so the glyph number is checked as well
+    if (slot < 0 || lookup[slot] >= font->size)
+        return -1;
+    return lookup[slot];
+}
+
+/******************************************************************************
+function:	Bitmap of a glyph
+parameter:
+    font : CN font
+    Num  : Glyph number from Font_CN_Find()
+    buf  : FONT_CN_GLYPH_MAX bytes, used when the glyph has to be unpacked
+info:
+    Rows are (Width + 7) / 8 bytes, most significant bit leftmost.
+    Returns NULL if the glyph cannot be read.
+******************************************************************************/
+const unsigned char *Font_CN_Bitmap(const cFONT *font, int Num, unsigned char *buf)
+{
+    if (font->Pack)
+        return Font_Pack_Bitmap(font->Pack, Num, buf);
+    return (const unsigned char *)font->table[Num].matrix;
+}
@@ -76,9 +76,37 @@ typedef struct
   uint16_t ASCII_Width;
   uint16_t Width;
   uint16_t Height;
+  const uint16_t *Lookup;         //Table index by character code, built on first use by Font_CN_Find()
+  const struct _tFontPack *Pack;  //Glyphs come from a font pack instead of table, see fontpack.h
   
 }cFONT;
 
+//Glyph IDs: below GLYPH_CN a single-byte character, from GLYPH_CN on
+//GLYPH_CN + index into cFONT.table; GLYPH_MISSING is a character the font lacks
+#define GLYPH_CN                0x0100
+#define GLYPH_MISSING           0xFFFF
+
+//Font_CN_Find() lookup: 128 ASCII slots, then one slot per GBK code (rows 0x81-0xFE,
+//cells 0x40-0xFE); GB2312 is the 0xA1-0xFE corner of that grid
+#define FONT_CN_ASCII           128
+#define FONT_CN_ROWS            126
+#define FONT_CN_CELLS           191
+#define FONT_CN_SLOTS           (FONT_CN_ASCII + FONT_CN_ROWS * FONT_CN_CELLS)
+#define FONT_CN_NONE            0xFFFF
+
+//Largest glyph bitmap, rows are padded to whole bytes
+#define FONT_CN_GLYPH_MAX       (MAX_HEIGHT_FONT * ((MAX_WIDTH_FONT + 7) / 8))
+
+//Lookup slot of a character code, -1 for codes that are neither ASCII nor GBK
+static inline int Font_CN_Slot(unsigned char hi, unsigned char lo)
+{
+  if (hi < 0x80)
+    return hi;
+  if (hi >= 0x81 && hi <= 0xFE && lo >= 0x40 && lo <= 0xFE)
+    return FONT_CN_ASCII + (hi - 0x81) * FONT_CN_CELLS + (lo - 0x40);
+  return -1;
+}
+
 extern sFONT Font24;
 extern sFONT Font20;
 extern sFONT Font16;
@@ -87,6 +115,9 @@ extern sFONT Font8;
 
 extern cFONT Font12CN;
 extern cFONT Font24CN;
+
+int Font_CN_Find(cFONT *font, unsigned char hi, unsigned char lo);
+const unsigned char *Font_CN_Bitmap(const cFONT *font, int Num, unsigned char *buf);
 #ifdef __cplusplus
 }
 #endif
@@ -55,7 +55,7 @@
 #include <math.h> //memset()
 #include <stdio.h>
 
-UBYTE GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart)
+UBYTE GUI_ReadBmp_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart)
 {
     FILE *fp;                     //Define a file pointer
     BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
@@ -128,12 +128,12 @@ UBYTE GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart)
     UBYTE color, temp;
     for(y = 0; y < bmpInfoHeader.biHeight; y++) {
         for(x = 0; x < bmpInfoHeader.biWidth; x++) {
-            if(x > Paint.Width || y > Paint.Height) {
+            if(x > paint->Width || y > paint->Height) {
                 break;
             }
             temp = Image[(x / 8) + (y * Image_Width_Byte)];
             color = (((temp << (x%8)) & 0x80) == 0x80) ?Bcolor:Wcolor;
-            Paint_SetPixel(Xstart + x, Ystart + y, color);
+            Paint_SetPixel_Ctx(paint, Xstart + x, Ystart + y, color);
         }
     }
     return 0;
@@ -141,7 +141,7 @@ UBYTE GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart)
 /*************************************************************************
 
 *************************************************************************/
-UBYTE GUI_ReadBmp_4Gray(const char *path, UWORD Xstart, UWORD Ystart)
+UBYTE GUI_ReadBmp_4Gray_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart)
 {
     FILE *fp;                     //Define a file pointer
     BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
@@ -195,18 +195,18 @@ UBYTE GUI_ReadBmp_4Gray(const char *path, UWORD Xstart, UWORD Ystart)
     printf("bmpInfoHeader.biHeight = %d\r\n",bmpInfoHeader.biHeight);
     for(y = 0; y < bmpInfoHeader.biHeight; y++) {
         for(x = 0; x < bmpInfoHeader.biWidth; x++) {
-            if(x > Paint.Width || y > Paint.Height) {
+            if(x > paint->Width || y > paint->Height) {
                 break;
             }
             temp = Image[x/2 + y * bmpInfoHeader.biWidth/2] >> ((x%2)? 0:4);//0xf 0x8 0x7 0x0 
             color = temp>>2;                           //11  10  01  00  
-            Paint_SetPixel(Xstart + x, Ystart + y, color);
+            Paint_SetPixel_Ctx(paint, Xstart + x, Ystart + y, color);
         }
     }
     return 0;
 }
 
-UBYTE GUI_ReadBmp_16Gray(const char *path, UWORD Xstart, UWORD Ystart)
+UBYTE GUI_ReadBmp_16Gray_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart)
 {
     FILE *fp;                     //Define a file pointer
     BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
@@ -277,17 +277,17 @@ UBYTE GUI_ReadBmp_16Gray(const char *path, UWORD Xstart, UWORD Ystart)
     printf("bmpInfoHeader.biHeight = %d\r\n", bmpInfoHeader.biHeight);
     for (y = 0; y < bmpInfoHeader.biHeight; y++) {
         for (x = 0; x < bmpInfoHeader.biWidth; x++) {
-            if (Xstart + x > Paint.Width || Ystart + y > Paint.Height)
+            if (Xstart + x > paint->Width || Ystart + y > paint->Height)
                 break;
 
             coloridx = (Image[x / 2 + y * Width_Byte] >> ((x % 2) ? 0 : 4)) & 15;
-            Paint_SetPixel(Xstart + x, Ystart + y, colors[coloridx]);
+            Paint_SetPixel_Ctx(paint, Xstart + x, Ystart + y, colors[coloridx]);
         }
     }
     return 0;
 }
 
-UBYTE GUI_ReadBmp_RGB_7Color(const char *path, UWORD Xstart, UWORD Ystart)
+UBYTE GUI_ReadBmp_RGB_7Color_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart)
 {
     FILE *fp;                     //Define a file pointer
     BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
@@ -357,16 +357,16 @@ UBYTE GUI_ReadBmp_RGB_7Color(const char *path, UWORD Xstart, UWORD Ystart)
     // Refresh the image to the display buffer based on the displayed orientation
     for(y = 0; y < bmpInfoHeader.biHeight; y++) {
         for(x = 0; x < bmpInfoHeader.biWidth; x++) {
-            if(x > Paint.Width || y > Paint.Height) {
+            if(x > paint->Width || y > paint->Height) {
                 break;
             }
-            Paint_SetPixel(Xstart + x, Ystart + y, Image[bmpInfoHeader.biHeight *  bmpInfoHeader.biWidth - 1 -(bmpInfoHeader.biWidth-x-1+(y* bmpInfoHeader.biWidth))]);
+            Paint_SetPixel_Ctx(paint, Xstart + x, Ystart + y, Image[bmpInfoHeader.biHeight *  bmpInfoHeader.biWidth - 1 -(bmpInfoHeader.biWidth-x-1+(y* bmpInfoHeader.biWidth))]);
 		}
     }
     return 0;
 }
 
-UBYTE GUI_ReadBmp_RGB_4Color(const char *path, UWORD Xstart, UWORD Ystart)
+UBYTE GUI_ReadBmp_RGB_4Color_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart)
 {
     FILE *fp;                     //Define a file pointer
     BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
@@ -439,16 +439,16 @@ UBYTE GUI_ReadBmp_RGB_4Color(const char *path, UWORD Xstart, UWORD Ystart)
     // Refresh the image to the display buffer based on the displayed orientation
     for(y = 0; y < bmpInfoHeader.biHeight; y++) {
         for(x = 0; x < bmpInfoHeader.biWidth; x++) {
-            if(x > Paint.Width || y > Paint.Height) {
+            if(x > paint->Width || y > paint->Height) {
                 break;
             }
-            Paint_SetPixel(Xstart + x, Ystart + y, Image[bmpInfoHeader.biHeight *  bmpInfoHeader.biWidth - 1 -(bmpInfoHeader.biWidth-x-1+(y* bmpInfoHeader.biWidth))]);
+            Paint_SetPixel_Ctx(paint, Xstart + x, Ystart + y, Image[bmpInfoHeader.biHeight *  bmpInfoHeader.biWidth - 1 -(bmpInfoHeader.biWidth-x-1+(y* bmpInfoHeader.biWidth))]);
 		}
     }
     return 0;
 }
 
-UBYTE GUI_ReadBmp_RGB_6Color(const char *path, UWORD Xstart, UWORD Ystart)
+UBYTE GUI_ReadBmp_RGB_6Color_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart)
 {
     FILE *fp;                     //Define a file pointer
     BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
@@ -519,18 +519,18 @@ UBYTE GUI_ReadBmp_RGB_6Color(const char *path, UWORD Xstart, UWORD Ystart)
     // Refresh the image to the display buffer based on the displayed orientation
     for(y = 0; y < bmpInfoHeader.biHeight; y++) {
         for(x = 0; x < bmpInfoHeader.biWidth; x++) {
-            if(x > Paint.Width || y > Paint.Height) {
+            if(x > paint->Width || y > paint->Height) {
                 break;
             }
-            Paint_SetPixel(Xstart + x, Ystart + y, Image[bmpInfoHeader.biHeight *  bmpInfoHeader.biWidth - 1 -(bmpInfoHeader.biWidth-x-1+(y* bmpInfoHeader.biWidth))]);
+            Paint_SetPixel_Ctx(paint, Xstart + x, Ystart + y, Image[bmpInfoHeader.biHeight *  bmpInfoHeader.biWidth - 1 -(bmpInfoHeader.biWidth-x-1+(y* bmpInfoHeader.biWidth))]);
 		}
     }
     return 0;
 }
 
 // New function to center the scaled image within a given area
-UBYTE GUI_ReadBmp_Scale_Centered(const char *path, UWORD areaXstart, UWORD areaYstart, 
-                                 UWORD areaWidth, UWORD areaHeight, double scale)
+UBYTE GUI_ReadBmp_Scale_Centered_Ctx(PAINT *paint, const char *path, UWORD areaXstart, UWORD areaYstart, 
+                                     UWORD areaWidth, UWORD areaHeight, double scale)
 {
     FILE *fp;                     // Define a file pointer
     BMPFILEHEADER bmpFileHeader;  // Define a bmp file header structure
@@ -637,16 +637,52 @@ UBYTE GUI_ReadBmp_Scale_Centered(const char *path, UWORD areaXstart, UWORD areaY
                 continue;
             }
             
-            if(finalXstart + x > Paint.Width || finalYstart + y > Paint.Height) {
+            if(finalXstart + x > paint->Width || finalYstart + y > paint->Height) {
                 break;
             }
             
             temp = Image[(src_x / 8) + (src_y * Image_Width_Byte)];
             color = (((temp << (src_x%8)) & 0x80) == 0x80) ? Bcolor : Wcolor;
-            Paint_SetPixel(finalXstart + x, finalYstart + y, color);
+            Paint_SetPixel_Ctx(paint, finalXstart + x, finalYstart + y, color);
         }
     }
     
     free(Image);
     return 0;
 }
+
+// The loaders above, drawing into the global Paint
+UBYTE GUI_ReadBmp(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_ReadBmp_Ctx(&Paint, path, Xstart, Ystart);
+}
+
+UBYTE GUI_ReadBmp_4Gray(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_ReadBmp_4Gray_Ctx(&Paint, path, Xstart, Ystart);
+}
+
+UBYTE GUI_ReadBmp_16Gray(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_ReadBmp_16Gray_Ctx(&Paint, path, Xstart, Ystart);
+}
+
+UBYTE GUI_ReadBmp_RGB_7Color(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_ReadBmp_RGB_7Color_Ctx(&Paint, path, Xstart, Ystart);
+}
+
+UBYTE GUI_ReadBmp_RGB_4Color(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_ReadBmp_RGB_4Color_Ctx(&Paint, path, Xstart, Ystart);
+}
+
+UBYTE GUI_ReadBmp_RGB_6Color(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    return GUI_ReadBmp_RGB_6Color_Ctx(&Paint, path, Xstart, Ystart);
+}
+
+UBYTE GUI_ReadBmp_Scale_Centered(const char *path, UWORD areaXstart, UWORD areaYstart, UWORD areaWidth, UWORD areaHeight, double scale)
+{
+    return GUI_ReadBmp_Scale_Centered_Ctx(&Paint, path, areaXstart, areaYstart, areaWidth, areaHeight, scale);
+}
@@ -51,6 +51,7 @@
 #include <stdint.h>
 
 #include "DEV_Config.h"
+#include "GUI_Paint.h"
 
 /*Bitmap file header   14bit*/
 typedef struct BMP_FILE_HEADER {
@@ -95,4 +96,15 @@ UBYTE GUI_ReadBmp_RGB_7Color(const char *path, UWORD Xstart, UWORD Ystart);
 // 新增函数：按比例缩放并居中显示BMP图片
 UBYTE GUI_ReadBmp_Scale_Centered(const char *path, UWORD areaXstart, UWORD areaYstart, 
                                  UWORD areaWidth, UWORD areaHeight, double scale);
+
+// Drawing into paint instead of the global Paint
+UBYTE GUI_ReadBmp_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart);
+UBYTE GUI_ReadBmp_4Gray_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart);
+UBYTE GUI_ReadBmp_16Gray_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart);
+UBYTE GUI_ReadBmp_RGB_4Color_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart);
+UBYTE GUI_ReadBmp_RGB_6Color_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart);
+UBYTE GUI_ReadBmp_RGB_7Color_Ctx(PAINT *paint, const char *path, UWORD Xstart, UWORD Ystart);
+
+UBYTE GUI_ReadBmp_Scale_Centered_Ctx(PAINT *paint, const char *path, UWORD areaXstart, UWORD areaYstart, 
+                                     UWORD areaWidth, UWORD areaHeight, double scale);
 #endif
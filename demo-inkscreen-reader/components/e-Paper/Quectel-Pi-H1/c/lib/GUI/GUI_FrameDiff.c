@@ -0,0 +1,113 @@
+/*****************************************************************************
+* | File      	:   GUI_FrameDiff.c
+* | Function    :   Compare a panel frame with the one shown before
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "GUI_FrameDiff.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FRAME_DIFF_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FRAME_DIFF_SSE2
+#endif
+
+/******************************************************************************
+function:	Whether n bytes at a and b differ
+info:
+    The XOR of both is ORed together a vector at a time and tested once
+    at the end; a row of the 7.5" panel is 100 bytes.
+******************************************************************************/
+static int Frame_RowDiffers(const UBYTE *a, const UBYTE *b, UDOUBLE n)
+{
+    uint64_t x = 0, wa, wb;
+    UDOUBLE i = 0;
+
+#if defined(FRAME_DIFF_NEON)
+    uint8x16_t acc = vdupq_n_u8(0);
+    for (; i + 16 <= n; i += 16)
+        acc = vorrq_u8(acc, veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    x = vgetq_lane_u64(vreinterpretq_u64_u8(acc), 0) | vgetq_lane_u64(vreinterpretq_u64_u8(acc), 1);
+#elif defined(FRAME_DIFF_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+        acc = _mm_or_si128(acc, _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i)),
+                                              _mm_loadu_si128((const __m128i *)(b + i))));
+    x = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF;
+#endif
+    for (; i + 8 <= n; i += 8) {
+        memcpy(&wa, a + i, 8);
+        memcpy(&wb, b + i, 8);
+        x |= wa ^ wb;
+    }
+    for (; i < n; i++)
+        x |= a[i] ^ b[i];
+    return x != 0;
+}
+
+/******************************************************************************
+function:	Compare a frame with the previous one and keep it as the previous
+parameter:
+    Frame     : Frame about to be shown
+    Prev      : Frame shown before, receives the rows of Frame that changed
+    WidthByte : Bytes of a row
+    Height    : Rows
+    Diff      : Receives the changed rows and columns
+info:
+    Columns are only narrowed down in rows that changed, a byte at a time
+    from both ends and never further in than the extent found so far.
+    Returns the number of runs, 0 if Frame shows nothing new.
+******************************************************************************/
+UWORD Frame_Diff(const UBYTE *Frame, UBYTE *Prev, UWORD WidthByte, UWORD Height, FRAME_DIFF *Diff)
+{
+    UWORD first = WidthByte, last = 0, y, c;
+    FRAME_RUN *run = NULL;
+
+    Diff->Runs = 0;
+    for (y = 0; y < Height; y++) {
+        const UBYTE *a = Frame + (UDOUBLE)y * WidthByte;
+        const UBYTE *b = Prev + (UDOUBLE)y * WidthByte;
+
+        if (!Frame_RowDiffers(a, b, WidthByte))
+            continue;
+
+        for (c = 0; c < first && a[c] == b[c]; c++)
+            ;
+        first = c;
+        for (c = WidthByte; c > last && a[c - 1] == b[c - 1]; c--)
+            ;
+        last = c;
+
+        if (run && run->Yend == y) {
+            run->Yend = y + 1;
+        } else if (Diff->Runs < FRAME_DIFF_RUNS) {
+            run = &Diff->Run[Diff->Runs++];
+            run->Ystart = y;
+            run->Yend = y + 1;
+        } else {
+            run->Yend = y + 1;  // Out of runs, take in the rows between
+        }
+    }
+
+    if (Diff->Runs == 0) {
+        Diff->Xstart = Diff->Xend = Diff->Ystart = Diff->Yend = 0;
+        return 0;
+    }
+    for (c = 0; c < Diff->Runs; c++) {
+        run = &Diff->Run[c];
+        memcpy(Prev + (UDOUBLE)run->Ystart * WidthByte, Frame + (UDOUBLE)run->Ystart * WidthByte,
+               (UDOUBLE)(run->Yend - run->Ystart) * WidthByte);
+    }
+    Diff->Xstart = first * 8;
+    Diff->Xend = last * 8;
+    Diff->Ystart = Diff->Run[0].Ystart;
+    Diff->Yend = Diff->Run[Diff->Runs - 1].Yend;
+    return Diff->Runs;
+}
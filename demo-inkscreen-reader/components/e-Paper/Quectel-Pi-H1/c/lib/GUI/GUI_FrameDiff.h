@@ -0,0 +1,43 @@
+/*****************************************************************************
+* | File      	:   GUI_FrameDiff.h
+* | Function    :   Compare a panel frame with the one shown before
+* | Info        :
+*   A 1-bpp frame is compared with a copy of the previous one 16 bytes at
+*   a time (NEON or SSE2, 8 bytes where neither is available). The rows
+*   that changed come back as runs together with the columns they span,
+*   and the previous frame is brought up to date, changed rows only. An
+*   800x480 frame takes a few microseconds.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __GUI_FRAMEDIFF_H
+#define __GUI_FRAMEDIFF_H
+
+#include "DEV_Config.h"
+
+#define FRAME_DIFF_RUNS     8       // Runs of changed rows kept apart
+
+/**
+ * Rows Ystart to Yend - 1
+**/
+typedef struct {
+    UWORD Ystart;
+    UWORD Yend;
+} FRAME_RUN;
+
+/**
+ * What changed between two frames
+**/
+typedef struct {
+    UWORD Runs;                     // 0 if the frames are equal
+    FRAME_RUN Run[FRAME_DIFF_RUNS]; // Top to bottom; past FRAME_DIFF_RUNS the last run grows
+    UWORD Xstart;                   // Columns that changed in any row, in pixels,
+    UWORD Xend;                     // whole bytes, Xend not included
+    UWORD Ystart;                   // First changed row
+    UWORD Yend;                     // Last changed row + 1
+} FRAME_DIFF;
+
+UWORD Frame_Diff(const UBYTE *Frame, UBYTE *Prev, UWORD WidthByte, UWORD Height, FRAME_DIFF *Diff);
+
+#endif
@@ -82,7 +82,15 @@
 #include <stdlib.h>
 #include <string.h> //memset()
 #include <math.h>
+#include <pthread.h>
 
+/******************************************************************************
+Painter contexts:
+    Every function draws into the PAINT passed as its first argument, so
+    several images can be drawn at once, each from its own thread. The
+    Paint_* functions without _Ctx draw into the global Paint, see the end
+    of this file. Glyph atlases are shared by all contexts.
+******************************************************************************/
 PAINT Paint;
 
 /******************************************************************************
@@ -93,29 +101,31 @@ parameter:
     Height  :   The height of the picture
     Color   :   Whether the picture is inverted
 ******************************************************************************/
-void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
+void Paint_NewImage_Ctx(PAINT *paint, UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
 {
-    Paint.Image = NULL;
-    Paint.Image = image;
+    paint->Image = NULL;
+    paint->Image = image;
 
-    Paint.WidthMemory = Width;
-    Paint.HeightMemory = Height;
-    Paint.Color = Color;    
-    Paint.Scale = 2;
-    Paint.WidthByte = (Width % 8 == 0)? (Width / 8 ): (Width / 8 + 1);
-    Paint.HeightByte = Height;    
+    paint->WidthMemory = Width;
+    paint->HeightMemory = Height;
+    paint->Color = Color;    
+    paint->Scale = 2;
+    paint->WidthByte = (Width % 8 == 0)? (Width / 8 ): (Width / 8 + 1);
+    paint->HeightByte = Height;    
 //    printf("WidthByte = %d, HeightByte = %d\r\n", Paint.WidthByte, Paint.HeightByte);
 //    printf(" EPD_WIDTH / 8 = %d\r\n",  122 / 8);
    
-    Paint.Rotate = Rotate;
-    Paint.Mirror = MIRROR_NONE;
+    paint->Rotate = Rotate;
+    paint->Mirror = MIRROR_NONE;
+    paint->Deferred = 0;
+    paint->DirtyCount = 0;
     
     if(Rotate == ROTATE_0 || Rotate == ROTATE_180) {
-        Paint.Width = Width;
-        Paint.Height = Height;
+        paint->Width = Width;
+        paint->Height = Height;
     } else {
-        Paint.Width = Height;
-        Paint.Height = Width;
+        paint->Width = Height;
+        paint->Height = Width;
     }
 }
 
@@ -124,9 +134,9 @@ function: Select Image
 parameter:
     image : Pointer to the image cache
 ******************************************************************************/
-void Paint_SelectImage(UBYTE *image)
+void Paint_SelectImage_Ctx(PAINT *paint, UBYTE *image)
 {
-    Paint.Image = image;
+    paint->Image = image;
 }
 
 /******************************************************************************
@@ -134,11 +144,19 @@ function: Select Image Rotate
 parameter:
     Rotate : 0,90,180,270
 ******************************************************************************/
-void Paint_SetRotate(UWORD Rotate)
+void Paint_SetRotate_Ctx(PAINT *paint, UWORD Rotate)
 {
     if(Rotate == ROTATE_0 || Rotate == ROTATE_90 || Rotate == ROTATE_180 || Rotate == ROTATE_270) {
         Debug("Set image Rotate %d\r\n", Rotate);
-        Paint.Rotate = Rotate;
+        if (paint->Deferred) {
+            // The upright image keeps its size, so only a turn by 180 degrees fits
+            if ((Rotate == ROTATE_90 || Rotate == ROTATE_270) == (paint->FlushRotate == ROTATE_90 || paint->FlushRotate == ROTATE_270))
+                paint->FlushRotate = Rotate;
+            else
+                Debug("Deferred image cannot turn by 90 degrees\r\n");
+            return;
+        }
+        paint->Rotate = Rotate;
     } else {
         Debug("rotate = 0, 90, 180, 270\r\n");
     }
@@ -149,36 +167,152 @@ function:	Select Image mirror
 parameter:
     mirror   :Not mirror,Horizontal mirror,Vertical mirror,Origin mirror
 ******************************************************************************/
-void Paint_SetMirroring(UBYTE mirror)
+void Paint_SetMirroring_Ctx(PAINT *paint, UBYTE mirror)
 {
     if(mirror == MIRROR_NONE || mirror == MIRROR_HORIZONTAL || 
         mirror == MIRROR_VERTICAL || mirror == MIRROR_ORIGIN) {
         Debug("mirror image x:%s, y:%s\r\n",(mirror & 0x01)? "mirror":"none", ((mirror >> 1) & 0x01)? "mirror":"none");
-        Paint.Mirror = mirror;
+        if (paint->Deferred)
+            paint->FlushMirror = mirror;
+        else
+            paint->Mirror = mirror;
     } else {
         Debug("mirror should be MIRROR_NONE, MIRROR_HORIZONTAL, \
         MIRROR_VERTICAL or MIRROR_ORIGIN\r\n");
     }    
 }
 
-void Paint_SetScale(UBYTE scale)
+void Paint_SetScale_Ctx(PAINT *paint, UBYTE scale)
 {
     if(scale == 2){
-        Paint.Scale = scale;
-        Paint.WidthByte = (Paint.WidthMemory % 8 == 0)? (Paint.WidthMemory / 8 ): (Paint.WidthMemory / 8 + 1);
+        paint->Scale = scale;
+        paint->WidthByte = (paint->WidthMemory % 8 == 0)? (paint->WidthMemory / 8 ): (paint->WidthMemory / 8 + 1);
     }else if(scale == 4){
-        Paint.Scale = scale;
-        Paint.WidthByte = (Paint.WidthMemory % 4 == 0)? (Paint.WidthMemory / 4 ): (Paint.WidthMemory / 4 + 1);
+        paint->Scale = scale;
+        paint->WidthByte = (paint->WidthMemory % 4 == 0)? (paint->WidthMemory / 4 ): (paint->WidthMemory / 4 + 1);
     }else if(scale == 6 || scale == 7 || scale == 16){
         /* 7 colours are only applicable with 5in65 e-Paper */
         /* 16 colours are used for dithering */
-		Paint.Scale = scale;
-		Paint.WidthByte = (Paint.WidthMemory % 2 == 0)? (Paint.WidthMemory / 2 ): (Paint.WidthMemory / 2 + 1);;
+		paint->Scale = scale;
+		paint->WidthByte = (paint->WidthMemory % 2 == 0)? (paint->WidthMemory / 2 ): (paint->WidthMemory / 2 + 1);;
 	}else{
         Debug("Set Scale Input parameter error\r\n");
         Debug("Scale Only support: 2 4 7 16\r\n");
     }
 }
+/******************************************************************************
+function: Pixels per byte of image memory, 0 for an unknown scale
+******************************************************************************/
+static int Paint_PixelsPerByte(PAINT *paint)
+{
+    if(paint->Scale == 2)
+        return 8;
+    if(paint->Scale == 4)
+        return 4;
+    if(paint->Scale == 6 || paint->Scale == 7 || paint->Scale == 16)
+        return 2;
+    return 0;
+}
+
+/******************************************************************************
+function: Add a box of image memory to the dirty boxes
+parameter:
+    Xstart, Ystart : Top left corner in image memory
+    Xend, Yend     : Bottom right corner, not included
+info:
+    The box is widened to whole bytes and merged into a box it overlaps
+    or touches; a box that stays apart takes a free slot, or once all
+    PAINT_DIRTY_MAX are used is merged into the one it grows least.
+******************************************************************************/
+static void Paint_AddDirty(PAINT *paint, int Xstart, int Ystart, int Xend, int Yend)
+{
+    int ppb = Paint_PixelsPerByte(paint), i, j, best = 0;
+    long grow, least = -1;
+    PAINT_RECT *r;
+
+    if(ppb == 0)
+        return;
+    if(Xstart < 0)
+        Xstart = 0;
+    if(Ystart < 0)
+        Ystart = 0;
+    if(Xend > paint->WidthMemory)
+        Xend = paint->WidthMemory;
+    if(Yend > paint->HeightMemory)
+        Yend = paint->HeightMemory;
+    if(Xstart >= Xend || Ystart >= Yend)
+        return;
+    Xstart -= Xstart % ppb;
+    Xend += (ppb - Xend % ppb) % ppb;
+
+    for(i = 0; i < paint->DirtyCount; i++) {
+        r = &paint->Dirty[i];
+        if(Xstart >= r->Xstart && Xend <= r->Xend && Ystart >= r->Ystart && Yend <= r->Yend) {
+            paint->DirtyLast = i;
+            return;
+        }
+    }
+    for(i = 0; i < paint->DirtyCount; i++) {
+        r = &paint->Dirty[i];
+        if(Xstart <= r->Xend && Xend >= r->Xstart && Ystart <= r->Yend && Yend >= r->Ystart)
+            break;
+    }
+    if(i == paint->DirtyCount) {
+        if(paint->DirtyCount < PAINT_DIRTY_MAX) {
+            r = &paint->Dirty[paint->DirtyCount++];
+            r->Xstart = Xstart;
+            r->Ystart = Ystart;
+            r->Xend = Xend;
+            r->Yend = Yend;
+            paint->DirtyLast = paint->DirtyCount - 1;
+            return;
+        }
+        for(i = 0; i < paint->DirtyCount; i++) {
+            r = &paint->Dirty[i];
+            grow = (long)((Xend > r->Xend ? Xend : r->Xend) - (Xstart < r->Xstart ? Xstart : r->Xstart)) *
+                   ((Yend > r->Yend ? Yend : r->Yend) - (Ystart < r->Ystart ? Ystart : r->Ystart)) -
+                   (long)(r->Xend - r->Xstart) * (r->Yend - r->Ystart);
+            if(least < 0 || grow < least) {
+                least = grow;
+                best = i;
+            }
+        }
+        i = best;
+    }
+
+    // Grow box i, then fold in the boxes it has come to touch
+    r = &paint->Dirty[i];
+    if(Xstart < r->Xstart) r->Xstart = Xstart;
+    if(Ystart < r->Ystart) r->Ystart = Ystart;
+    if(Xend > r->Xend) r->Xend = Xend;
+    if(Yend > r->Yend) r->Yend = Yend;
+    for(j = 0; j < paint->DirtyCount; j++) {
+        PAINT_RECT *o = &paint->Dirty[j];
+        if(j == i || o->Xstart > r->Xend || o->Xend < r->Xstart || o->Ystart > r->Yend || o->Yend < r->Ystart)
+            continue;
+        if(o->Xstart < r->Xstart) r->Xstart = o->Xstart;
+        if(o->Ystart < r->Ystart) r->Ystart = o->Ystart;
+        if(o->Xend > r->Xend) r->Xend = o->Xend;
+        if(o->Yend > r->Yend) r->Yend = o->Yend;
+        *o = paint->Dirty[--paint->DirtyCount];
+        if(i == paint->DirtyCount)
+            r = &paint->Dirty[i = j];
+        j = -1;     // Start over, the box has grown again
+    }
+    paint->DirtyLast = i;
+}
+
+// Most marks fall in the box marked last, which is checked inline
+static inline void Paint_MarkDirty(PAINT *paint, int Xstart, int Ystart, int Xend, int Yend)
+{
+    const PAINT_RECT *r = &paint->Dirty[paint->DirtyLast];
+
+    if(paint->DirtyLast < paint->DirtyCount &&
+       Xstart >= r->Xstart && Xend <= r->Xend && Ystart >= r->Ystart && Yend <= r->Yend)
+        return;
+    Paint_AddDirty(paint, Xstart, Ystart, Xend, Yend);
+}
+
 /******************************************************************************
 function: Draw Pixels
 parameter:
@@ -186,107 +320,235 @@ parameter:
     Ypoint : At point Y
     Color  : Painted colors
 ******************************************************************************/
-void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+void Paint_SetPixel_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, UWORD Color)
 {
-    if(Xpoint > Paint.Width || Ypoint > Paint.Height){
+    if(Xpoint > paint->Width || Ypoint > paint->Height){
         Debug("Exceeding display boundaries\r\n");
         return;
     }      
     UWORD X, Y;
-    switch(Paint.Rotate) {
+    switch(paint->Rotate) {
     case 0:
         X = Xpoint;
         Y = Ypoint;  
         break;
     case 90:
-        X = Paint.WidthMemory - Ypoint - 1;
+        X = paint->WidthMemory - Ypoint - 1;
         Y = Xpoint;
         break;
     case 180:
-        X = Paint.WidthMemory - Xpoint - 1;
-        Y = Paint.HeightMemory - Ypoint - 1;
+        X = paint->WidthMemory - Xpoint - 1;
+        Y = paint->HeightMemory - Ypoint - 1;
         break;
     case 270:
         X = Ypoint;
-        Y = Paint.HeightMemory - Xpoint - 1;
+        Y = paint->HeightMemory - Xpoint - 1;
         break;
     default:
         return;
     }
     
-    switch(Paint.Mirror) {
+    switch(paint->Mirror) {
     case MIRROR_NONE:
         break;
     case MIRROR_HORIZONTAL:
-        X = Paint.WidthMemory - X - 1;
+        X = paint->WidthMemory - X - 1;
         break;
     case MIRROR_VERTICAL:
-        Y = Paint.HeightMemory - Y - 1;
+        Y = paint->HeightMemory - Y - 1;
         break;
     case MIRROR_ORIGIN:
-        X = Paint.WidthMemory - X - 1;
-        Y = Paint.HeightMemory - Y - 1;
+        X = paint->WidthMemory - X - 1;
+        Y = paint->HeightMemory - Y - 1;
         break;
     default:
         return;
     }
 
-    if(X > Paint.WidthMemory || Y > Paint.HeightMemory){
+    if(X >= paint->WidthMemory || Y >= paint->HeightMemory){
         Debug("Exceeding display boundaries\r\n");
         return;
     }
+    Paint_MarkDirty(paint, X, Y, X + 1, Y + 1);
     
-    if(Paint.Scale == 2){
-        UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;
-        UBYTE Rdata = Paint.Image[Addr];
+    if(paint->Scale == 2){
+        UDOUBLE Addr = X / 8 + Y * paint->WidthByte;
+        UBYTE Rdata = paint->Image[Addr];
         if(Color == BLACK)
-            Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8));
+            paint->Image[Addr] = Rdata & ~(0x80 >> (X % 8));
         else
-            Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));
-    }else if(Paint.Scale == 4){
-        UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;
+            paint->Image[Addr] = Rdata | (0x80 >> (X % 8));
+    }else if(paint->Scale == 4){
+        UDOUBLE Addr = X / 4 + Y * paint->WidthByte;
         Color = Color % 4;//Guaranteed color scale is 4  --- 0~3
-        UBYTE Rdata = Paint.Image[Addr];
+        UBYTE Rdata = paint->Image[Addr];
         Rdata = Rdata & (~(0xC0 >> ((X % 4)*2)));//Clear first, then set value
-        Paint.Image[Addr] = Rdata | ((Color << 6) >> ((X % 4)*2));
-    }else if(Paint.Scale == 6 || Paint.Scale == 7 || Paint.Scale == 16){
-		UDOUBLE Addr = X / 2  + Y * Paint.WidthByte;
-		UBYTE Rdata = Paint.Image[Addr];
+        paint->Image[Addr] = Rdata | ((Color << 6) >> ((X % 4)*2));
+    }else if(paint->Scale == 6 || paint->Scale == 7 || paint->Scale == 16){
+		UDOUBLE Addr = X / 2  + Y * paint->WidthByte;
+		UBYTE Rdata = paint->Image[Addr];
 		Rdata = Rdata & (~(0xF0 >> ((X % 2)*4)));//Clear first, then set value
-		Paint.Image[Addr] = Rdata | ((Color << 4) >> ((X % 2)*4));
+		paint->Image[Addr] = Rdata | ((Color << 4) >> ((X % 2)*4));
 		// printf("Add =  %d ,data = %d\r\n",Addr,Rdata);
 	}
 }
 
+/******************************************************************************
+function: Image memory position of a point
+parameter:
+    x, y         : Point, may lie outside the image
+    WidthMemory  : Width of the image memory
+    HeightMemory : Height of the image memory
+    Rotate       : ROTATE_0, ROTATE_90, ROTATE_180 or ROTATE_270
+    Mirror       : MIRROR_*
+    X, Y         : Receive the position in memory
+info:
+    The transform of Paint_SetPixel(), without its range checks.
+******************************************************************************/
+static void Paint_MapPoint(int x, int y, int WidthMemory, int HeightMemory, UWORD Rotate, UWORD Mirror,
+                           int *X, int *Y)
+{
+    switch (Rotate) {
+    case ROTATE_90:
+        *X = WidthMemory - y - 1;
+        *Y = x;
+        break;
+    case ROTATE_180:
+        *X = WidthMemory - x - 1;
+        *Y = HeightMemory - y - 1;
+        break;
+    case ROTATE_270:
+        *X = y;
+        *Y = HeightMemory - x - 1;
+        break;
+    default:
+        *X = x;
+        *Y = y;
+        break;
+    }
+    if (Mirror == MIRROR_HORIZONTAL || Mirror == MIRROR_ORIGIN)
+        *X = WidthMemory - *X - 1;
+    if (Mirror == MIRROR_VERTICAL || Mirror == MIRROR_ORIGIN)
+        *Y = HeightMemory - *Y - 1;
+}
+
+/******************************************************************************
+function: Top left corner in image memory of a Width x Height box at x, y
+******************************************************************************/
+static void Paint_MapBox(PAINT *paint, int x, int y, int Width, int Height, int *X, int *Y)
+{
+    int X1, Y1;
+
+    Paint_MapPoint(x, y, paint->WidthMemory, paint->HeightMemory, paint->Rotate, paint->Mirror, X, Y);
+    Paint_MapPoint(x + Width - 1, y + Height - 1, paint->WidthMemory, paint->HeightMemory,
+                   paint->Rotate, paint->Mirror, &X1, &Y1);
+    if (X1 < *X)
+        *X = X1;
+    if (Y1 < *Y)
+        *Y = Y1;
+}
+
+/******************************************************************************
+function: Byte holding Color in every pixel, for the current scale
+******************************************************************************/
+static UBYTE Paint_FillByte(PAINT *paint, UWORD Color)
+{
+    if(paint->Scale == 2)
+        return (Color == BLACK)? 0x00 : 0xFF;   // As Paint_SetPixel(): anything but BLACK sets the bit
+    if(paint->Scale == 4)
+        return (Color % 4) * 0x55;
+    return (Color & 0x0F) * 0x11;
+}
+
 /******************************************************************************
 function: Clear the color of the picture
 parameter:
     Color : Painted colors
+info:
+    Every byte of the image gets the same value, so this is one memset.
 ******************************************************************************/
-void Paint_Clear(UWORD Color)
-{	
-	if(Paint.Scale == 2) {
-		for (UWORD Y = 0; Y < Paint.HeightByte; Y++) {
-			for (UWORD X = 0; X < Paint.WidthByte; X++ ) {//8 pixel =  1 byte
-				UDOUBLE Addr = X + Y*Paint.WidthByte;
-				Paint.Image[Addr] = Color;
-			}
-		}		
-    }else if(Paint.Scale == 4) {
-        for (UWORD Y = 0; Y < Paint.HeightByte; Y++) {
-			for (UWORD X = 0; X < Paint.WidthByte; X++ ) {
-				UDOUBLE Addr = X + Y*Paint.WidthByte;
-				Paint.Image[Addr] = (Color<<6)|(Color<<4)|(Color<<2)|Color;
-			}
-		}		
-	}else if(Paint.Scale == 6 || Paint.Scale == 7 || Paint.Scale == 16) {
-		for (UWORD Y = 0; Y < Paint.HeightByte; Y++) {
-			for (UWORD X = 0; X < Paint.WidthByte; X++ ) {
-				UDOUBLE Addr = X + Y*Paint.WidthByte;
-				Paint.Image[Addr] = (Color<<4)|Color;
-			}
-		}		
-	}
+void Paint_Clear_Ctx(PAINT *paint, UWORD Color)
+{
+    UBYTE Fill;
+
+    if(paint->Scale == 2) {
+        Fill = (UBYTE)Color;
+    }else if(paint->Scale == 4) {
+        Fill = (UBYTE)((Color<<6)|(Color<<4)|(Color<<2)|Color);
+    }else if(paint->Scale == 6 || paint->Scale == 7 || paint->Scale == 16) {
+        Fill = (UBYTE)((Color<<4)|Color);
+    }else {
+        return;
+    }
+    memset(paint->Image, Fill, (size_t)paint->WidthByte * paint->HeightByte);
+    Paint_MarkDirty(paint, 0, 0, paint->WidthMemory, paint->HeightMemory);
+}
+
+/******************************************************************************
+function: Fill a box of the image with a color
+parameter:
+    Xstart, Ystart : Top left corner, may lie outside the image
+    Xend, Yend     : Bottom right corner, not included
+    Color          : Painted colors
+info:
+    The box is clipped to the image and turned into image memory, where
+    each of its rows is a run of pixels: a masked first byte, a memset of
+    the whole bytes and a masked last byte.
+******************************************************************************/
+static void Paint_FillRect(PAINT *paint, int Xstart, int Ystart, int Xend, int Yend, UWORD Color)
+{
+    int X, Y, Width, Height, Bits, First, Last, Row;
+    UBYTE Fill, FirstMask, LastMask;
+
+    if(paint->Scale == 2)
+        Bits = 1;
+    else if(paint->Scale == 4)
+        Bits = 2;
+    else if(paint->Scale == 6 || paint->Scale == 7 || paint->Scale == 16)
+        Bits = 4;
+    else
+        return;
+
+    if(Xstart < 0)
+        Xstart = 0;
+    if(Ystart < 0)
+        Ystart = 0;
+    if(Xend > paint->Width)
+        Xend = paint->Width;
+    if(Yend > paint->Height)
+        Yend = paint->Height;
+    if(Xstart >= Xend || Ystart >= Yend)
+        return;
+
+    Paint_MapBox(paint, Xstart, Ystart, Xend - Xstart, Yend - Ystart, &X, &Y);
+    if(paint->Rotate == ROTATE_90 || paint->Rotate == ROTATE_270) {
+        Width = Yend - Ystart;
+        Height = Xend - Xstart;
+    }else {
+        Width = Xend - Xstart;
+        Height = Yend - Ystart;
+    }
+
+    // Bits of the run in a row, first and last byte
+    First = X * Bits;
+    Last = (X + Width) * Bits - 1;
+    FirstMask = 0xFF >> (First % 8);
+    LastMask = 0xFF << (7 - Last % 8);
+    First /= 8;
+    Last /= 8;
+    if(First == Last)
+        FirstMask &= LastMask;
+    Fill = Paint_FillByte(paint, Color);
+    Paint_MarkDirty(paint, X, Y, X + Width, Y + Height);
+
+    for(Row = Y; Row < Y + Height; Row++) {
+        UBYTE *p = paint->Image + (UDOUBLE)Row * paint->WidthByte;
+        p[First] = (p[First] & ~FirstMask) | (Fill & FirstMask);
+        if(First == Last)
+            continue;
+        memset(p + First + 1, Fill, Last - First - 1);
+        p[Last] = (p[Last] & ~LastMask) | (Fill & LastMask);
+    }
 }
 
 /******************************************************************************
@@ -297,15 +559,12 @@ parameter:
     Xend   : x end point
     Yend   : y end point
     Color  : Painted colors
+info:
+    Filled a row span at a time, see Paint_FillRect().
 ******************************************************************************/
-void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+void Paint_ClearWindows_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
 {
-    UWORD X, Y;
-    for (Y = Ystart; Y < Yend; Y++) {
-        for (X = Xstart; X < Xend; X++) {//8 pixel =  1 byte
-            Paint_SetPixel(X, Y, Color);
-        }
-    }
+    Paint_FillRect(paint, Xstart, Ystart, Xend, Yend, Color);
 }
 
 /******************************************************************************
@@ -317,31 +576,152 @@ parameter:
     Dot_Pixel	: point size
     Dot_Style	: point Style
 ******************************************************************************/
-void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
+void Paint_DrawPoint_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, UWORD Color,
                      DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
 {
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height) {
+    if (Xpoint > paint->Width || Ypoint > paint->Height) {
         Debug("Paint_DrawPoint Input exceeds the normal display range\r\n");
         return;
     }
 
-    int16_t XDir_Num , YDir_Num;
-    if (Dot_Style == DOT_FILL_AROUND) {
-        for (XDir_Num = 0; XDir_Num < 2 * Dot_Pixel - 1; XDir_Num++) {
-            for (YDir_Num = 0; YDir_Num < 2 * Dot_Pixel - 1; YDir_Num++) {
-                if(Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
-                    break;
-                // printf("x = %d, y = %d\r\n", Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel);
-                Paint_SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
-            }
-        }
+    // The square is (2 * Dot_Pixel - 1) wide around the point, or Dot_Pixel wide
+    // right and down of it, clipped to the image
+    if (Dot_Pixel == DOT_PIXEL_1X1) {
+        Paint_SetPixel_Ctx(paint, Xpoint - 1, Ypoint - 1, Color);
+    } else if (Dot_Style == DOT_FILL_AROUND) {
+        Paint_FillRect(paint, Xpoint - Dot_Pixel, Ypoint - Dot_Pixel,
+                       Xpoint + Dot_Pixel - 1, Ypoint + Dot_Pixel - 1, Color);
     } else {
-        for (XDir_Num = 0; XDir_Num <  Dot_Pixel; XDir_Num++) {
-            for (YDir_Num = 0; YDir_Num <  Dot_Pixel; YDir_Num++) {
-                Paint_SetPixel(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
-            }
+        Paint_FillRect(paint, Xpoint - 1, Ypoint - 1, Xpoint + Dot_Pixel - 1, Ypoint + Dot_Pixel - 1, Color);
+    }
+}
+
+/******************************************************************************
+function: Draw the points from (Xstart, Ystart) to (Xend, Yend) of a
+          horizontal or vertical line as one box
+info:
+    Paint_DrawPoint() with DOT_STYLE_DFT at each of the points, in one fill.
+******************************************************************************/
+static void Paint_DrawSpan(PAINT *paint, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width)
+{
+    int t;
+
+    if (Xstart > Xend) {
+        t = Xstart; Xstart = Xend; Xend = t;
+    }
+    if (Ystart > Yend) {
+        t = Ystart; Ystart = Yend; Yend = t;
+    }
+    Paint_FillRect(paint, Xstart - Line_width, Ystart - Line_width,
+                   Xend + Line_width - 1, Yend + Line_width - 1, Color);
+}
+
+/******************************************************************************
+function: Draw a dotted horizontal or vertical line
+info:
+    Paint_DrawPoint() with DOT_STYLE_DFT at each point, two in Color and
+    the third in IMAGE_BACKGROUND, in line order. Where thick squares
+    overlap the one drawn later wins, so away from the last point the
+    color along the line depends only on the position modulo 3.
+
+    When image memory rows run along the line, that pattern is built
+    once as 3 bytes, which hold a whole number of periods at every
+    scale, and written into each row span a byte at a time: the first
+    row with the masks of Paint_FillRect(), the others copied from it.
+    The last square goes on top. Across image memory rows every row is
+    one color, so there the dashes and gaps stay a box each.
+******************************************************************************/
+static void Paint_DrawDotted(PAINT *paint, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width)
+{
+    int Horizontal = Ystart == Yend;
+    int Start = Horizontal ? Xstart : Ystart;
+    int Dir = (Horizontal ? Xend - Xstart : Yend - Ystart) >= 0 ? 1 : -1;
+    int Count = abs(Xend - Xstart) + abs(Yend - Ystart) + 1;
+    int x0 = (Xstart < Xend ? Xstart : Xend) - Line_width, x1 = (Xstart < Xend ? Xend : Xstart) + Line_width - 1;
+    int y0 = (Ystart < Yend ? Ystart : Yend) - Line_width, y1 = (Ystart < Yend ? Yend : Ystart) + Line_width - 1;
+    int Bits, X, Y, Xa, Xb, Ya, Width, Height, First, Last, Row, i, j, k, n;
+    UBYTE Fore, Back, Pattern[3], FirstMask, LastMask;
+
+    if (Horizontal != (paint->Rotate == ROTATE_0 || paint->Rotate == ROTATE_180)) {
+        for (i = 0; i < Count; i += n) {
+            n = (i % 3 == 2) ? 1 : 2 - i % 3;
+            if (n > Count - i)
+                n = Count - i;
+            Paint_DrawSpan(paint, Xstart + (Horizontal ? Dir * i : 0), Ystart + (Horizontal ? 0 : Dir * i),
+                           Xstart + (Horizontal ? Dir * (i + n - 1) : 0), Ystart + (Horizontal ? 0 : Dir * (i + n - 1)),
+                           (i % 3 == 2) ? IMAGE_BACKGROUND : Color, Line_width);
         }
+        return;
     }
+
+    if(paint->Scale == 2)
+        Bits = 1;
+    else if(paint->Scale == 4)
+        Bits = 2;
+    else if(paint->Scale == 6 || paint->Scale == 7 || paint->Scale == 16)
+        Bits = 4;
+    else
+        return;
+
+    if(x0 < 0)
+        x0 = 0;
+    if(y0 < 0)
+        y0 = 0;
+    if(x1 > paint->Width)
+        x1 = paint->Width;
+    if(y1 > paint->Height)
+        y1 = paint->Height;
+    if(x0 >= x1 || y0 >= y1)
+        return;
+
+    Paint_MapBox(paint, x0, y0, x1 - x0, y1 - y0, &X, &Y);
+    Width = Horizontal ? x1 - x0 : y1 - y0;
+    Height = Horizontal ? y1 - y0 : x1 - x0;
+
+    // Position along the line of image memory column Xa, and the step per column
+    Paint_MapPoint(x0, y0, paint->WidthMemory, paint->HeightMemory, paint->Rotate, paint->Mirror, &Xa, &Ya);
+    Paint_MapPoint(x0 + Horizontal, y0 + !Horizontal, paint->WidthMemory, paint->HeightMemory,
+                   paint->Rotate, paint->Mirror, &Xb, &Ya);
+
+    First = X * Bits;
+    Last = (X + Width) * Bits - 1;
+    FirstMask = 0xFF >> (First % 8);
+    LastMask = 0xFF << (7 - Last % 8);
+    First /= 8;
+    Last /= 8;
+    if(First == Last)
+        FirstMask &= LastMask;
+
+    // Pattern[k] holds the pixels of byte First + k and of every third byte on
+    Fore = Paint_FillByte(paint, Color);
+    Back = Paint_FillByte(paint, IMAGE_BACKGROUND);
+    for(k = 0; k < 3; k++) {
+        UBYTE Mask = 0;
+        for(j = 0; j < 8 / Bits; j++) {
+            int u = (Horizontal ? x0 : y0) + ((First + k) * 8 / Bits + j - Xa) * (Xb - Xa);
+            // Index of the point whose square is drawn last over u
+            i = Dir > 0 ? u - Start + Line_width : Start - u + Line_width - 2;
+            if(((i % 3) + 3) % 3 != 2)
+                Mask |= (UBYTE)(((1 << Bits) - 1) << (8 - Bits * (j + 1)));
+        }
+        Pattern[k] = (Fore & Mask) | (Back & ~Mask);
+    }
+    Paint_MarkDirty(paint, X, Y, X + Width, Y + Height);
+
+    for(Row = Y; Row < Y + Height; Row++) {
+        UBYTE *p = paint->Image + (UDOUBLE)Row * paint->WidthByte;
+        p[First] = (p[First] & ~FirstMask) | (Pattern[0] & FirstMask);
+        if(First == Last)
+            continue;
+        if(Row == Y) {
+            for(j = First + 1, k = 1; j < Last; j++, k = k == 2 ? 0 : k + 1)
+                p[j] = Pattern[k];
+        }else {
+            memcpy(p + First + 1, paint->Image + (UDOUBLE)Y * paint->WidthByte + First + 1, Last - First - 1);
+        }
+        p[Last] = (p[Last] & ~LastMask) | (Pattern[(Last - First) % 3] & LastMask);
+    }
+    Paint_DrawSpan(paint, Xend, Yend, Xend, Yend, ((Count - 1) % 3 == 2) ? IMAGE_BACKGROUND : Color, Line_width);
 }
 
 /******************************************************************************
@@ -355,15 +735,24 @@ parameter:
     Line_width : Line width
     Line_Style: Solid and dotted lines
 ******************************************************************************/
-void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+void Paint_DrawLine_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
                     UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height) {
+    if (Xstart > paint->Width || Ystart > paint->Height ||
+        Xend > paint->Width || Yend > paint->Height) {
         Debug("Paint_DrawLine Input exceeds the normal display range\r\n");
         return;
     }
 
+    // Horizontal and vertical lines are boxes, dotted ones a repeating pattern
+    if (Xstart == Xend || Ystart == Yend) {
+        if (Line_Style == LINE_STYLE_DOTTED)
+            Paint_DrawDotted(paint, Xstart, Ystart, Xend, Yend, Color, Line_width);
+        else
+            Paint_DrawSpan(paint, Xstart, Ystart, Xend, Yend, Color, Line_width);
+        return;
+    }
+
     UWORD Xpoint = Xstart;
     UWORD Ypoint = Ystart;
     int dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
@@ -382,10 +771,10 @@ void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
         //Painted dotted line, 2 point is really virtual
         if (Line_Style == LINE_STYLE_DOTTED && Dotted_Len % 3 == 0) {
             //Debug("LINE_DOTTED\r\n");
-            Paint_DrawPoint(Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width, DOT_STYLE_DFT);
+            Paint_DrawPoint_Ctx(paint, Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width, DOT_STYLE_DFT);
             Dotted_Len = 0;
         } else {
-            Paint_DrawPoint(Xpoint, Ypoint, Color, Line_width, DOT_STYLE_DFT);
+            Paint_DrawPoint_Ctx(paint, Xpoint, Ypoint, Color, Line_width, DOT_STYLE_DFT);
         }
         if (2 * Esp >= dy) {
             if (Xpoint == Xend)
@@ -413,25 +802,24 @@ parameter:
     Line_width: Line width
     Draw_Fill : Whether to fill the inside of the rectangle
 ******************************************************************************/
-void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+void Paint_DrawRectangle_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
                          UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height) {
+    if (Xstart > paint->Width || Ystart > paint->Height ||
+        Xend > paint->Width || Yend > paint->Height) {
         Debug("Input exceeds the normal display range\r\n");
         return;
     }
 
     if (Draw_Fill) {
-        UWORD Ypoint;
-        for(Ypoint = Ystart; Ypoint < Yend; Ypoint++) {
-            Paint_DrawLine(Xstart, Ypoint, Xend, Ypoint, Color , Line_width, LINE_STYLE_SOLID);
-        }
+        // The lines of rows Ystart to Yend - 1, in one box
+        if (Ystart < Yend)
+            Paint_DrawSpan(paint, Xstart, Ystart, Xend, Yend - 1, Color, Line_width);
     } else {
-        Paint_DrawLine(Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_DrawLine_Ctx(paint, Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_DrawLine_Ctx(paint, Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_DrawLine_Ctx(paint, Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_DrawLine_Ctx(paint, Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
     }
 }
 
@@ -446,10 +834,10 @@ parameter:
     Line_width: Line width
     Draw_Fill : Whether to fill the inside of the Circle
 ******************************************************************************/
-void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
+void Paint_DrawCircle_Ctx(PAINT *paint, UWORD X_Center, UWORD Y_Center, UWORD Radius,
                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
 {
-    if (X_Center > Paint.Width || Y_Center >= Paint.Height) {
+    if (X_Center > paint->Width || Y_Center >= paint->Height) {
         Debug("Paint_DrawCircle Input exceeds the normal display range\r\n");
         return;
     }
@@ -466,14 +854,14 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
     if (Draw_Fill == DRAW_FILL_FULL) {
         while (XCurrent <= YCurrent ) { //Realistic circles
             for (sCountY = XCurrent; sCountY <= YCurrent; sCountY ++ ) {
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//1
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//2
-                Paint_DrawPoint(X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//3
-                Paint_DrawPoint(X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//4
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//5
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//6
-                Paint_DrawPoint(X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//7
-                Paint_DrawPoint(X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
+                Paint_DrawPoint_Ctx(paint, X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//1
+                Paint_DrawPoint_Ctx(paint, X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//2
+                Paint_DrawPoint_Ctx(paint, X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//3
+                Paint_DrawPoint_Ctx(paint, X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//4
+                Paint_DrawPoint_Ctx(paint, X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//5
+                Paint_DrawPoint_Ctx(paint, X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//6
+                Paint_DrawPoint_Ctx(paint, X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//7
+                Paint_DrawPoint_Ctx(paint, X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
             }
             if (Esp < 0 )
                 Esp += 4 * XCurrent + 6;
@@ -485,14 +873,14 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
         }
     } else { //Draw a hollow circle
         while (XCurrent <= YCurrent ) {
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//1
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//2
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//3
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//4
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//5
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//6
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//7
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//0
+            Paint_DrawPoint_Ctx(paint, X_Center + XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//1
+            Paint_DrawPoint_Ctx(paint, X_Center - XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//2
+            Paint_DrawPoint_Ctx(paint, X_Center - YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//3
+            Paint_DrawPoint_Ctx(paint, X_Center - YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//4
+            Paint_DrawPoint_Ctx(paint, X_Center - XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//5
+            Paint_DrawPoint_Ctx(paint, X_Center + XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//6
+            Paint_DrawPoint_Ctx(paint, X_Center + YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//7
+            Paint_DrawPoint_Ctx(paint, X_Center + YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//0
 
             if (Esp < 0 )
                 Esp += 4 * XCurrent + 6;
@@ -505,6 +893,356 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
     }
 }
 
+// Bits of a byte in reverse order
+#define PAINT_R2(n)     n, n + 2 * 64, n + 1 * 64, n + 3 * 64
+#define PAINT_R4(n)     PAINT_R2(n), PAINT_R2(n + 2 * 16), PAINT_R2(n + 1 * 16), PAINT_R2(n + 3 * 16)
+#define PAINT_R6(n)     PAINT_R4(n), PAINT_R4(n + 2 * 4), PAINT_R4(n + 1 * 4), PAINT_R4(n + 3 * 4)
+static const UBYTE Paint_Reverse8[256] = {
+    PAINT_R6(0), PAINT_R6(2), PAINT_R6(1), PAINT_R6(3)
+};
+
+/**
+ * Glyphs of a font stored in image memory order for one rotation and
+ * mirror, see Paint_PrepareFont_EN()
+**/
+#define PAINT_ATLAS_MAX     4
+#define PAINT_ASCII_GLYPHS  ('~' - ' ' + 1)     // Glyphs of an sFONT table
+
+typedef struct {
+    const void *Font;       // sFONT or cFONT, NULL if the slot is free
+    UWORD Rotate;
+    UWORD Mirror;
+    UWORD Width;            // Glyph cell in image memory, Height x Width at 90 and 270
+    UWORD Height;
+    UWORD GlyphBytes;
+    UDOUBLE Count;
+    UBYTE *Data;
+    UBYTE *Ready;           // CN fonts: set once a glyph is built, NULL if all are
+} PAINT_ATLAS;
+
+static PAINT_ATLAS Paint_Atlas[PAINT_ATLAS_MAX];
+static UBYTE Paint_AtlasNext;
+static pthread_mutex_t Paint_AtlasLock = PTHREAD_MUTEX_INITIALIZER;
+
+/******************************************************************************
+function: Merge a 1-bpp bitmap into a Scale 2 image a row at a time
+parameter:
+    X, Y             : Top left corner in image memory, may lie outside it
+    ptr              : Bitmap, rows of (Width + 7) / 8 bytes, MSB leftmost
+    Width, Height    : Bitmap size, Width at most 57
+    flip_x           : The bitmap rows run right to left in memory
+    flip_y           : The bitmap rows run bottom to top in memory
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color, FONT_BACKGROUND keeps
+                       the image behind the bitmap
+info:
+    The bitmap is clipped to the image once; each row is then built left
+    aligned in a 64-bit word, shifted to its bit position and merged with
+    a single read-modify-write. The last bytes of the image are written
+    one by one, so nothing past its end is touched.
+******************************************************************************/
+static void Paint_BlitRows(PAINT *paint, int X, int Y, const unsigned char *ptr, int Width, int Height,
+                           UBYTE flip_x, UBYTE flip_y, UWORD Color_Foreground, UWORD Color_Background)
+{
+    int stride = (Width + 7) / 8;
+    int c0, c1, r0, r1, mx, shift, j, b;
+    long step;
+    uint64_t clip, bits, ink, paper, set_ink, set_paper, w;
+    UBYTE opaque = (FONT_BACKGROUND != Color_Background);
+    UBYTE *row;
+    UDOUBLE addr, last;
+
+    // Visible columns and rows of the bitmap, in memory order
+    c0 = X < 0 ? -X : 0;
+    c1 = paint->WidthMemory - X < Width ? paint->WidthMemory - X : Width;
+    r0 = Y < 0 ? -Y : 0;
+    r1 = paint->HeightMemory - Y < Height ? paint->HeightMemory - Y : Height;
+    if (c0 >= c1 || r0 >= r1)
+        return;
+
+    // Bit 63 of a row is image column mx
+    shift = c0;
+    mx = X + c0;
+    clip = ((~0ULL >> c0) & ~(~0ULL >> c1)) << shift >> (mx % 8);
+
+    set_ink = (Color_Foreground != BLACK) ? ~0ULL : 0;
+    set_paper = (Color_Background != BLACK) ? ~0ULL : 0;
+
+    addr = (UDOUBLE)(Y + r0) * paint->WidthByte + mx / 8;
+    last = (UDOUBLE)paint->WidthByte * paint->HeightByte;
+    step = flip_y ? -stride : stride;
+    ptr += (long)(flip_y ? Height - 1 - r0 : r0) * stride;
+    Paint_MarkDirty(paint, mx, Y + r0, X + c1, Y + r1);
+
+    for (j = r0; j < r1; j++, ptr += step, addr += paint->WidthByte) {
+        bits = 0;
+        if (flip_x) {
+            for (b = 0; b < stride; b++)
+                bits |= (uint64_t)Paint_Reverse8[ptr[b]] << (8 * b);
+            bits <<= 64 - Width;
+        } else {
+            for (b = 0; b < stride; b++)
+                bits |= (uint64_t)ptr[b] << (56 - 8 * b);
+        }
+        bits = (bits << shift) >> (mx % 8);
+
+        ink = bits & clip;
+        paper = opaque ? clip & ~bits : 0;
+        row = paint->Image + addr;
+        if (addr + 8 <= last) {
+            memcpy(&w, row, 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            w = __builtin_bswap64(w);
+#endif
+            w = (w & ~(ink | paper)) | (ink & set_ink) | (paper & set_paper);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            w = __builtin_bswap64(w);
+#endif
+            memcpy(row, &w, 8);
+        } else {
+            for (b = 0; addr + b < last; b++) {
+                UBYTE m_ink = (UBYTE)(ink >> (56 - 8 * b)), m_paper = (UBYTE)(paper >> (56 - 8 * b));
+                row[b] = (row[b] & ~(m_ink | m_paper)) | (m_ink & set_ink) | (m_paper & set_paper);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function: Draw a 1-bpp glyph a row at a time
+parameter:
+    Xpoint, Ypoint   : Top left corner
+    ptr              : Glyph bitmap, rows of (Width + 7) / 8 bytes, MSB leftmost
+    Width, Height    : Glyph size, Width at most MAX_WIDTH_FONT
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color, FONT_BACKGROUND keeps
+                       the image behind the glyph
+info:
+    Sets the same pixels as Paint_SetPixel() would, one per bit. Only
+    Scale 2 with ROTATE_0 or ROTATE_180 is handled, where a glyph row stays
+    a row of the image: 180 degrees and the mirrors come down to reversing
+    the row bits and walking the rows upwards. Returns 0 if the glyph has
+    to be drawn pixel by pixel instead.
+******************************************************************************/
+static UBYTE Paint_BlitGlyph(PAINT *paint, int Xpoint, int Ypoint, const unsigned char *ptr, int Width, int Height,
+                             UWORD Color_Foreground, UWORD Color_Background)
+{
+    UBYTE flip_x, flip_y;
+    int X, Y;
+
+    if (paint->Scale != 2 || Width > MAX_WIDTH_FONT ||
+        (paint->Rotate != ROTATE_0 && paint->Rotate != ROTATE_180))
+        return 0;
+
+    flip_x = flip_y = (paint->Rotate == ROTATE_180);
+    if (paint->Mirror == MIRROR_HORIZONTAL || paint->Mirror == MIRROR_ORIGIN)
+        flip_x = !flip_x;
+    if (paint->Mirror == MIRROR_VERTICAL || paint->Mirror == MIRROR_ORIGIN)
+        flip_y = !flip_y;
+
+    Paint_MapBox(paint, Xpoint, Ypoint, Width, Height, &X, &Y);
+    Paint_BlitRows(paint, X, Y, ptr, Width, Height, flip_x, flip_y, Color_Foreground, Color_Background);
+    return 1;
+}
+
+/******************************************************************************
+function: Atlas of a font for the current rotation and mirror, NULL if none
+******************************************************************************/
+static PAINT_ATLAS *Paint_FindAtlas(PAINT *paint, const void *Font)
+{
+    int i;
+
+    if (paint->Scale != 2)
+        return NULL;
+    for (i = 0; i < PAINT_ATLAS_MAX; i++) {
+        if (__atomic_load_n(&Paint_Atlas[i].Font, __ATOMIC_ACQUIRE) == Font &&
+            Paint_Atlas[i].Rotate == paint->Rotate &&
+            Paint_Atlas[i].Mirror == paint->Mirror)
+            return &Paint_Atlas[i];
+    }
+    return NULL;
+}
+
+static void Paint_FreeAtlas(PAINT_ATLAS *atlas)
+{
+    free(atlas->Data);
+    free(atlas->Ready);
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+/******************************************************************************
+function: Set up an atlas of Count glyphs of Width x Height for the current
+          rotation and mirror
+parameter:
+    lazy : Glyphs are built as they are drawn
+info:
+    A free slot is taken, or the oldest atlas is dropped. Called under
+    Paint_AtlasLock; the atlas has no Font until the caller has stored
+    its glyphs and publishes it with Paint_PublishAtlas().
+******************************************************************************/
+static PAINT_ATLAS *Paint_NewAtlas(PAINT *paint, int Width, int Height, UDOUBLE Count, UBYTE lazy)
+{
+    PAINT_ATLAS *atlas;
+    int i;
+
+    if (paint->Scale != 2)
+        return NULL;
+    for (i = 0; i < PAINT_ATLAS_MAX && Paint_Atlas[i].Font; i++)
+        ;
+    if (i == PAINT_ATLAS_MAX) {
+        i = Paint_AtlasNext;
+        Paint_AtlasNext = (Paint_AtlasNext + 1) % PAINT_ATLAS_MAX;
+        Paint_FreeAtlas(&Paint_Atlas[i]);
+    }
+    atlas = &Paint_Atlas[i];
+
+    atlas->Rotate = paint->Rotate;
+    atlas->Mirror = paint->Mirror;
+    atlas->Width = (paint->Rotate == ROTATE_90 || paint->Rotate == ROTATE_270) ? Height : Width;
+    atlas->Height = (paint->Rotate == ROTATE_90 || paint->Rotate == ROTATE_270) ? Width : Height;
+    atlas->GlyphBytes = atlas->Height * ((atlas->Width + 7) / 8);
+    atlas->Count = Count;
+    atlas->Data = malloc((size_t)Count * atlas->GlyphBytes);
+    atlas->Ready = lazy ? calloc(Count, 1) : NULL;
+    if (!atlas->Data || (lazy && !atlas->Ready)) {
+        Paint_FreeAtlas(atlas);
+        return NULL;
+    }
+    return atlas;
+}
+
+// From here on Paint_FindAtlas() finds it, in every thread
+static void Paint_PublishAtlas(PAINT_ATLAS *atlas, const void *Font)
+{
+    __atomic_store_n(&atlas->Font, Font, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+function: Store one glyph in an atlas
+parameter:
+    atlas         : Atlas
+    ptr           : Glyph bitmap, rows of (Width + 7) / 8 bytes, MSB leftmost
+    Width, Height : Glyph size
+    glyph         : The glyph's place in the atlas
+info:
+    Each pixel goes where Paint_SetPixel() would put it in an image the
+    size of the glyph cell, so the cell can be copied row by row.
+******************************************************************************/
+static void Paint_AtlasGlyph(const PAINT_ATLAS *atlas, const unsigned char *ptr, int Width, int Height,
+                             UBYTE *glyph)
+{
+    int stride = (Width + 7) / 8, atlas_stride = (atlas->Width + 7) / 8;
+    int i, j, X, Y;
+
+    memset(glyph, 0, atlas->GlyphBytes);
+    for (j = 0; j < Height; j++) {
+        for (i = 0; i < Width; i++) {
+            if (ptr[j * stride + i / 8] & (0x80 >> (i % 8))) {
+                Paint_MapPoint(i, j, atlas->Width, atlas->Height, atlas->Rotate, atlas->Mirror, &X, &Y);
+                glyph[Y * atlas_stride + X / 8] |= 0x80 >> (X % 8);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function: Draw a glyph from an atlas
+parameter:
+    Xpoint, Ypoint   : Top left corner
+    atlas            : Atlas of the current rotation and mirror
+    glyph            : Glyph in the atlas
+    Width, Height    : Glyph size before rotation
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+******************************************************************************/
+static void Paint_DrawAtlasGlyph(PAINT *paint, int Xpoint, int Ypoint, const PAINT_ATLAS *atlas, const UBYTE *glyph,
+                                 int Width, int Height, UWORD Color_Foreground, UWORD Color_Background)
+{
+    int X, Y;
+
+    Paint_MapBox(paint, Xpoint, Ypoint, Width, Height, &X, &Y);
+    Paint_BlitRows(paint, X, Y, glyph, atlas->Width, atlas->Height, 0, 0, Color_Foreground, Color_Background);
+}
+
+/******************************************************************************
+function: Build the glyph atlas of an ASCII font
+parameter:
+    Font : Font about to be drawn with
+info:
+    The glyphs are stored rotated and mirrored as the current image is,
+    and Paint_DrawChar() and the string functions copy them straight into
+    the image, at any rotation. Call it again after the rotation or the
+    mirror of the image changes, or the font is drawn as before. Up to
+    PAINT_ATLAS_MAX atlases are kept, for any fonts and orientations,
+    shared by all contexts. Once all are in use a new one drops the
+    oldest, which no other thread may be drawing with at the time.
+    Returns -1 if out of memory or the image is not Scale 2.
+******************************************************************************/
+int Paint_PrepareFont_EN_Ctx(PAINT *paint, sFONT *Font)
+{
+    int stride = (Font->Width + 7) / 8;
+    PAINT_ATLAS *atlas;
+    int n;
+
+    if (Font->Width > MAX_WIDTH_FONT || Font->Height > MAX_HEIGHT_FONT)
+        return -1;
+    pthread_mutex_lock(&Paint_AtlasLock);
+    atlas = Paint_FindAtlas(paint, Font);
+    if (!atlas) {
+        atlas = Paint_NewAtlas(paint, Font->Width, Font->Height, PAINT_ASCII_GLYPHS, 0);
+        if (atlas) {
+            for (n = 0; n < PAINT_ASCII_GLYPHS; n++)
+                Paint_AtlasGlyph(atlas, &Font->table[n * Font->Height * stride], Font->Width, Font->Height,
+                                 atlas->Data + n * atlas->GlyphBytes);
+            Paint_PublishAtlas(atlas, Font);
+        }
+    }
+    pthread_mutex_unlock(&Paint_AtlasLock);
+    return atlas ? 0 : -1;
+}
+
+/******************************************************************************
+function: Set up the glyph atlas of a CN font
+parameter:
+    font : Font about to be drawn with
+info:
+    As Paint_PrepareFont_EN(), but a glyph is only converted the first
+    time it is drawn, so a font pack is still read page by page. Release
+    the atlas with Paint_ReleaseFonts() before closing a font pack.
+******************************************************************************/
+int Paint_PrepareFont_CN_Ctx(PAINT *paint, cFONT *font)
+{
+    PAINT_ATLAS *atlas;
+
+    if (font->Width > MAX_WIDTH_FONT || font->Height > MAX_HEIGHT_FONT || font->size == 0)
+        return -1;
+    pthread_mutex_lock(&Paint_AtlasLock);
+    atlas = Paint_FindAtlas(paint, font);
+    if (!atlas) {
+        atlas = Paint_NewAtlas(paint, font->Width, font->Height, font->size, 1);
+        if (atlas)
+            Paint_PublishAtlas(atlas, font);
+    }
+    pthread_mutex_unlock(&Paint_AtlasLock);
+    return atlas ? 0 : -1;
+}
+
+/******************************************************************************
+function: Free the atlases of all fonts
+info:
+    Must not run while another thread draws text.
+******************************************************************************/
+void Paint_ReleaseFonts(void)
+{
+    int i;
+
+    pthread_mutex_lock(&Paint_AtlasLock);
+    for (i = 0; i < PAINT_ATLAS_MAX; i++)
+        Paint_FreeAtlas(&Paint_Atlas[i]);
+    Paint_AtlasNext = 0;
+    pthread_mutex_unlock(&Paint_AtlasLock);
+}
+
 /******************************************************************************
 function: Show English characters
 parameter:
@@ -515,18 +1253,27 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
+void Paint_DrawChar_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
                     sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
 {
     UWORD Page, Column;
 
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height) {
+    if (Xpoint > paint->Width || Ypoint > paint->Height) {
         Debug("Paint_DrawChar Input exceeds the normal display range\r\n");
         return;
     }
 
     uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
     const unsigned char *ptr = &Font->table[Char_Offset];
+    const PAINT_ATLAS *atlas = Paint_FindAtlas(paint, Font);
+
+    if (atlas && Acsii_Char >= ' ' && Acsii_Char <= '~') {
+        Paint_DrawAtlasGlyph(paint, Xpoint, Ypoint, atlas, atlas->Data + (Acsii_Char - ' ') * atlas->GlyphBytes,
+                             Font->Width, Font->Height, Color_Foreground, Color_Background);
+        return;
+    }
+    if (Paint_BlitGlyph(paint, Xpoint, Ypoint, ptr, Font->Width, Font->Height, Color_Foreground, Color_Background))
+        return;
 
     for (Page = 0; Page < Font->Height; Page ++ ) {
         for (Column = 0; Column < Font->Width; Column ++ ) {
@@ -534,14 +1281,14 @@ void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
             //To determine whether the font background color and screen background color is consistent
             if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
                 if (*ptr & (0x80 >> (Column % 8)))
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+                    Paint_SetPixel_Ctx(paint, Xpoint + Column, Ypoint + Page, Color_Foreground);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
             } else {
                 if (*ptr & (0x80 >> (Column % 8))) {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+                    Paint_SetPixel_Ctx(paint, Xpoint + Column, Ypoint + Page, Color_Foreground);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                 } else {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Background);
+                    Paint_SetPixel_Ctx(paint, Xpoint + Column, Ypoint + Page, Color_Background);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                 }
             }
@@ -564,30 +1311,30 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString,
+void Paint_DrawString_EN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const char * pString,
                          sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
 {
     UWORD Xpoint = Xstart;
     UWORD Ypoint = Ystart;
 
-    if (Xstart > Paint.Width || Ystart > Paint.Height) {
+    if (Xstart > paint->Width || Ystart > paint->Height) {
         Debug("Paint_DrawString_EN Input exceeds the normal display range\r\n");
         return;
     }
 
     while (* pString != '\0') {
         //if X direction filled , reposition to(Xstart,Ypoint),Ypoint is Y direction plus the Height of the character
-        if ((Xpoint + Font->Width ) > Paint.Width ) {
+        if ((Xpoint + Font->Width ) > paint->Width ) {
             Xpoint = Xstart;
             Ypoint += Font->Height;
         }
 
         // If the Y direction is full, reposition to(Xstart, Ystart)
-        if ((Ypoint  + Font->Height ) > Paint.Height ) {
+        if ((Ypoint  + Font->Height ) > paint->Height ) {
             Xpoint = Xstart;
             Ypoint = Ystart;
         }
-        Paint_DrawChar(Xpoint, Ypoint, * pString, Font, Color_Background, Color_Foreground);
+        Paint_DrawChar_Ctx(paint, Xpoint, Ypoint, * pString, Font, Color_Background, Color_Foreground);
 
         //The next character of the address
         pString ++;
@@ -598,6 +1345,77 @@ void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString,
 }
 
 
+/******************************************************************************
+function: Draw one glyph of a CN font
+parameter:
+    x, y             : Top left corner
+    font             : CN font
+    atlas            : Atlas of the font from Paint_FindAtlas(), or NULL
+    Num              : Glyph number
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+info:
+    A glyph missing from the atlas is converted on the spot, under a lock
+    as several threads may draw with the same font.
+******************************************************************************/
+static void Paint_DrawGlyph_CN(PAINT *paint, int x, int y, cFONT* font, PAINT_ATLAS *atlas, int Num,
+                               UWORD Color_Foreground, UWORD Color_Background)
+{
+    unsigned char buf[FONT_CN_GLYPH_MAX];
+    const unsigned char *ptr;
+    int i, j;
+
+    if (atlas && (UDOUBLE)Num < atlas->Count) {
+        UBYTE *glyph = atlas->Data + (size_t)Num * atlas->GlyphBytes;
+
+        if (!__atomic_load_n(&atlas->Ready[Num], __ATOMIC_ACQUIRE)) {
+            pthread_mutex_lock(&Paint_AtlasLock);
+            if (!atlas->Ready[Num]) {
+                ptr = Font_CN_Bitmap(font, Num, buf);
+                if (!ptr) {
+                    pthread_mutex_unlock(&Paint_AtlasLock);
+                    return;
+                }
+                Paint_AtlasGlyph(atlas, ptr, font->Width, font->Height, glyph);
+                __atomic_store_n(&atlas->Ready[Num], 1, __ATOMIC_RELEASE);
+            }
+            pthread_mutex_unlock(&Paint_AtlasLock);
+        }
+        Paint_DrawAtlasGlyph(paint, x, y, atlas, glyph, font->Width, font->Height, Color_Foreground, Color_Background);
+        return;
+    }
+
+    ptr = Font_CN_Bitmap(font, Num, buf);
+    if (!ptr)
+        return;
+    if (Paint_BlitGlyph(paint, x, y, ptr, font->Width, font->Height, Color_Foreground, Color_Background))
+        return;
+    for (j = 0; j < font->Height; j++) {
+        for (i = 0; i < font->Width; i++) {
+            if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
+                if (*ptr & (0x80 >> (i % 8))) {
+                    Paint_SetPixel_Ctx(paint, x + i, y + j, Color_Foreground);
+                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
+                }
+            } else {
+                if (*ptr & (0x80 >> (i % 8))) {
+                    Paint_SetPixel_Ctx(paint, x + i, y + j, Color_Foreground);
+                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
+                } else {
+                    Paint_SetPixel_Ctx(paint, x + i, y + j, Color_Background);
+                    // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
+                }
+            }
+            if (i % 8 == 7) {
+                ptr++;
+            }
+        }
+        if (font->Width % 8 != 0) {
+            ptr++;
+        }
+    }
+}
+
 /******************************************************************************
 function: Display the string
 parameter:
@@ -609,83 +1427,30 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font,
+void Paint_DrawString_CN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font,
                         UWORD Color_Foreground, UWORD Color_Background)
 {
-    const char* p_text = pString;
+    const unsigned char* p_text = (const unsigned char*)pString;
+    PAINT_ATLAS *atlas = Paint_FindAtlas(paint, font);
     int x = Xstart, y = Ystart;
-    int i, j,Num;
+    int Num;
 
     /* Send the string character by character on EPD */
     while (*p_text != 0) {
         if(*p_text <= 0x7F) {  //ASCII < 126
-            for(Num = 0; Num < font->size; Num++) {
-                if(*p_text== font->table[Num].index[0]) {
-                    const char* ptr = &font->table[Num].matrix[0];
-
-                    for (j = 0; j < font->Height; j++) {
-                        for (i = 0; i < font->Width; i++) {
-                            if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            } else {
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                } else {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            }
-                            if (i % 8 == 7) {
-                                ptr++;
-                            }
-                        }
-                        if (font->Width % 8 != 0) {
-                            ptr++;
-                        }
-                    }
-                    break;
-                }
-            }
+            Num = Font_CN_Find(font, p_text[0], 0);
+            if (Num >= 0)
+                Paint_DrawGlyph_CN(paint, x, y, font, atlas, Num, Color_Foreground, Color_Background);
             /* Point on the next character */
             p_text += 1;
             /* Decrement the column position by 16 */
             x += font->ASCII_Width;
         } else {        //Chinese
-            for(Num = 0; Num < font->size; Num++) {
-                if((*p_text== font->table[Num].index[0]) && (*(p_text+1) == font->table[Num].index[1])) {
-                    const char* ptr = &font->table[Num].matrix[0];
-
-                    for (j = 0; j < font->Height; j++) {
-                        for (i = 0; i < font->Width; i++) {
-                            if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            } else {
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                } else {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            }
-                            if (i % 8 == 7) {
-                                ptr++;
-                            }
-                        }
-                        if (font->Width % 8 != 0) {
-                            ptr++;
-                        }
-                    }
-                    break;
-                }
-            }
+            if (p_text[1] == 0)  //Truncated character
+                break;
+            Num = Font_CN_Find(font, p_text[0], p_text[1]);
+            if (Num >= 0)
+                Paint_DrawGlyph_CN(paint, x, y, font, atlas, Num, Color_Foreground, Color_Background);
             /* Point on the next character */
             p_text += 2;
             /* Decrement the column position by 16 */
@@ -694,6 +1459,80 @@ void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT
     }
 }
 
+/******************************************************************************
+function: Display a run of glyph IDs with an ASCII font
+parameter:
+    Xstart           ：X coordinate
+    Ystart           ：Y coordinate
+    Glyphs           ：Glyph IDs, see GLYPH_CN in fonts.h
+    Count            ：Number of glyphs
+    Font             ：A structure pointer that displays a character size
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+info:
+    Unlike Paint_DrawString_EN() the colors are not swapped. Every glyph
+    advances by Font->Width; glyphs the font has no bitmap for (control
+    characters, bytes above '~', CN glyphs) are left blank.
+******************************************************************************/
+void Paint_DrawGlyphs_EN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count,
+                         sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    UWORD Xpoint = Xstart;
+    UWORD i;
+
+    if (Xstart > paint->Width || Ystart > paint->Height) {
+        Debug("Paint_DrawGlyphs_EN Input exceeds the normal display range\r\n");
+        return;
+    }
+
+    for (i = 0; i < Count; i++) {
+        if (Xpoint + Font->Width > paint->Width)
+            break;
+        if (Glyphs[i] >= ' ' && Glyphs[i] <= '~')
+            Paint_DrawChar_Ctx(paint, Xpoint, Ystart, (char)Glyphs[i], Font, Color_Foreground, Color_Background);
+        Xpoint += Font->Width;
+    }
+}
+
+/******************************************************************************
+function: Display a run of glyph IDs with a CN font
+parameter:
+    Xstart           ：X coordinate
+    Ystart           ：Y coordinate
+    Glyphs           ：Glyph IDs, see GLYPH_CN in fonts.h
+    Count            ：Number of glyphs
+    font             ：A structure pointer that displays a character size
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+info:
+    CN glyphs are fetched by number, without a search, and advance by font->Width;
+    single-byte glyphs are found with Font_CN_Find() and advance by
+    font->ASCII_Width. Missing glyphs keep their advance and are left blank.
+******************************************************************************/
+void Paint_DrawGlyphs_CN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count,
+                         cFONT* font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    PAINT_ATLAS *atlas = Paint_FindAtlas(paint, font);
+    int x = Xstart, y = Ystart;
+    int Num;
+    UWORD i;
+
+    for (i = 0; i < Count; i++) {
+        UWORD Glyph = Glyphs[i];
+
+        if (Glyph >= GLYPH_CN) {
+            if (Glyph != GLYPH_MISSING && Glyph - GLYPH_CN < font->size)
+                Paint_DrawGlyph_CN(paint, x, y, font, atlas, Glyph - GLYPH_CN, Color_Foreground, Color_Background);
+            x += font->Width;
+        } else {
+            Num = (Glyph >= ' ' && Glyph <= 0x7F) ? Font_CN_Find(font, (unsigned char)Glyph, 0) : -1;
+            if (Num >= 0)
+                Paint_DrawGlyph_CN(paint, x, y, font, atlas, Num, Color_Foreground, Color_Background);
+            x += font->ASCII_Width;
+        }
+    }
+}
+
 /******************************************************************************
 function:	Display nummber
 parameter:
@@ -705,7 +1544,7 @@ parameter:
     Color_Background : Select the background color
 ******************************************************************************/
 #define  ARRAY_LEN 255
-void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
+void Paint_DrawNum_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
                    sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
 {
 
@@ -713,7 +1552,7 @@ void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
     uint8_t Str_Array[ARRAY_LEN] = {0}, Num_Array[ARRAY_LEN] = {0};
     uint8_t *pStr = Str_Array;
 
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height) {
+    if (Xpoint > paint->Width || Ypoint > paint->Height) {
         Debug("Paint_DisNum Input exceeds the normal display range\r\n");
         return;
     }
@@ -734,7 +1573,7 @@ void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
     }
 
     //show
-    Paint_DrawString_EN(Xpoint, Ypoint, (const char*)pStr, Font, Color_Background, Color_Foreground);
+    Paint_DrawString_EN_Ctx(paint, Xpoint, Ypoint, (const char*)pStr, Font, Color_Background, Color_Foreground);
 }
 
 /******************************************************************************
@@ -748,7 +1587,7 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawNumDecimals(UWORD Xpoint, UWORD Ypoint, double Nummber,
+void Paint_DrawNumDecimals_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, double Nummber,
                     sFONT* Font, UWORD Digit, UWORD Color_Foreground, UWORD Color_Background)
 {
     int16_t Num_Bit = 0, Str_Bit = 0;
@@ -757,7 +1596,7 @@ void Paint_DrawNumDecimals(UWORD Xpoint, UWORD Ypoint, double Nummber,
 	int temp = Nummber;
 	float decimals;
 	uint8_t i;
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height) {
+    if (Xpoint > paint->Width || Ypoint > paint->Height) {
         Debug("Paint_DisNum Input exceeds the normal display range\r\n");
         return;
     }
@@ -794,7 +1633,7 @@ void Paint_DrawNumDecimals(UWORD Xpoint, UWORD Ypoint, double Nummber,
     }
 
     //show
-    Paint_DrawString_EN(Xpoint, Ypoint, (const char*)pStr, Font, Color_Background, Color_Foreground);
+    Paint_DrawString_EN_Ctx(paint, Xpoint, Ypoint, (const char*)pStr, Font, Color_Background, Color_Foreground);
 }
 
 /******************************************************************************
@@ -807,7 +1646,7 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
+void Paint_DrawTime_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
                     UWORD Color_Foreground, UWORD Color_Background)
 {
     uint8_t value[10] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
@@ -815,14 +1654,14 @@ void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
     UWORD Dx = Font->Width;
 
     //Write data into the cache
-    Paint_DrawChar(Xstart                           , Ystart, value[pTime->Hour / 10], Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx                      , Ystart, value[pTime->Hour % 10], Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx  + Dx / 4 + Dx / 2   , Ystart, ':'                    , Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 2 + Dx / 2         , Ystart, value[pTime->Min / 10] , Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 3 + Dx / 2         , Ystart, value[pTime->Min % 10] , Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 4 + Dx / 2 - Dx / 4, Ystart, ':'                    , Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 5                  , Ystart, value[pTime->Sec / 10] , Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 6                  , Ystart, value[pTime->Sec % 10] , Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart                           , Ystart, value[pTime->Hour / 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart + Dx                      , Ystart, value[pTime->Hour % 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart + Dx  + Dx / 4 + Dx / 2   , Ystart, ':'                    , Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart + Dx * 2 + Dx / 2         , Ystart, value[pTime->Min / 10] , Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart + Dx * 3 + Dx / 2         , Ystart, value[pTime->Min % 10] , Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart + Dx * 4 + Dx / 2 - Dx / 4, Ystart, ':'                    , Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart + Dx * 5                  , Ystart, value[pTime->Sec / 10] , Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(paint, Xstart + Dx * 6                  , Ystart, value[pTime->Sec % 10] , Font, Color_Background, Color_Foreground);
 }
 
 /******************************************************************************
@@ -833,15 +1672,375 @@ info:
     Use a computer to convert the image into a corresponding array,
     and then embed the array directly into Imagedata.cpp as a .c file.
 ******************************************************************************/
-void Paint_DrawBitMap(const unsigned char* image_buffer)
+void Paint_DrawBitMap_Ctx(PAINT *paint, const unsigned char* image_buffer)
 {
     UWORD x, y;
     UDOUBLE Addr = 0;
 
-    for (y = 0; y < Paint.HeightByte; y++) {
-        for (x = 0; x < Paint.WidthByte; x++) {//8 pixel =  1 byte
-            Addr = x + y * Paint.WidthByte;
-            Paint.Image[Addr] = (unsigned char)image_buffer[Addr];
+    for (y = 0; y < paint->HeightByte; y++) {
+        for (x = 0; x < paint->WidthByte; x++) {//8 pixel =  1 byte
+            Addr = x + y * paint->WidthByte;
+            paint->Image[Addr] = (unsigned char)image_buffer[Addr];
         }
     }
+    Paint_MarkDirty(paint, 0, 0, paint->WidthMemory, paint->HeightMemory);
+}
+
+/******************************************************************************
+function: Draw upright, turn the image once when it is flushed
+info:
+    Call right after Paint_NewImage() (and Paint_SetMirroring()). The
+    rotation and mirror of the image are kept for Paint_FlushImage() and
+    drawing switches to ROTATE_0 in an upright buffer of Paint.Width x
+    Paint.Height, so no pixel is transformed while drawing. The image
+    buffer then holds the upright frame, ((Width + 7) / 8) * Height bytes
+    in the rotated dimensions: the same size as the panel frame whenever
+    both sides are multiples of 8. Paint_DrawBitMap() data has to be
+    upright as well. Only Scale 2 can be deferred; returns -1 otherwise.
+    A new Paint_NewImage() turns deferral off.
+******************************************************************************/
+int Paint_DeferRotation_Ctx(PAINT *paint)
+{
+    if (paint->Scale != 2)
+        return -1;
+    if (paint->Deferred)
+        return 0;
+
+    paint->FlushRotate = paint->Rotate;
+    paint->FlushMirror = paint->Mirror;
+    paint->FlushWidth = paint->WidthMemory;
+    paint->FlushHeight = paint->HeightMemory;
+
+    paint->Rotate = ROTATE_0;
+    paint->Mirror = MIRROR_NONE;
+    paint->WidthMemory = paint->Width;
+    paint->HeightMemory = paint->Height;
+    paint->WidthByte = (paint->Width + 7) / 8;
+    paint->HeightByte = paint->Height;
+    paint->Deferred = 1;
+    paint->DirtyCount = 0;
+    return 0;
+}
+
+/******************************************************************************
+function: Transpose an 8x8 bit matrix, row 0 in the top byte, MSB first
+******************************************************************************/
+static inline uint64_t Paint_Transpose8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+/******************************************************************************
+function: Turn an upright image into panel order pixel by pixel
+info:
+    For sizes that are not whole bytes on every side.
+******************************************************************************/
+static void Paint_FlushPixels(PAINT *paint, UBYTE *Frame)
+{
+    UWORD frame_byte = (paint->FlushWidth + 7) / 8;
+    int x, y, X, Y;
+
+    memset(Frame, 0, (size_t)frame_byte * paint->FlushHeight);
+    for (y = 0; y < paint->Height; y++) {
+        for (x = 0; x < paint->Width; x++) {
+            if (paint->Image[y * paint->WidthByte + x / 8] & (0x80 >> (x % 8))) {
+                Paint_MapPoint(x, y, paint->FlushWidth, paint->FlushHeight, paint->FlushRotate, paint->FlushMirror, &X, &Y);
+                Frame[Y * frame_byte + X / 8] |= 0x80 >> (X % 8);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function: Panel frame of a deferred image
+parameter:
+    Frame : Receives the frame in the order Paint_NewImage() set up, must
+            not be the image itself
+info:
+    ROTATE_0 and ROTATE_180 copy rows, in reverse order for a vertical
+    flip and with their bytes reversed through Paint_Reverse8 for a
+    horizontal one. ROTATE_90 and ROTATE_270 gather 8 rows of 8 pixels at
+    a time, transpose them as an 8x8 bit matrix and store 8 bytes of
+    panel rows, in tiles of PAINT_FLUSH_TILE x PAINT_FLUSH_TILE blocks so
+    both images stay in cache. An image that is not deferred is copied
+    as it is.
+******************************************************************************/
+#define PAINT_FLUSH_TILE    8
+
+void Paint_FlushImage_Ctx(PAINT *paint, UBYTE *Frame)
+{
+    UWORD wb = paint->WidthByte;
+    UBYTE flip_x, flip_y;
+    int x, y, i;
+
+    if (!paint->Deferred) {
+        if (Frame != paint->Image)
+            memcpy(Frame, paint->Image, (size_t)paint->WidthByte * paint->HeightByte);
+        return;
+    }
+
+    if (paint->FlushRotate == ROTATE_0 || paint->FlushRotate == ROTATE_180) {
+        flip_x = flip_y = (paint->FlushRotate == ROTATE_180);
+        if (paint->FlushMirror == MIRROR_HORIZONTAL || paint->FlushMirror == MIRROR_ORIGIN)
+            flip_x = !flip_x;
+        if (paint->FlushMirror == MIRROR_VERTICAL || paint->FlushMirror == MIRROR_ORIGIN)
+            flip_y = !flip_y;
+        if (flip_x && paint->Width % 8 != 0) {
+            Paint_FlushPixels(paint, Frame);
+            return;
+        }
+
+        for (y = 0; y < paint->Height; y++) {
+            const UBYTE *src = paint->Image + (size_t)y * wb;
+            UBYTE *dst = Frame + (size_t)(flip_y ? paint->Height - 1 - y : y) * wb;
+
+            if (flip_x) {
+                for (x = 0; x < wb; x++)
+                    dst[wb - 1 - x] = Paint_Reverse8[src[x]];
+            } else {
+                memcpy(dst, src, wb);
+            }
+        }
+        return;
+    }
+
+    /* Panel pixel (X, Y) is upright pixel (Y, X), X counted from the right
+       when rev_x and Y from the bottom when rev_y */
+    if (paint->Width % 8 != 0 || paint->Height % 8 != 0) {
+        Paint_FlushPixels(paint, Frame);
+        return;
+    }
+    {
+        UBYTE rev_x = (paint->FlushRotate == ROTATE_90);
+        UBYTE rev_y = (paint->FlushRotate == ROTATE_270);
+        int fb = paint->FlushWidth / 8, blocks_y = paint->FlushHeight / 8;
+        int Xt, Yt, Xb, Yb;
+
+        if (paint->FlushMirror == MIRROR_HORIZONTAL || paint->FlushMirror == MIRROR_ORIGIN)
+            rev_x = !rev_x;
+        if (paint->FlushMirror == MIRROR_VERTICAL || paint->FlushMirror == MIRROR_ORIGIN)
+            rev_y = !rev_y;
+
+        for (Yt = 0; Yt < blocks_y; Yt += PAINT_FLUSH_TILE) {
+            for (Xt = 0; Xt < fb; Xt += PAINT_FLUSH_TILE) {
+                for (Yb = Yt; Yb < blocks_y && Yb < Yt + PAINT_FLUSH_TILE; Yb++) {
+                    int column = rev_y ? blocks_y - 1 - Yb : Yb;
+                    UBYTE *dst = Frame + (size_t)Yb * 8 * fb;
+
+                    for (Xb = Xt; Xb < fb && Xb < Xt + PAINT_FLUSH_TILE; Xb++) {
+                        int row = rev_x ? paint->FlushWidth - 8 - 8 * Xb : 8 * Xb;
+                        const UBYTE *src = paint->Image + (size_t)row * wb + column;
+                        uint64_t m = 0;
+
+                        for (i = 0; i < 8; i++)
+                            m |= (uint64_t)src[i * wb] << (56 - 8 * i);
+                        m = Paint_Transpose8(m);
+                        for (i = 0; i < 8; i++) {
+                            UBYTE b = (UBYTE)(m >> (56 - 8 * (rev_y ? 7 - i : i)));
+                            dst[i * fb + Xb] = rev_x ? Paint_Reverse8[b] : b;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function: Boxes of the panel frame drawn since Paint_ClearDirty()
+parameter:
+    Rects : Receives up to Max boxes
+    Max   : 1 gives the bounding box of everything drawn
+info:
+    Boxes are in the frame written by Paint_FlushImage() (in image memory
+    if rotation is not deferred) and cover whole bytes of a row, so they
+    can be sent to a panel window as they are. Returns the number of boxes.
+******************************************************************************/
+int Paint_GetDirty_Ctx(PAINT *paint, PAINT_RECT *Rects, int Max)
+{
+    int ppb = Paint_PixelsPerByte(paint), n = 0, i;
+
+    if(Max <= 0)
+        return 0;
+    for(i = 0; i < paint->DirtyCount; i++) {
+        PAINT_RECT r = paint->Dirty[i];
+
+        if(paint->Deferred) {
+            int X0, Y0, X1, Y1;
+            Paint_MapPoint(r.Xstart, r.Ystart, paint->FlushWidth, paint->FlushHeight,
+                           paint->FlushRotate, paint->FlushMirror, &X0, &Y0);
+            Paint_MapPoint(r.Xend - 1, r.Yend - 1, paint->FlushWidth, paint->FlushHeight,
+                           paint->FlushRotate, paint->FlushMirror, &X1, &Y1);
+            r.Xstart = (X0 < X1 ? X0 : X1) / ppb * ppb;
+            r.Xend = ((X0 < X1 ? X1 : X0) / ppb + 1) * ppb;
+            r.Ystart = Y0 < Y1 ? Y0 : Y1;
+            r.Yend = (Y0 < Y1 ? Y1 : Y0) + 1;
+            if(r.Xend > paint->FlushWidth)
+                r.Xend = paint->FlushWidth;
+        }
+        if(n < Max) {
+            Rects[n++] = r;
+            continue;
+        }
+        // Past Max, fold into the last box
+        if(r.Xstart < Rects[Max - 1].Xstart) Rects[Max - 1].Xstart = r.Xstart;
+        if(r.Ystart < Rects[Max - 1].Ystart) Rects[Max - 1].Ystart = r.Ystart;
+        if(r.Xend > Rects[Max - 1].Xend) Rects[Max - 1].Xend = r.Xend;
+        if(r.Yend > Rects[Max - 1].Yend) Rects[Max - 1].Yend = r.Yend;
+    }
+    return n;
+}
+
+/******************************************************************************
+function: Forget what has been drawn, once it is on the panel
+******************************************************************************/
+void Paint_ClearDirty_Ctx(PAINT *paint)
+{
+    paint->DirtyCount = 0;
+}
+
+/******************************************************************************
+function: The functions above drawing into the global Paint
+******************************************************************************/
+void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
+{
+    Paint_NewImage_Ctx(&Paint, image, Width, Height, Rotate, Color);
+}
+
+void Paint_SelectImage(UBYTE *image)
+{
+    Paint_SelectImage_Ctx(&Paint, image);
+}
+
+void Paint_SetRotate(UWORD Rotate)
+{
+    Paint_SetRotate_Ctx(&Paint, Rotate);
+}
+
+void Paint_SetMirroring(UBYTE mirror)
+{
+    Paint_SetMirroring_Ctx(&Paint, mirror);
+}
+
+void Paint_SetScale(UBYTE scale)
+{
+    Paint_SetScale_Ctx(&Paint, scale);
+}
+
+void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    Paint_SetPixel_Ctx(&Paint, Xpoint, Ypoint, Color);
+}
+
+void Paint_Clear(UWORD Color)
+{
+    Paint_Clear_Ctx(&Paint, Color);
+}
+
+void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+{
+    Paint_ClearWindows_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color);
+}
+
+void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+{
+    Paint_DrawPoint_Ctx(&Paint, Xpoint, Ypoint, Color, Dot_Pixel, Dot_Style);
+}
+
+void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    Paint_DrawLine_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Style);
+}
+
+void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawRectangle_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Draw_Fill);
+}
+
+void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawCircle_Ctx(&Paint, X_Center, Y_Center, Radius, Color, Line_width, Draw_Fill);
+}
+
+int Paint_PrepareFont_EN(sFONT *Font)
+{
+    return Paint_PrepareFont_EN_Ctx(&Paint, Font);
+}
+
+int Paint_PrepareFont_CN(cFONT *font)
+{
+    return Paint_PrepareFont_CN_Ctx(&Paint, font);
+}
+
+void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawChar_Ctx(&Paint, Xpoint, Ypoint, Acsii_Char, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawString_EN_Ctx(&Paint, Xstart, Ystart, pString, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawString_CN_Ctx(&Paint, Xstart, Ystart, pString, font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawGlyphs_EN(UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawGlyphs_EN_Ctx(&Paint, Xstart, Ystart, Glyphs, Count, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawGlyphs_CN(UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count, cFONT* font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawGlyphs_CN_Ctx(&Paint, Xstart, Ystart, Glyphs, Count, font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawNum_Ctx(&Paint, Xpoint, Ypoint, Nummber, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawNumDecimals(UWORD Xpoint, UWORD Ypoint, double Nummber, sFONT* Font, UWORD Digit, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawNumDecimals_Ctx(&Paint, Xpoint, Ypoint, Nummber, Font, Digit, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawTime_Ctx(&Paint, Xstart, Ystart, pTime, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawBitMap(const unsigned char* image_buffer)
+{
+    Paint_DrawBitMap_Ctx(&Paint, image_buffer);
+}
+
+int Paint_DeferRotation(void)
+{
+    return Paint_DeferRotation_Ctx(&Paint);
+}
+
+void Paint_FlushImage(UBYTE *Frame)
+{
+    Paint_FlushImage_Ctx(&Paint, Frame);
+}
+
+int Paint_GetDirty(PAINT_RECT *Rects, int Max)
+{
+    return Paint_GetDirty_Ctx(&Paint, Rects, Max);
+}
+
+void Paint_ClearDirty(void)
+{
+    Paint_ClearDirty_Ctx(&Paint);
 }
@@ -73,6 +73,18 @@
 #include "DEV_Config.h"
 #include "../Fonts/fonts.h"
 
+/**
+ * Box of image memory, Xend and Yend not included
+**/
+typedef struct {
+    UWORD Xstart;
+    UWORD Ystart;
+    UWORD Xend;
+    UWORD Yend;
+} PAINT_RECT;
+
+#define PAINT_DIRTY_MAX     16      // Boxes kept apart before the closest are merged
+
 /**
  * Image attributes
 **/
@@ -88,6 +100,14 @@ typedef struct {
     UWORD WidthByte;
     UWORD HeightByte;
     UWORD Scale;
+    UBYTE Deferred;         // Drawn upright, turned by Paint_FlushImage()
+    UWORD FlushRotate;      // Rotation and mirror applied when flushed
+    UWORD FlushMirror;
+    UWORD FlushWidth;       // Size of the panel frame
+    UWORD FlushHeight;
+    UBYTE DirtyCount;       // Drawn since Paint_ClearDirty(), whole bytes of image memory
+    UBYTE DirtyLast;        // Box marked last
+    PAINT_RECT Dirty[PAINT_DIRTY_MAX];
 } PAINT;
 extern PAINT Paint;
 
@@ -187,6 +207,10 @@ void Paint_SetRotate(UWORD Rotate);
 void Paint_SetMirroring(UBYTE mirror);
 void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color);
 void Paint_SetScale(UBYTE scale);
+int Paint_DeferRotation(void);
+void Paint_FlushImage(UBYTE *Frame);
+int Paint_GetDirty(PAINT_RECT *Rects, int Max);
+void Paint_ClearDirty(void);
 
 void Paint_Clear(UWORD Color);
 void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
@@ -201,6 +225,11 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color,
 void Paint_DrawChar(UWORD Xstart, UWORD Ystart, const char Acsii_Char, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawGlyphs_EN(UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawGlyphs_CN(UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count, cFONT* font, UWORD Color_Foreground, UWORD Color_Background);
+int Paint_PrepareFont_EN(sFONT* Font);
+int Paint_PrepareFont_CN(cFONT* font);
+void Paint_ReleaseFonts(void);
 void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawNumDecimals(UWORD Xpoint, UWORD Ypoint, double Nummber, sFONT* Font, UWORD Digit, UWORD Color_Foreground, UWORD Color_Background); // Able to display decimals
 void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
@@ -209,6 +238,43 @@ void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
 void Paint_DrawBitMap(const unsigned char* image_buffer);
 
 
+//Painter contexts: the functions above, drawing into paint instead of Paint
+void Paint_NewImage_Ctx(PAINT *paint, UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color);
+void Paint_SelectImage_Ctx(PAINT *paint, UBYTE *image);
+void Paint_SetRotate_Ctx(PAINT *paint, UWORD Rotate);
+void Paint_SetMirroring_Ctx(PAINT *paint, UBYTE mirror);
+void Paint_SetPixel_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, UWORD Color);
+void Paint_SetScale_Ctx(PAINT *paint, UBYTE scale);
+int Paint_DeferRotation_Ctx(PAINT *paint);
+void Paint_FlushImage_Ctx(PAINT *paint, UBYTE *Frame);
+int Paint_GetDirty_Ctx(PAINT *paint, PAINT_RECT *Rects, int Max);
+void Paint_ClearDirty_Ctx(PAINT *paint);
+
+void Paint_Clear_Ctx(PAINT *paint, UWORD Color);
+void Paint_ClearWindows_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
+
+//Drawing
+void Paint_DrawPoint_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay);
+void Paint_DrawLine_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+void Paint_DrawRectangle_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawCircle_Ctx(PAINT *paint, UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+
+//Display string
+void Paint_DrawChar_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const char Acsii_Char, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawString_EN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const char * pString, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawString_CN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawGlyphs_EN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawGlyphs_CN_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, const UWORD * Glyphs, UWORD Count, cFONT* font, UWORD Color_Foreground, UWORD Color_Background);
+int Paint_PrepareFont_EN_Ctx(PAINT *paint, sFONT* Font);
+int Paint_PrepareFont_CN_Ctx(PAINT *paint, cFONT* font);
+void Paint_DrawNum_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawNumDecimals_Ctx(PAINT *paint, UWORD Xpoint, UWORD Ypoint, double Nummber, sFONT* Font, UWORD Digit, UWORD Color_Foreground, UWORD Color_Background); // Able to display decimals
+void Paint_DrawTime_Ctx(PAINT *paint, UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+
+//pic
+void Paint_DrawBitMap_Ctx(PAINT *paint, const unsigned char* image_buffer);
+
+
 #endif
 
 
@@ -0,0 +1,424 @@
+/*****************************************************************************
+* | File      	:   Reader_Cache.c
+* | Function    :   Pages rendered ahead into panel frames
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Cache.h"
+#include "Debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************
+function:	PackBits each row of a frame on its own
+parameter:
+    frame      : Rows of width_byte bytes
+    width_byte : Bytes of one row
+    height     : Number of rows
+    dst        : Receives the packed rows, holds at least
+                 height * (width_byte + width_byte / 128 + 1) bytes
+info:
+    A header byte n below 128 is followed by n + 1 literal bytes, one
+    above 128 by a byte repeated 257 - n times, as in font packs. No
+    run crosses a row, so rows unpack one at a time. Returns the packed
+    size.
+******************************************************************************/
+uint32_t Reader_Cache_PackRows(const uint8_t *frame, uint32_t width_byte, uint32_t height, uint8_t *dst)
+{
+    uint32_t y, n = 0;
+
+    for (y = 0; y < height; y++) {
+        const uint8_t *src = frame + (size_t)y * width_byte;
+        uint32_t i = 0;
+
+        while (i < width_byte) {
+            uint32_t run = 1, start, len;
+
+            while (i + run < width_byte && run < 128 && src[i + run] == src[i])
+                run++;
+            if (run >= 3) {
+                dst[n++] = (uint8_t)(257 - run);
+                dst[n++] = src[i];
+                i += run;
+                continue;
+            }
+            // Literals up to the next run of three
+            start = i;
+            len = 0;
+            while (i < width_byte && len < 128) {
+                if (i + 2 < width_byte && src[i] == src[i + 1] && src[i] == src[i + 2])
+                    break;
+                i++;
+                len++;
+            }
+            dst[n++] = (uint8_t)(len - 1);
+            memcpy(dst + n, src + start, len);
+            n += len;
+        }
+    }
+    return n;
+}
+
+/******************************************************************************
+function:	Unpack rows packed by Reader_Cache_PackRows()
+parameter:
+    src        : Packed rows
+    size       : Bytes of src
+    width_byte : Bytes of one row
+    height     : Rows to unpack
+    frame      : Receives them
+info:
+    Returns the number of whole rows unpacked, height unless src is
+    short or damaged.
+******************************************************************************/
+uint32_t Reader_Cache_UnpackRows(const uint8_t *src, uint32_t size, uint32_t width_byte, uint32_t height,
+                                 uint8_t *frame)
+{
+    uint32_t y, i = 0;
+
+    for (y = 0; y < height; y++) {
+        uint8_t *row = frame + (size_t)y * width_byte;
+        uint32_t n = 0;
+
+        while (n < width_byte) {
+            uint32_t h, run;
+
+            if (i >= size)
+                return y;
+            h = src[i++];
+            if (h < 128) {
+                run = h + 1;
+                if (run > size - i || run > width_byte - n)
+                    return y;
+                memcpy(row + n, src + i, run);
+                i += run;
+            } else if (h > 128) {
+                run = 257 - h;
+                if (i >= size || run > width_byte - n)
+                    return y;
+                memset(row + n, src[i++], run);
+            } else {
+                continue;
+            }
+            n += run;
+        }
+    }
+    return height;
+}
+
+/******************************************************************************
+function:	Slot holding or rendering key (lock held), -1 if none
+******************************************************************************/
+static int Reader_Cache_Find(READER_CACHE *cache, uint32_t key)
+{
+    int i;
+
+    for (i = 0; i < cache->Slots; i++)
+        if (cache->Slot[i].State != READER_CACHE_FREE && cache->Slot[i].Key == key)
+            return i;
+    return -1;
+}
+
+static int Reader_Cache_Wanted(READER_CACHE *cache, uint32_t key)
+{
+    int i;
+
+    for (i = 0; i < cache->Wants; i++)
+        if (cache->Want[i] == key)
+            return 1;
+    return 0;
+}
+
+/******************************************************************************
+function:	Give up a slot (lock held)
+******************************************************************************/
+static void Reader_Cache_Drop(READER_CACHE *cache, READER_CACHE_SLOT *s)
+{
+    if (s->State == READER_CACHE_READY) {
+        if (!s->Taken)
+            cache->Stats.Wasted++;
+        cache->Stats.Pages--;
+        cache->Stats.Bytes -= s->Size;
+    }
+    free(s->Data);
+    s->Data = NULL;
+    s->Size = 0;
+    s->State = READER_CACHE_FREE;
+}
+
+/******************************************************************************
+function:	Ready slot of the least recently used page no longer wanted (lock held)
+******************************************************************************/
+static int Reader_Cache_Unwanted(READER_CACHE *cache)
+{
+    int i, victim = -1;
+
+    for (i = 0; i < cache->Slots; i++) {
+        READER_CACHE_SLOT *s = &cache->Slot[i];
+        if (s->State == READER_CACHE_READY && !Reader_Cache_Wanted(cache, s->Key) &&
+            (victim < 0 || s->Stamp < cache->Slot[victim].Stamp))
+            victim = i;
+    }
+    return victim;
+}
+
+/******************************************************************************
+function:	Next page for the worker and the slot to render it into (lock held)
+parameter:
+    key : Set to the page to render
+info:
+    A free slot first, then the ready slot least recently used among those
+    no longer wanted. -1 when every wanted page is ready or being rendered,
+    no slot can be given up or the budget is spent.
+******************************************************************************/
+static int Reader_Cache_Next(READER_CACHE *cache, uint32_t *key)
+{
+    int i, w, victim;
+
+    if (cache->Full)
+        return -1;
+    for (w = 0; w < cache->Wants; w++) {
+        if (Reader_Cache_Find(cache, cache->Want[w]) >= 0)
+            continue;
+        victim = -1;
+        for (i = 0; i < cache->Slots && victim < 0; i++)
+            if (cache->Slot[i].State == READER_CACHE_FREE)
+                victim = i;
+        if (victim < 0)
+            victim = Reader_Cache_Unwanted(cache);
+        if (victim < 0)
+            return -1;
+        Reader_Cache_Drop(cache, &cache->Slot[victim]);
+        *key = cache->Want[w];
+        return victim;
+    }
+    return -1;
+}
+
+static void *Reader_Cache_Worker(void *arg)
+{
+    READER_CACHE *cache = (READER_CACHE *)arg;
+
+    pthread_mutex_lock(&cache->Lock);
+    while (!cache->Stop) {
+        READER_CACHE_SLOT *s;
+        uint32_t key, generation, next, size = 0;
+        uint8_t *data = NULL;
+        int slot, ok;
+
+        slot = Reader_Cache_Next(cache, &key);
+        if (slot < 0) {
+            pthread_cond_wait(&cache->Wake, &cache->Lock);
+            continue;
+        }
+        s = &cache->Slot[slot];
+        s->Key = key;
+        s->State = READER_CACHE_RENDERING;
+        s->Taken = 0;
+        generation = cache->Generation;
+        pthread_mutex_unlock(&cache->Lock);
+
+        ok = cache->Render(cache->Arg, key, cache->Frame, &next) == 0;
+        if (ok) {
+            size = Reader_Cache_PackRows(cache->Frame, cache->WidthByte, cache->Height, cache->Packed);
+            data = malloc(size);
+            ok = data != NULL;
+            if (ok)
+                memcpy(data, cache->Packed, size);
+        }
+
+        pthread_mutex_lock(&cache->Lock);
+        // Room within the budget, from pages no longer wanted
+        while (ok && cache->Stats.Bytes + size > cache->Budget && (slot = Reader_Cache_Unwanted(cache)) >= 0)
+            Reader_Cache_Drop(cache, &cache->Slot[slot]);
+        if (ok && cache->Stats.Bytes + size > cache->Budget)
+            cache->Full = 1;
+        if (ok && !cache->Full && generation == cache->Generation) {
+            s->Data = data;
+            s->Size = size;
+            s->Next = next;
+            s->State = READER_CACHE_READY;
+            s->Stamp = ++cache->Clock;
+            cache->Stats.Rendered++;
+            cache->Stats.Pages++;
+            cache->Stats.Bytes += size;
+        } else {
+            free(data);
+            s->State = READER_CACHE_FREE;
+        }
+        pthread_cond_broadcast(&cache->Done);
+    }
+    pthread_mutex_unlock(&cache->Lock);
+    return NULL;
+}
+
+/******************************************************************************
+function:	Set up the slots and start the worker
+parameter:
+    slots      : Pages kept, at most READER_CACHE_SLOTS
+    width_byte : Bytes of one row of a panel frame
+    height     : Rows of a panel frame
+    budget     : Packed bytes kept at most
+    render     : Draws a page into a frame, called on the worker
+    arg        : Passed to render
+info:
+    Returns 0, or -1 with the cache left unusable; every other call
+    is then a no-op, Reader_Cache_Take() a miss.
+******************************************************************************/
+int Reader_Cache_Init(READER_CACHE *cache, int slots, uint32_t width_byte, uint32_t height, uint32_t budget,
+                      READER_CACHE_RENDER render, void *arg)
+{
+    memset(cache, 0, sizeof(*cache));
+    if (slots <= 0 || slots > READER_CACHE_SLOTS || !render)
+        return -1;
+    cache->Frame = malloc((size_t)width_byte * height);
+    cache->Packed = malloc((size_t)height * (width_byte + width_byte / 128 + 1));
+    if (!cache->Frame || !cache->Packed)
+        goto fail;
+    cache->WidthByte = width_byte;
+    cache->Height = height;
+    cache->Budget = budget;
+    cache->Render = render;
+    cache->Arg = arg;
+    pthread_mutex_init(&cache->Lock, NULL);
+    pthread_cond_init(&cache->Wake, NULL);
+    pthread_cond_init(&cache->Done, NULL);
+    cache->Slots = slots;
+    if (pthread_create(&cache->Thread, NULL, Reader_Cache_Worker, cache) != 0) {
+        pthread_mutex_destroy(&cache->Lock);
+        pthread_cond_destroy(&cache->Wake);
+        pthread_cond_destroy(&cache->Done);
+        goto fail;
+    }
+    return 0;
+
+fail:
+    Debug("Reader_Cache_Init: could not start the worker\r\n");
+    free(cache->Frame);
+    free(cache->Packed);
+    memset(cache, 0, sizeof(*cache));
+    return -1;
+}
+
+/******************************************************************************
+function:	Stop the worker and free every page
+******************************************************************************/
+void Reader_Cache_Free(READER_CACHE *cache)
+{
+    int i;
+
+    if (cache->Slots == 0)
+        return;
+    pthread_mutex_lock(&cache->Lock);
+    cache->Stop = 1;
+    pthread_cond_signal(&cache->Wake);
+    pthread_mutex_unlock(&cache->Lock);
+    pthread_join(cache->Thread, NULL);
+
+    for (i = 0; i < cache->Slots; i++)
+        free(cache->Slot[i].Data);
+    free(cache->Frame);
+    free(cache->Packed);
+    pthread_mutex_destroy(&cache->Lock);
+    pthread_cond_destroy(&cache->Wake);
+    pthread_cond_destroy(&cache->Done);
+    memset(cache, 0, sizeof(*cache));
+}
+
+/******************************************************************************
+function:	Name the pages to have ready
+parameter:
+    keys  : Text offsets the pages start at, most wanted first
+    count : Number of keys, those past the number of slots are left out
+info:
+    Replaces the previous list. Ready pages stay until their slot or
+    their bytes are needed for a page on the list; when the budget runs
+    out the pages further down the list are not rendered.
+******************************************************************************/
+void Reader_Cache_Want(READER_CACHE *cache, const uint32_t *keys, int count)
+{
+    if (cache->Slots == 0)
+        return;
+    if (count > cache->Slots)
+        count = cache->Slots;
+    pthread_mutex_lock(&cache->Lock);
+    memcpy(cache->Want, keys, sizeof(uint32_t) * (count > 0 ? count : 0));
+    cache->Wants = count > 0 ? count : 0;
+    cache->Full = 0;
+    pthread_cond_signal(&cache->Wake);
+    pthread_mutex_unlock(&cache->Lock);
+}
+
+/******************************************************************************
+function:	Unpack the page starting at key into frame
+parameter:
+    next : Set to where the page after it starts, on a hit
+info:
+    Returns 1 on a hit. A page the worker is rendering is waited for, it
+    is closer to done than a page drawn from scratch; 0 when the page is
+    neither, frame may then be overwritten.
+******************************************************************************/
+int Reader_Cache_Take(READER_CACHE *cache, uint32_t key, uint8_t *frame, uint32_t *next)
+{
+    int slot, hit = 0;
+
+    if (cache->Slots == 0)
+        return 0;
+    pthread_mutex_lock(&cache->Lock);
+    while ((slot = Reader_Cache_Find(cache, key)) >= 0 && cache->Slot[slot].State == READER_CACHE_RENDERING)
+        pthread_cond_wait(&cache->Done, &cache->Lock);
+    if (slot >= 0 && Reader_Cache_UnpackRows(cache->Slot[slot].Data, cache->Slot[slot].Size,
+                                             cache->WidthByte, cache->Height, frame) == cache->Height) {
+        *next = cache->Slot[slot].Next;
+        cache->Slot[slot].Taken = 1;
+        cache->Slot[slot].Stamp = ++cache->Clock;
+        hit = 1;
+        cache->Stats.Hits++;
+    } else {
+        cache->Stats.Misses++;
+    }
+    pthread_mutex_unlock(&cache->Lock);
+    return hit;
+}
+
+/******************************************************************************
+function:	Drop every page and the list of wanted ones
+info:
+    Waits for a render in progress. Nothing is rendered again until the
+    next Reader_Cache_Want(), so what the callback reads may change.
+******************************************************************************/
+void Reader_Cache_Invalidate(READER_CACHE *cache)
+{
+    int i, busy;
+
+    if (cache->Slots == 0)
+        return;
+    pthread_mutex_lock(&cache->Lock);
+    cache->Generation++;
+    cache->Wants = 0;
+    do {
+        busy = 0;
+        for (i = 0; i < cache->Slots; i++)
+            busy |= cache->Slot[i].State == READER_CACHE_RENDERING;
+        if (busy)
+            pthread_cond_wait(&cache->Done, &cache->Lock);
+    } while (busy);
+    for (i = 0; i < cache->Slots; i++)
+        Reader_Cache_Drop(cache, &cache->Slot[i]);
+    cache->Full = 0;
+    pthread_mutex_unlock(&cache->Lock);
+}
+
+void Reader_Cache_GetStats(READER_CACHE *cache, READER_CACHE_STATS *stats)
+{
+    if (cache->Slots == 0) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    pthread_mutex_lock(&cache->Lock);
+    *stats = cache->Stats;
+    pthread_mutex_unlock(&cache->Lock);
+}
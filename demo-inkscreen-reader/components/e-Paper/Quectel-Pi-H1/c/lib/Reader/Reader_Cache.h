@@ -0,0 +1,100 @@
+/*****************************************************************************
+* | File      	:   Reader_Cache.h
+* | Function    :   Pages rendered ahead into panel frames
+* | Info        :
+*   Slots hold whole panel frames, keyed by the text offset their page
+*   starts at. The reader names the pages it wants ready (the next few
+*   and some before, say) once the panel is idle; a worker thread renders
+*   them through a callback, or into the slot of the least recently used
+*   page no longer wanted. A page turn that finds its page ready only
+*   unpacks the frame.
+*
+*   Frames are kept PackBits compressed, each row on its own, so a page
+*   of text on a plain background takes a few KB instead of a whole
+*   frame and unpacks a row at a time straight into the frame that goes
+*   to the panel. Pages are kept within a byte budget; the least recently
+*   used page no longer wanted makes room first.
+*
+*   The callback runs on the worker and must only read what the caller
+*   leaves alone until Reader_Cache_Invalidate() returns, which waits for
+*   a render in progress and drops every slot.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __READER_CACHE_H
+#define __READER_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define READER_CACHE_SLOTS      64  // Pages kept at most
+
+#define READER_CACHE_FREE       0
+#define READER_CACHE_RENDERING  1
+#define READER_CACHE_READY      2
+
+/**
+ * Draws the page starting at Key into Frame and sets Next to where the
+ * page after it starts, 0 on success
+**/
+typedef int (*READER_CACHE_RENDER)(void *Arg, uint32_t Key, uint8_t *Frame, uint32_t *Next);
+
+typedef struct {
+    uint32_t Key;           // Text offset the page starts at
+    uint32_t Next;          // and the one after it
+    uint8_t State;          // READER_CACHE_FREE, _RENDERING or _READY
+    uint8_t Taken;          // Shown since it was rendered
+    uint32_t Stamp;         // Last rendered or taken, for eviction
+    uint8_t *Data;          // Packed rows, top to bottom, while READY
+    uint32_t Size;          // Bytes of Data
+} READER_CACHE_SLOT;
+
+/**
+ * Counters since Reader_Cache_Init()
+**/
+typedef struct {
+    uint32_t Hits;          // Page turns served from a slot
+    uint32_t Misses;        // Page turns drawn on the spot
+    uint32_t Rendered;      // Frames the worker finished
+    uint32_t Wasted;        // Frames dropped before they were shown
+    uint32_t Pages;         // Pages kept now
+    uint32_t Bytes;         // Packed bytes they take
+} READER_CACHE_STATS;
+
+typedef struct {
+    pthread_mutex_t Lock;
+    pthread_cond_t Wake;    // Work for the worker
+    pthread_cond_t Done;    // A render finished
+    pthread_t Thread;
+    int Stop;
+    int Slots;              // 0 until Reader_Cache_Init() succeeds
+    uint32_t WidthByte;     // Frame geometry, rows are packed one by one
+    uint32_t Height;
+    uint32_t Budget;        // Packed bytes kept at most
+    int Full;               // Out of budget for the wanted pages, until the next Want
+    READER_CACHE_RENDER Render;
+    void *Arg;
+    uint8_t *Frame;         // Worker side: the frame rendered
+    uint8_t *Packed;        // and packed, worst case size
+    READER_CACHE_SLOT Slot[READER_CACHE_SLOTS];
+    uint32_t Want[READER_CACHE_SLOTS];  // Pages to have ready, most wanted first
+    int Wants;
+    uint32_t Generation;    // Bumped by Reader_Cache_Invalidate()
+    uint32_t Clock;
+    READER_CACHE_STATS Stats;
+} READER_CACHE;
+
+int Reader_Cache_Init(READER_CACHE *cache, int slots, uint32_t width_byte, uint32_t height, uint32_t budget,
+                      READER_CACHE_RENDER render, void *arg);
+void Reader_Cache_Free(READER_CACHE *cache);
+void Reader_Cache_Want(READER_CACHE *cache, const uint32_t *keys, int count);
+int Reader_Cache_Take(READER_CACHE *cache, uint32_t key, uint8_t *frame, uint32_t *next);
+void Reader_Cache_Invalidate(READER_CACHE *cache);
+void Reader_Cache_GetStats(READER_CACHE *cache, READER_CACHE_STATS *stats);
+uint32_t Reader_Cache_PackRows(const uint8_t *frame, uint32_t width_byte, uint32_t height, uint8_t *dst);
+uint32_t Reader_Cache_UnpackRows(const uint8_t *src, uint32_t size, uint32_t width_byte, uint32_t height,
+                                 uint8_t *frame);
+
+#endif
@@ -0,0 +1,343 @@
+/*****************************************************************************
+* | File      	:   Reader_Display.c
+* | Function    :   Panel commands run by a display thread of their own
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Display.h"
+#include "Debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+static uint64_t Reader_Display_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void Reader_Display_Signal(int fd)
+{
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) != sizeof(one))
+        Debug("Reader_Display: event lost\r\n");
+}
+
+/******************************************************************************
+function:	Run one command, waking the panel first if a drawing one finds it asleep
+******************************************************************************/
+static void Reader_Display_Run(READER_DISPLAY *display, const READER_DISPLAY_CMD *cmd)
+{
+    const READER_DISPLAY_OPS *ops = &display->Ops;
+    int woken = 0;
+
+    if (display->Asleep && cmd->Type != READER_DISPLAY_WAKE && cmd->Type != READER_DISPLAY_SLEEP) {
+        ops->Wake(display->Arg, display->WakeMode);
+        display->Asleep = 0;
+        woken = 1;
+    }
+    switch (cmd->Type) {
+    case READER_DISPLAY_FULL:
+        ops->Full(display->Arg, cmd->Frame);
+        break;
+    case READER_DISPLAY_WINDOW:
+        ops->Window(display->Arg, cmd->Frame, cmd->Xstart, cmd->Ystart, cmd->Xend, cmd->Yend);
+        break;
+    case READER_DISPLAY_SLEEP:
+        if (!display->Asleep)
+            ops->Sleep(display->Arg);
+        display->Asleep = 1;
+        break;
+    case READER_DISPLAY_WAKE:
+        ops->Wake(display->Arg, cmd->Mode);
+        display->WakeMode = cmd->Mode;
+        display->Asleep = 0;
+        break;
+    case READER_DISPLAY_CLEAR:
+        ops->Clear(display->Arg);
+        break;
+    }
+    if (woken) {
+        pthread_mutex_lock(&display->Lock);
+        display->Stats.Woken++;
+        pthread_mutex_unlock(&display->Lock);
+    }
+}
+
+static void *Reader_Display_Worker(void *arg)
+{
+    READER_DISPLAY *display = (READER_DISPLAY *)arg;
+    uint64_t count;
+
+    for (;;) {
+        uint32_t tail = display->Tail;
+
+        // Everything queued so far, then sleep until the next command or Stop
+        while (tail != __atomic_load_n(&display->Head, __ATOMIC_ACQUIRE)) {
+            READER_DISPLAY_CMD *cmd = &display->Queue[tail % READER_DISPLAY_QUEUE];
+            READER_DISPLAY_TIMES *t;
+            uint64_t start, end;
+
+            start = Reader_Display_Now();
+            Reader_Display_Run(display, cmd);
+            end = Reader_Display_Now();
+
+            pthread_mutex_lock(&display->Lock);
+            t = &display->Stats.Command[cmd->Type];
+            t->Count++;
+            t->WaitSum += start - cmd->Queued;
+            t->RunSum += end - start;
+            if (start - cmd->Queued > t->WaitMax)
+                t->WaitMax = start - cmd->Queued;
+            if (end - start > t->RunMax)
+                t->RunMax = end - start;
+            pthread_mutex_unlock(&display->Lock);
+
+            __atomic_store_n(&display->Tail, ++tail, __ATOMIC_RELEASE);
+            Reader_Display_Signal(display->Done);
+        }
+        if (__atomic_load_n(&display->Stop, __ATOMIC_ACQUIRE))
+            break;
+        if (read(display->Work, &count, sizeof(count)) < 0)
+            Debug("Reader_Display: waiting for work failed\r\n");
+    }
+    return NULL;
+}
+
+/******************************************************************************
+function:	Wait for the display thread to finish one more command
+******************************************************************************/
+static void Reader_Display_WaitDone(READER_DISPLAY *display)
+{
+    struct pollfd pfd = {display->Done, POLLIN, 0};
+    uint64_t count;
+
+    if (poll(&pfd, 1, -1) > 0 && read(display->Done, &count, sizeof(count)) < 0)
+        Debug("Reader_Display: reading done events failed\r\n");
+}
+
+/******************************************************************************
+function:	Slot for the next command, waiting for room when the queue is full
+info:
+    Returns NULL before Reader_Display_Init().
+******************************************************************************/
+static READER_DISPLAY_CMD *Reader_Display_Slot(READER_DISPLAY *display, uint8_t type)
+{
+    READER_DISPLAY_CMD *cmd;
+
+    if (!display->Started)
+        return NULL;
+    while (display->Head - __atomic_load_n(&display->Tail, __ATOMIC_ACQUIRE) >= READER_DISPLAY_QUEUE)
+        Reader_Display_WaitDone(display);
+    cmd = &display->Queue[display->Head % READER_DISPLAY_QUEUE];
+    cmd->Type = type;
+    return cmd;
+}
+
+/******************************************************************************
+function:	Hand the filled slot to the display thread
+******************************************************************************/
+static int Reader_Display_Push(READER_DISPLAY *display, READER_DISPLAY_CMD *cmd)
+{
+    cmd->Queued = Reader_Display_Now();
+    __atomic_store_n(&display->Head, display->Head + 1, __ATOMIC_RELEASE);
+    Reader_Display_Signal(display->Work);
+    return 0;
+}
+
+/******************************************************************************
+function:	Set up the queue and start the display thread
+parameter:
+    width_byte : Bytes of one row of a panel frame
+    height     : Rows of a panel frame
+    ops        : What the thread does with the panel, copied
+    arg        : Passed to ops
+info:
+    The panel is taken to be awake. Returns 0, or -1 with every command
+    refused; the caller may then drive the panel itself.
+******************************************************************************/
+int Reader_Display_Init(READER_DISPLAY *display, uint32_t width_byte, uint32_t height,
+                        const READER_DISPLAY_OPS *ops, void *arg)
+{
+    int i;
+
+    memset(display, 0, sizeof(*display));
+    display->Work = display->Done = -1;
+    if (!ops->Full || !ops->Window || !ops->Sleep || !ops->Wake || !ops->Clear)
+        return -1;
+    for (i = 0; i < READER_DISPLAY_QUEUE; i++) {
+        display->Queue[i].Frame = malloc((size_t)width_byte * height);
+        if (!display->Queue[i].Frame)
+            goto fail;
+    }
+    display->Work = eventfd(0, EFD_CLOEXEC);
+    display->Done = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (display->Work < 0 || display->Done < 0)
+        goto fail;
+    display->WidthByte = width_byte;
+    display->Height = height;
+    display->Ops = *ops;
+    display->Arg = arg;
+    pthread_mutex_init(&display->Lock, NULL);
+    if (pthread_create(&display->Thread, NULL, Reader_Display_Worker, display) != 0) {
+        pthread_mutex_destroy(&display->Lock);
+        goto fail;
+    }
+    display->Started = 1;
+    return 0;
+
+fail:
+    Debug("Reader_Display_Init: could not start the display thread\r\n");
+    for (i = 0; i < READER_DISPLAY_QUEUE; i++)
+        free(display->Queue[i].Frame);
+    if (display->Work >= 0)
+        close(display->Work);
+    if (display->Done >= 0)
+        close(display->Done);
+    memset(display, 0, sizeof(*display));
+    display->Work = display->Done = -1;
+    return -1;
+}
+
+/******************************************************************************
+function:	Run what is queued, then stop the display thread
+******************************************************************************/
+void Reader_Display_Free(READER_DISPLAY *display)
+{
+    int i;
+
+    if (!display->Started)
+        return;
+    __atomic_store_n(&display->Stop, 1, __ATOMIC_RELEASE);
+    Reader_Display_Signal(display->Work);
+    pthread_join(display->Thread, NULL);
+
+    for (i = 0; i < READER_DISPLAY_QUEUE; i++)
+        free(display->Queue[i].Frame);
+    close(display->Work);
+    close(display->Done);
+    pthread_mutex_destroy(&display->Lock);
+    memset(display, 0, sizeof(*display));
+    display->Work = display->Done = -1;
+}
+
+/******************************************************************************
+function:	Queue a full refresh of a whole frame
+info:
+    The frame is copied, it may change as soon as this returns. Like
+    every command, waits for room when READER_DISPLAY_QUEUE commands are
+    still queued; returns -1 without a display thread.
+******************************************************************************/
+int Reader_Display_Full(READER_DISPLAY *display, const uint8_t *frame)
+{
+    READER_DISPLAY_CMD *cmd = Reader_Display_Slot(display, READER_DISPLAY_FULL);
+
+    if (!cmd)
+        return -1;
+    memcpy(cmd->Frame, frame, (size_t)display->WidthByte * display->Height);
+    return Reader_Display_Push(display, cmd);
+}
+
+/******************************************************************************
+function:	Queue a partial refresh of a window of a whole frame
+parameter:
+    frame            : Whole panel frame
+    x_start, y_start : Top left corner
+    x_end, y_end     : Bottom right corner, not included
+info:
+    Only the rows of the window are copied.
+******************************************************************************/
+int Reader_Display_Window(READER_DISPLAY *display, const uint8_t *frame,
+                          uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end)
+{
+    READER_DISPLAY_CMD *cmd = Reader_Display_Slot(display, READER_DISPLAY_WINDOW);
+
+    if (!cmd)
+        return -1;
+    if (y_end > display->Height)
+        y_end = display->Height;
+    if (y_start < y_end)
+        memcpy(cmd->Frame + (size_t)y_start * display->WidthByte, frame + (size_t)y_start * display->WidthByte,
+               (size_t)(y_end - y_start) * display->WidthByte);
+    cmd->Xstart = x_start;
+    cmd->Ystart = y_start;
+    cmd->Xend = x_end;
+    cmd->Yend = y_end;
+    return Reader_Display_Push(display, cmd);
+}
+
+int Reader_Display_Sleep(READER_DISPLAY *display)
+{
+    READER_DISPLAY_CMD *cmd = Reader_Display_Slot(display, READER_DISPLAY_SLEEP);
+
+    return cmd ? Reader_Display_Push(display, cmd) : -1;
+}
+
+/******************************************************************************
+function:	Queue a panel init
+parameter:
+    mode : Passed to Ops.Wake; a drawing command that finds the panel
+           asleep wakes it in the mode last given here
+******************************************************************************/
+int Reader_Display_Wake(READER_DISPLAY *display, int mode)
+{
+    READER_DISPLAY_CMD *cmd = Reader_Display_Slot(display, READER_DISPLAY_WAKE);
+
+    if (!cmd)
+        return -1;
+    cmd->Mode = mode;
+    return Reader_Display_Push(display, cmd);
+}
+
+int Reader_Display_Clear(READER_DISPLAY *display)
+{
+    READER_DISPLAY_CMD *cmd = Reader_Display_Slot(display, READER_DISPLAY_CLEAR);
+
+    return cmd ? Reader_Display_Push(display, cmd) : -1;
+}
+
+/******************************************************************************
+function:	Whether commands are queued or running
+******************************************************************************/
+int Reader_Display_Busy(READER_DISPLAY *display)
+{
+    return display->Started && display->Head != __atomic_load_n(&display->Tail, __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+function:	Wait until every queued command is done
+******************************************************************************/
+void Reader_Display_Wait(READER_DISPLAY *display)
+{
+    while (Reader_Display_Busy(display))
+        Reader_Display_WaitDone(display);
+}
+
+/******************************************************************************
+function:	eventfd turning readable when commands are done, -1 without a thread
+info:
+    Its count is the commands done since last read. The caller reads
+    it to poll again; Reader_Display_Busy() tells whether more are left.
+******************************************************************************/
+int Reader_Display_Fd(READER_DISPLAY *display)
+{
+    return display->Done;
+}
+
+void Reader_Display_GetStats(READER_DISPLAY *display, READER_DISPLAY_STATS *stats)
+{
+    if (!display->Started) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    pthread_mutex_lock(&display->Lock);
+    *stats = display->Stats;
+    pthread_mutex_unlock(&display->Lock);
+}
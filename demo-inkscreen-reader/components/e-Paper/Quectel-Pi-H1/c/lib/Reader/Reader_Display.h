@@ -0,0 +1,108 @@
+/*****************************************************************************
+* | File      	:   Reader_Display.h
+* | Function    :   Panel commands run by a display thread of their own
+* | Info        :
+*   The display thread is the only one that talks to the panel. The UI
+*   thread queues commands (full refresh, partial window, sleep, wake,
+*   clear) and goes back to its keys; the thread runs them in order,
+*   each to the end of its refresh, through the panel operations it was
+*   given.
+*
+*   The queue is a ring of READER_DISPLAY_QUEUE commands with one
+*   producer and one consumer: each side moves its own index and reads
+*   the other's, no lock is taken. A frame is copied into the command's
+*   slot when it is queued, so the caller may draw the next one at once.
+*   An eventfd wakes the thread, another one turns readable whenever a
+*   command is done.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __READER_DISPLAY_H
+#define __READER_DISPLAY_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define READER_DISPLAY_QUEUE    8   // Commands queued at most, a power of two
+
+#define READER_DISPLAY_FULL     0   // Whole frame, full refresh
+#define READER_DISPLAY_WINDOW   1   // Window of a frame, partial refresh
+#define READER_DISPLAY_SLEEP    2
+#define READER_DISPLAY_WAKE     3   // Init in a panel defined mode
+#define READER_DISPLAY_CLEAR    4
+#define READER_DISPLAY_COMMANDS 5
+
+/**
+ * What the display thread does with the panel, each returns once the
+ * panel is idle again
+**/
+typedef struct {
+    void (*Full)(void *Arg, const uint8_t *Frame);
+    void (*Window)(void *Arg, const uint8_t *Frame, uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend);
+    void (*Sleep)(void *Arg);
+    void (*Wake)(void *Arg, int Mode);
+    void (*Clear)(void *Arg);
+} READER_DISPLAY_OPS;
+
+typedef struct {
+    uint8_t Type;           // READER_DISPLAY_FULL ...
+    int Mode;               // Of a WAKE
+    uint16_t Xstart;        // Of a WINDOW, end not included
+    uint16_t Ystart;
+    uint16_t Xend;
+    uint16_t Yend;
+    uint8_t *Frame;         // The slot's own copy, FULL and WINDOW
+    uint64_t Queued;        // CLOCK_MONOTONIC ns
+} READER_DISPLAY_CMD;
+
+/**
+ * Times of one kind of command, in ns
+**/
+typedef struct {
+    uint32_t Count;
+    uint64_t WaitSum;       // Queued to started
+    uint64_t WaitMax;
+    uint64_t RunSum;        // Started to panel idle
+    uint64_t RunMax;
+} READER_DISPLAY_TIMES;
+
+typedef struct {
+    READER_DISPLAY_TIMES Command[READER_DISPLAY_COMMANDS];
+    uint32_t Woken;         // Drawing commands that found the panel asleep
+} READER_DISPLAY_STATS;
+
+typedef struct {
+    READER_DISPLAY_CMD Queue[READER_DISPLAY_QUEUE];
+    uint32_t Head;          // Next to queue, moved by the UI thread only
+    uint32_t Tail;          // Next to run, moved by the display thread once it is done
+    int Work;               // eventfd, commands queued
+    int Done;               // eventfd, commands done
+    int Stop;
+    int Started;            // 0 until Reader_Display_Init() succeeds
+    uint32_t WidthByte;     // Frame geometry
+    uint32_t Height;
+    READER_DISPLAY_OPS Ops;
+    void *Arg;
+    int Asleep;             // Display thread side panel state
+    int WakeMode;           // and the mode it was last woken in
+    pthread_t Thread;
+    pthread_mutex_t Lock;   // Stats only
+    READER_DISPLAY_STATS Stats;
+} READER_DISPLAY;
+
+int Reader_Display_Init(READER_DISPLAY *display, uint32_t width_byte, uint32_t height,
+                        const READER_DISPLAY_OPS *ops, void *arg);
+void Reader_Display_Free(READER_DISPLAY *display);
+int Reader_Display_Full(READER_DISPLAY *display, const uint8_t *frame);
+int Reader_Display_Window(READER_DISPLAY *display, const uint8_t *frame,
+                          uint16_t x_start, uint16_t y_start, uint16_t x_end, uint16_t y_end);
+int Reader_Display_Sleep(READER_DISPLAY *display);
+int Reader_Display_Wake(READER_DISPLAY *display, int mode);
+int Reader_Display_Clear(READER_DISPLAY *display);
+int Reader_Display_Busy(READER_DISPLAY *display);
+void Reader_Display_Wait(READER_DISPLAY *display);
+int Reader_Display_Fd(READER_DISPLAY *display);
+void Reader_Display_GetStats(READER_DISPLAY *display, READER_DISPLAY_STATS *stats);
+
+#endif
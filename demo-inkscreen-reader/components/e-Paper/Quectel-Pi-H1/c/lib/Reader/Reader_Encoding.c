@@ -0,0 +1,547 @@
+/*****************************************************************************
+* | File      	:   Reader_Encoding.c
+* | Function    :   Encoding detection of TXT books
+* | Info        :
+*   The vector validators follow the lookup algorithm of Keiser and Lemire,
+*   "Validating UTF-8 In Less Than One Instruction Per Byte": three 16-entry
+*   table lookups on the nibbles of each byte and the byte before it catch
+*   every bad two-byte pattern, and two saturating subtractions check that
+*   3- and 4-byte sequences have enough continuation bytes.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Encoding.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define READER_UTF8_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define READER_UTF8_NEON 1
+#endif
+
+// Bytes validated between checks for an error, so bad input stops early
+#define READER_UTF8_CHECK_EVERY  1024
+
+/**
+ * Error classes of the lookup tables, a byte pair is bad when all three
+ * lookups share a bit
+**/
+#define UTF8_TOO_SHORT      (1 << 0)    // Lead byte not followed by a continuation
+#define UTF8_TOO_LONG       (1 << 1)    // Continuation after ASCII
+#define UTF8_OVERLONG_3     (1 << 2)
+#define UTF8_TOO_LARGE      (1 << 3)
+#define UTF8_SURROGATE      (1 << 4)
+#define UTF8_OVERLONG_2     (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4     (1 << 6)
+#define UTF8_TWO_CONTS      (1 << 7)    // Two continuations, fine only inside a 3/4-byte sequence
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+// High nibble of the previous byte
+static const uint8_t Utf8_Prev_High[16] = {
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+};
+
+// Low nibble of the previous byte
+static const uint8_t Utf8_Prev_Low[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+};
+
+// High nibble of the current byte
+static const uint8_t Utf8_Cur_High[16] = {
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+};
+
+// A vector may not end in a lead byte that needs more bytes than it has left
+static const uint8_t Utf8_Max_Tail[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+/**
+ * Validate size bytes of UTF-8, returns 1 when valid
+**/
+typedef int (*READER_UTF8_SCAN)(const uint8_t *p, size_t size);
+
+static int Reader_UTF8_Scalar(const uint8_t *p, size_t size)
+{
+    size_t i = 0;
+
+    while (i < size) {
+        uint64_t w;
+        if (i + 8 <= size) {
+            memcpy(&w, p + i, 8);
+            if (!(w & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        uint8_t c = p[i];
+        size_t n, k;
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        if (c >= 0xC2 && c <= 0xDF)
+            n = 2;
+        else if (c >= 0xE0 && c <= 0xEF)
+            n = 3;
+        else if (c >= 0xF0 && c <= 0xF4)
+            n = 4;
+        else
+            return 0;
+        if (i + n > size)
+            return 0;
+
+        // Second byte ranges that rule out overlongs, surrogates and code points above U+10FFFF
+        uint8_t c1 = p[i + 1];
+        if ((c == 0xE0 && c1 < 0xA0) || (c == 0xED && c1 > 0x9F) ||
+            (c == 0xF0 && c1 < 0x90) || (c == 0xF4 && c1 > 0x8F))
+            return 0;
+        for (k = 1; k < n; k++) {
+            if ((p[i + k] & 0xC0) != 0x80)
+                return 0;
+        }
+        i += n;
+    }
+    return 1;
+}
+
+#ifdef READER_UTF8_X86
+__attribute__((target("ssse3")))
+static int Reader_UTF8_SSSE3(const uint8_t *p, size_t size)
+{
+    const __m128i prev_high = _mm_loadu_si128((const __m128i *)Utf8_Prev_High);
+    const __m128i prev_low = _mm_loadu_si128((const __m128i *)Utf8_Prev_Low);
+    const __m128i cur_high = _mm_loadu_si128((const __m128i *)Utf8_Cur_High);
+    const __m128i max_tail = _mm_loadu_si128((const __m128i *)(Utf8_Max_Tail + 16));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i third = _mm_set1_epi8((char)(0xE0 - 0x80));
+    const __m128i fourth = _mm_set1_epi8((char)(0xF0 - 0x80));
+    const __m128i high_bit = _mm_set1_epi8((char)0x80);
+    __m128i prev = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    size_t pos;
+
+    for (pos = 0; pos < size; pos += 16) {
+        __m128i in;
+        if (pos + 16 <= size) {
+            in = _mm_loadu_si128((const __m128i *)(p + pos));
+        } else {
+            // Pad the tail with ASCII, an unfinished sequence then shows as too short
+            uint8_t tail[16] = {0};
+            memcpy(tail, p + pos, size - pos);
+            in = _mm_loadu_si128((const __m128i *)tail);
+        }
+
+        if (_mm_movemask_epi8(in) == 0) {
+            error = _mm_or_si128(error, incomplete);
+            incomplete = _mm_setzero_si128();
+        } else {
+            __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+            __m128i special = _mm_and_si128(
+                _mm_and_si128(_mm_shuffle_epi8(prev_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                              _mm_shuffle_epi8(prev_low, _mm_and_si128(prev1, nibble))),
+                _mm_shuffle_epi8(cur_high, _mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+            __m128i must23 = _mm_or_si128(_mm_subs_epu8(_mm_alignr_epi8(in, prev, 14), third),
+                                          _mm_subs_epu8(_mm_alignr_epi8(in, prev, 13), fourth));
+            error = _mm_or_si128(error, _mm_xor_si128(_mm_and_si128(must23, high_bit), special));
+            incomplete = _mm_subs_epu8(in, max_tail);
+        }
+        prev = in;
+
+        if ((pos & (READER_UTF8_CHECK_EVERY - 1)) == 0 &&
+            _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF)
+            return 0;
+    }
+    error = _mm_or_si128(error, incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+__attribute__((target("avx2")))
+static int Reader_UTF8_AVX2(const uint8_t *p, size_t size)
+{
+    const __m256i prev_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Utf8_Prev_High));
+    const __m256i prev_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Utf8_Prev_Low));
+    const __m256i cur_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)Utf8_Cur_High));
+    const __m256i max_tail = _mm256_loadu_si256((const __m256i *)Utf8_Max_Tail);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i third = _mm256_set1_epi8((char)(0xE0 - 0x80));
+    const __m256i fourth = _mm256_set1_epi8((char)(0xF0 - 0x80));
+    const __m256i high_bit = _mm256_set1_epi8((char)0x80);
+    __m256i prev = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    size_t pos;
+
+    for (pos = 0; pos < size; pos += 32) {
+        __m256i in;
+        if (pos + 32 <= size) {
+            in = _mm256_loadu_si256((const __m256i *)(p + pos));
+        } else {
+            uint8_t tail[32] = {0};
+            memcpy(tail, p + pos, size - pos);
+            in = _mm256_loadu_si256((const __m256i *)tail);
+        }
+
+        if (_mm256_movemask_epi8(in) == 0) {
+            error = _mm256_or_si256(error, incomplete);
+            incomplete = _mm256_setzero_si256();
+        } else {
+            // alignr works per 128-bit lane, so pair each lane with the one before it
+            __m256i shifted = _mm256_permute2x128_si256(prev, in, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(in, shifted, 15);
+            __m256i special = _mm256_and_si256(
+                _mm256_and_si256(_mm256_shuffle_epi8(prev_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                                 _mm256_shuffle_epi8(prev_low, _mm256_and_si256(prev1, nibble))),
+                _mm256_shuffle_epi8(cur_high, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble)));
+            __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(_mm256_alignr_epi8(in, shifted, 14), third),
+                                             _mm256_subs_epu8(_mm256_alignr_epi8(in, shifted, 13), fourth));
+            error = _mm256_or_si256(error, _mm256_xor_si256(_mm256_and_si256(must23, high_bit), special));
+            incomplete = _mm256_subs_epu8(in, max_tail);
+        }
+        prev = in;
+
+        if ((pos & (READER_UTF8_CHECK_EVERY - 1)) == 0 && !_mm256_testz_si256(error, error))
+            return 0;
+    }
+    error = _mm256_or_si256(error, incomplete);
+    return _mm256_testz_si256(error, error);
+}
+#endif
+
+#ifdef READER_UTF8_NEON
+static int Reader_UTF8_NEON(const uint8_t *p, size_t size)
+{
+    const uint8x16_t prev_high = vld1q_u8(Utf8_Prev_High);
+    const uint8x16_t prev_low = vld1q_u8(Utf8_Prev_Low);
+    const uint8x16_t cur_high = vld1q_u8(Utf8_Cur_High);
+    const uint8x16_t max_tail = vld1q_u8(Utf8_Max_Tail + 16);
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+    const uint8x16_t third = vdupq_n_u8(0xE0 - 0x80);
+    const uint8x16_t fourth = vdupq_n_u8(0xF0 - 0x80);
+    const uint8x16_t high_bit = vdupq_n_u8(0x80);
+    uint8x16_t prev = vdupq_n_u8(0);
+    uint8x16_t error = vdupq_n_u8(0);
+    uint8x16_t incomplete = vdupq_n_u8(0);
+    size_t pos;
+
+    for (pos = 0; pos < size; pos += 16) {
+        uint8x16_t in;
+        if (pos + 16 <= size) {
+            in = vld1q_u8(p + pos);
+        } else {
+            uint8_t tail[16] = {0};
+            memcpy(tail, p + pos, size - pos);
+            in = vld1q_u8(tail);
+        }
+
+        if (vmaxvq_u8(in) < 0x80) {
+            error = vorrq_u8(error, incomplete);
+            incomplete = vdupq_n_u8(0);
+        } else {
+            uint8x16_t prev1 = vextq_u8(prev, in, 15);
+            uint8x16_t special = vandq_u8(vandq_u8(vqtbl1q_u8(prev_high, vshrq_n_u8(prev1, 4)),
+                                                   vqtbl1q_u8(prev_low, vandq_u8(prev1, nibble))),
+                                          vqtbl1q_u8(cur_high, vshrq_n_u8(in, 4)));
+            uint8x16_t must23 = vorrq_u8(vqsubq_u8(vextq_u8(prev, in, 14), third),
+                                         vqsubq_u8(vextq_u8(prev, in, 13), fourth));
+            error = vorrq_u8(error, veorq_u8(vandq_u8(must23, high_bit), special));
+            incomplete = vqsubq_u8(in, max_tail);
+        }
+        prev = in;
+
+        if ((pos & (READER_UTF8_CHECK_EVERY - 1)) == 0 && vmaxvq_u8(error) != 0)
+            return 0;
+    }
+    error = vorrq_u8(error, incomplete);
+    return vmaxvq_u8(error) == 0;
+}
+#endif
+
+static READER_UTF8_SCAN Reader_UTF8_Scan = NULL;
+static const char *Reader_UTF8_Scan_Name = "scalar";
+
+/******************************************************************************
+function:	Select the UTF-8 validator
+parameter:
+    scan : READER_SCAN_*, AUTO picks the best one this CPU supports
+info:
+    Returns -1 when the validator is not available on this build or CPU.
+    The vector validators need table lookups: SSSE3 or AVX2 on x86, NEON
+    on AArch64.
+******************************************************************************/
+int Reader_Encoding_SetScan(int scan)
+{
+    if (scan == READER_SCAN_AUTO) {
+#if defined(READER_UTF8_NEON)
+        scan = READER_SCAN_NEON;
+#elif defined(READER_UTF8_X86)
+        scan = __builtin_cpu_supports("avx2") ? READER_SCAN_AVX2 :
+               __builtin_cpu_supports("ssse3") ? READER_SCAN_SSSE3 : READER_SCAN_SCALAR;
+#else
+        scan = READER_SCAN_SCALAR;
+#endif
+    }
+
+    switch (scan) {
+    case READER_SCAN_SCALAR:
+        Reader_UTF8_Scan = Reader_UTF8_Scalar;
+        Reader_UTF8_Scan_Name = "scalar";
+        return 0;
+#ifdef READER_UTF8_X86
+    case READER_SCAN_SSSE3:
+        if (!__builtin_cpu_supports("ssse3"))
+            return -1;
+        Reader_UTF8_Scan = Reader_UTF8_SSSE3;
+        Reader_UTF8_Scan_Name = "ssse3";
+        return 0;
+    case READER_SCAN_AVX2:
+        if (!__builtin_cpu_supports("avx2"))
+            return -1;
+        Reader_UTF8_Scan = Reader_UTF8_AVX2;
+        Reader_UTF8_Scan_Name = "avx2";
+        return 0;
+#endif
+#ifdef READER_UTF8_NEON
+    case READER_SCAN_NEON:
+        Reader_UTF8_Scan = Reader_UTF8_NEON;
+        Reader_UTF8_Scan_Name = "neon";
+        return 0;
+#endif
+    default:
+        return -1;
+    }
+}
+
+/******************************************************************************
+function:	Name of the UTF-8 validator in use
+******************************************************************************/
+const char *Reader_Encoding_ScanName(void)
+{
+    if (!Reader_UTF8_Scan)
+        Reader_Encoding_SetScan(READER_SCAN_AUTO);
+    return Reader_UTF8_Scan_Name;
+}
+
+/******************************************************************************
+function:	Check that data is well-formed UTF-8
+info:
+    Returns 1 when valid. Overlong forms, surrogates, code points above
+    U+10FFFF and unfinished sequences are all rejected.
+******************************************************************************/
+int Reader_UTF8_Validate(const char *data, size_t size)
+{
+    if (!Reader_UTF8_Scan)
+        Reader_Encoding_SetScan(READER_SCAN_AUTO);
+    return Reader_UTF8_Scan((const uint8_t *)data, size);
+}
+
+/**
+ * How well the text reads as each encoding
+**/
+typedef struct {
+    size_t Utf8Chars;       // Well-formed multi-byte characters
+    size_t Utf8Errors;      // Bytes that start no well-formed character
+    size_t GbPairs;         // GBK double-byte characters
+    size_t Gb2312Pairs;     // Of which inside the GB2312 set
+    size_t GbErrors;        // Bytes >= 0x80 that start no GBK character
+} READER_ENCODING_SCORE;
+
+/******************************************************************************
+function:	Length of the UTF-8 character at p, 0 when it is not well-formed
+******************************************************************************/
+static size_t Reader_UTF8_CharLen(const uint8_t *p, size_t left)
+{
+    uint8_t c = p[0];
+    size_t n, k;
+
+    if (c >= 0xC2 && c <= 0xDF)
+        n = 2;
+    else if (c >= 0xE0 && c <= 0xEF)
+        n = 3;
+    else if (c >= 0xF0 && c <= 0xF4)
+        n = 4;
+    else
+        return 0;
+    if (n > left)
+        return 0;
+    if ((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] > 0x9F) ||
+        (c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] > 0x8F))
+        return 0;
+    for (k = 1; k < n; k++) {
+        if ((p[k] & 0xC0) != 0x80)
+            return 0;
+    }
+    return n;
+}
+
+/******************************************************************************
+function:	Score text that failed UTF-8 validation
+info:
+    Both readings skip ASCII eight bytes at a time. A byte that does not fit
+    is counted and skipped alone, so one bad byte costs one error.
+******************************************************************************/
+static void Reader_Encoding_Score(const uint8_t *p, size_t size, READER_ENCODING_SCORE *score)
+{
+    size_t i;
+    uint64_t w;
+
+    memset(score, 0, sizeof(*score));
+
+    for (i = 0; i < size;) {
+        if (i + 8 <= size) {
+            memcpy(&w, p + i, 8);
+            if (!(w & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+        if (p[i] < 0x80) {
+            i++;
+            continue;
+        }
+        size_t n = Reader_UTF8_CharLen(p + i, size - i);
+        if (n) {
+            score->Utf8Chars++;
+            i += n;
+        } else {
+            score->Utf8Errors++;
+            i++;
+        }
+    }
+
+    for (i = 0; i < size;) {
+        if (i + 8 <= size) {
+            memcpy(&w, p + i, 8);
+            if (!(w & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+        uint8_t c = p[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        // GBK: lead 0x81-0xFE, trail 0x40-0xFE except 0x7F; GB2312 is lead 0xA1-0xF7, trail 0xA1-0xFE
+        if (c != 0x80 && c != 0xFF && i + 1 < size && p[i + 1] >= 0x40 && p[i + 1] != 0x7F && p[i + 1] != 0xFF) {
+            score->GbPairs++;
+            if (c >= 0xA1 && c <= 0xF7 && p[i + 1] >= 0xA1)
+                score->Gb2312Pairs++;
+            i += 2;
+        } else {
+            score->GbErrors++;
+            i++;
+        }
+    }
+}
+
+/******************************************************************************
+function:	Classify the encoding of a book
+parameter:
+    data   : Whole book content
+    size   : Size of the content
+    result : Receives the encoding and a confidence from 0 to 100
+info:
+    - A UTF-8 BOM, or content that validates as UTF-8 (a character cut
+      off at the very end is allowed), is UTF-8 with full confidence.
+    - Otherwise the text is scored both ways. UTF-8 with at most one bad
+      byte per hundred characters is taken as damaged UTF-8; anything
+      else is GB2312, or GBK when more than one double-byte character in
+      a hundred falls outside the GB2312 set.
+    Almost any high byte followed by another byte is a valid GBK pair, so
+    UTF-8 has to be ruled out first.
+******************************************************************************/
+void Reader_Encoding_Detect(const char *data, size_t size, READER_ENCODING *result)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    READER_ENCODING_SCORE score;
+    size_t checked = size;
+    size_t k;
+
+    result->Encoding = READER_ENCODING_UTF8;
+    result->Confidence = 100;
+    if (!data || size == 0)
+        return;
+    if (size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
+        return;
+
+    // A book cut in the middle of a character is still UTF-8
+    for (k = 1; k <= 3 && k <= size; k++) {
+        uint8_t c = p[size - k];
+        if (c < 0x80)
+            break;
+        if (c >= 0xC0) {
+            size_t need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+            if (need > k)
+                checked = size - k;
+            break;
+        }
+    }
+    if (Reader_UTF8_Validate(data, checked))
+        return;
+
+    Reader_Encoding_Score(p, size, &score);
+
+    if (score.Utf8Errors * 100 <= score.Utf8Chars) {
+        result->Encoding = READER_ENCODING_UTF8;
+        result->Confidence = (uint32_t)(score.Utf8Chars * 100 / (score.Utf8Chars + score.Utf8Errors));
+        return;
+    }
+
+    result->Encoding = (score.GbPairs - score.Gb2312Pairs) * 100 > score.GbPairs ?
+                       READER_ENCODING_GBK : READER_ENCODING_GB2312;
+    result->Confidence = (score.GbPairs + score.GbErrors) ?
+                         (uint32_t)(score.GbPairs * 100 / (score.GbPairs + score.GbErrors)) : 0;
+}
+
+/******************************************************************************
+function:	Printable name of an encoding
+******************************************************************************/
+const char *Reader_Encoding_Name(uint32_t encoding)
+{
+    switch (encoding) {
+    case READER_ENCODING_UTF8:
+        return "UTF-8";
+    case READER_ENCODING_GB2312:
+        return "GB2312";
+    case READER_ENCODING_GBK:
+        return "GBK";
+    default:
+        return "unknown";
+    }
+}
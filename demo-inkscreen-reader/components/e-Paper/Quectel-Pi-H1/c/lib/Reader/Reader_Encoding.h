@@ -0,0 +1,45 @@
+/*****************************************************************************
+* | File      	:   Reader_Encoding.h
+* | Function    :   Encoding detection of TXT books
+* | Info        :
+*   The whole book is checked, not just its first bytes. It is first run
+*   through a vectorized UTF-8 validator; text that is not valid UTF-8 is
+*   scored as UTF-8 and as GB2312/GBK double-byte text and the better fit
+*   wins, with a confidence telling how clean that fit is.
+*
+*   The result is kept in the book's page index, so a book is only
+*   classified the first time it is opened.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __READER_ENCODING_H
+#define __READER_ENCODING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Reader_Text.h"
+
+/**
+ * Book encodings
+**/
+#define READER_ENCODING_UTF8    0   // Also pure ASCII
+#define READER_ENCODING_GB2312  1
+#define READER_ENCODING_GBK     2   // Double-byte text outside the GB2312 set
+
+/**
+ * Encoding of a book
+**/
+typedef struct {
+    uint32_t Encoding;      // READER_ENCODING_*
+    uint32_t Confidence;    // 0 to 100
+} READER_ENCODING;
+
+int Reader_UTF8_Validate(const char *data, size_t size);
+void Reader_Encoding_Detect(const char *data, size_t size, READER_ENCODING *result);
+const char *Reader_Encoding_Name(uint32_t encoding);
+int Reader_Encoding_SetScan(int scan);
+const char *Reader_Encoding_ScanName(void);
+
+#endif
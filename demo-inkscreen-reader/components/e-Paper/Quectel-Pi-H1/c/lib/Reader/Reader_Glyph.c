@@ -0,0 +1,275 @@
+/*****************************************************************************
+* | File      	:   Reader_Glyph.c
+* | Function    :   Glyph stream of a TXT book
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Glyph.h"
+#include "Reader_Encoding.h"
+#include "Reader_Index.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <iconv.h>
+
+#define GLYPH_UNRESOLVED    0   // Cache entry not looked up yet, real IDs of multi-byte characters are >= GLYPH_CN
+
+/******************************************************************************
+function:	Find a double-byte GB character in a CN font
+info:
+    Returns GLYPH_CN + its table index, or GLYPH_MISSING.
+******************************************************************************/
+static uint16_t Reader_Glyph_Search(cFONT *font, unsigned char hi, unsigned char lo)
+{
+    int Num = Font_CN_Find(font, hi, lo);
+
+    return (Num >= 0 && Num < GLYPH_MISSING - GLYPH_CN) ? (uint16_t)(GLYPH_CN + Num) : GLYPH_MISSING;
+}
+
+/******************************************************************************
+function:	Decode a multi-byte UTF-8 character
+info:
+    Returns the code point, or 0 when the bytes are not one well formed
+    character of the Basic Multilingual Plane; GB2312 has nothing beyond it.
+******************************************************************************/
+static uint32_t Reader_Glyph_DecodeUTF8(const unsigned char *p, int bytes)
+{
+    uint32_t cp;
+    int i;
+
+    if (bytes == 2 && (p[0] & 0xE0) == 0xC0)
+        cp = p[0] & 0x1F;
+    else if (bytes == 3 && (p[0] & 0xF0) == 0xE0)
+        cp = p[0] & 0x0F;
+    else
+        return 0;
+    for (i = 1; i < bytes; i++) {
+        if ((p[i] & 0xC0) != 0x80)
+            return 0;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    return cp >= 0x80 ? cp : 0;
+}
+
+/******************************************************************************
+function:	Find a UTF-8 character in a CN font
+info:
+    CN fonts are indexed by GB2312 code, the character is converted to GBK
+    (a superset with the same codes) to look it up.
+******************************************************************************/
+static uint16_t Reader_Glyph_SearchUTF8(cFONT *font, iconv_t cd, const unsigned char *p, int bytes)
+{
+    char gb[4];
+    char *in = (char *)p, *out = gb;
+    size_t in_left = bytes, out_left = sizeof(gb);
+
+    if (cd == (iconv_t)-1)
+        return GLYPH_MISSING;
+    iconv(cd, NULL, NULL, NULL, NULL);
+    if (iconv(cd, &in, &in_left, &out, &out_left) == (size_t)-1 || out - gb != 2)
+        return GLYPH_MISSING;
+    return Reader_Glyph_Search(font, (unsigned char)gb[0], (unsigned char)gb[1]);
+}
+
+/******************************************************************************
+function:	Byte length of the character at i, as the book's encoding reads it
+******************************************************************************/
+static int Reader_Glyph_Split(const unsigned char *p, size_t i, size_t size, int is_gb)
+{
+    unsigned char c = p[i];
+    int bytes;
+
+    if (is_gb)
+        bytes = (c >= 0x80 && i + 1 < size && p[i + 1] >= 0x40) ? 2 : 1;
+    else
+        bytes = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+    if (i + bytes > size)
+        bytes = (int)(size - i);
+    return bytes;
+}
+
+/******************************************************************************
+function:	Transcode processed text into a glyph stream
+parameter:
+    text     : Processed text
+    size     : Size of the text
+    encoding : READER_ENCODING_* of the text
+    font     : CN font that multi-byte characters are looked up in
+    glyphs   : Filled in on success, release with Reader_Glyph_Free()
+info:
+    Characters are split exactly as the book's encoding reads them: a
+    UTF-8 lead byte gives the length, a GB byte >= 0x80 followed by a
+    byte >= 0x40 is one double-byte character, anything else one byte.
+
+    A single byte becomes its own value as glyph ID. A multi-byte
+    character becomes GLYPH_CN + its index in the font, looked up once
+    per distinct character, or GLYPH_MISSING when the font lacks it.
+
+    The characters are counted first and the stream allocated to fit, so
+    next to the text only the stream itself is held: 2 bytes of IDs per
+    character, two thirds of the text size for CJK UTF-8 and twice it
+    for ASCII.
+******************************************************************************/
+int Reader_Glyph_Transcode(const char *text, size_t size, uint32_t encoding, cFONT *font,
+                           READER_GLYPHS *glyphs)
+{
+    const unsigned char *p = (const unsigned char *)text;
+    int is_gb = encoding != READER_ENCODING_UTF8;
+    iconv_t cd = (iconv_t)-1;
+    uint16_t *cache, *ids;
+    uint8_t *lengths;
+    uint32_t *marks;
+    uint32_t count = 0;
+    size_t i = 0;
+
+    memset(glyphs, 0, sizeof(*glyphs));
+    if (size > UINT32_MAX)
+        return -1;
+
+    // Only splitting characters, no font lookups: cheap next to the pass below
+    for (i = 0; i < size; count++)
+        i += Reader_Glyph_Split(p, i, size, is_gb);
+
+    // Lengths are padded to whole 64-character blocks for Reader_Glyph_Offset()
+    ids = malloc(sizeof(uint16_t) * ((size_t)count + 1));
+    lengths = calloc(((count >> READER_GLYPH_MARK_SHIFT) + 1) * 16, 1);
+    marks = malloc(sizeof(uint32_t) * ((count >> READER_GLYPH_MARK_SHIFT) + 1));
+    cache = calloc(65536, sizeof(uint16_t));
+    if (!ids || !lengths || !marks || !cache) {
+        free(ids);
+        free(lengths);
+        free(marks);
+        free(cache);
+        return -1;
+    }
+    if (!is_gb)
+        cd = iconv_open("GBK", "UTF-8");
+
+    count = 0;
+    i = 0;
+    while (i < size) {
+        unsigned char c = p[i];
+        int bytes = Reader_Glyph_Split(p, i, size, is_gb);
+        uint16_t id;
+
+        if (bytes == 1) {
+            id = c;
+        } else if (is_gb) {
+            uint16_t code = (uint16_t)((c << 8) | p[i + 1]);
+            if (cache[code] == GLYPH_UNRESOLVED)
+                cache[code] = Reader_Glyph_Search(font, c, p[i + 1]);
+            id = cache[code];
+        } else {
+            uint32_t cp = Reader_Glyph_DecodeUTF8(p + i, bytes);
+            if (cp == 0) {
+                id = GLYPH_MISSING;
+            } else {
+                if (cache[cp] == GLYPH_UNRESOLVED)
+                    cache[cp] = Reader_Glyph_SearchUTF8(font, cd, p + i, bytes);
+                id = cache[cp];
+            }
+        }
+
+        if ((count & ((1 << READER_GLYPH_MARK_SHIFT) - 1)) == 0)
+            marks[count >> READER_GLYPH_MARK_SHIFT] = (uint32_t)i;
+        ids[count] = id;
+        lengths[count >> 2] |= (uint8_t)((bytes - 1) << ((count & 3) * 2));
+        count++;
+        i += bytes;
+    }
+    // The end of the text is a mark too when it falls on a block boundary
+    if ((count & ((1 << READER_GLYPH_MARK_SHIFT) - 1)) == 0)
+        marks[count >> READER_GLYPH_MARK_SHIFT] = (uint32_t)size;
+
+    if (cd != (iconv_t)-1)
+        iconv_close(cd);
+    free(cache);
+
+    glyphs->Ids = ids;
+    glyphs->Lengths = lengths;
+    glyphs->Marks = marks;
+    glyphs->Count = count;
+    glyphs->Size = (uint32_t)size;
+    return 0;
+}
+
+/******************************************************************************
+function:	Byte offset of a glyph
+parameter:
+    glyphs : Glyph stream
+    index  : Glyph index, Count gives the end of the text
+info:
+    Starts from the nearest mark and adds up at most 63 packed lengths,
+    a byte (four lengths) at a time.
+******************************************************************************/
+uint32_t Reader_Glyph_Offset(const READER_GLYPHS *glyphs, uint32_t index)
+{
+    const uint8_t *p = glyphs->Lengths + ((index >> READER_GLYPH_MARK_SHIFT) << 4);
+    uint32_t rest = index & ((1 << READER_GLYPH_MARK_SHIFT) - 1);
+    uint32_t offset = glyphs->Marks[index >> READER_GLYPH_MARK_SHIFT] + rest;
+    uint32_t n;
+
+    // Each 2-bit field holds length - 1: its low bit counts once, its high bit twice
+    for (n = 0; n < (rest >> 2); n++)
+        offset += __builtin_popcount(p[n] & 0x55) + 2 * __builtin_popcount(p[n] & 0xAA);
+    if (rest & 3) {
+        uint8_t b = p[n] & (uint8_t)((1 << ((rest & 3) * 2)) - 1);
+        offset += __builtin_popcount(b & 0x55) + 2 * __builtin_popcount(b & 0xAA);
+    }
+    return offset;
+}
+
+/******************************************************************************
+function:	Glyph at a byte offset
+parameter:
+    glyphs : Glyph stream
+    offset : Byte offset into the text
+info:
+    Returns the first glyph that starts at or after offset, Count when
+    offset is at or past the end.
+******************************************************************************/
+uint32_t Reader_Glyph_Find(const READER_GLYPHS *glyphs, uint32_t offset)
+{
+    uint32_t left = 0, right = glyphs->Count >> READER_GLYPH_MARK_SHIFT;
+    uint32_t index, pos;
+
+    if (offset >= glyphs->Size)
+        return glyphs->Count;
+
+    // Last mark at or before offset
+    while (left < right) {
+        uint32_t mid = left + (right - left + 1) / 2;
+        if (glyphs->Marks[mid] <= offset)
+            left = mid;
+        else
+            right = mid - 1;
+    }
+
+    index = left << READER_GLYPH_MARK_SHIFT;
+    pos = glyphs->Marks[left];
+    while (index < glyphs->Count && pos < offset)
+        pos += Reader_Glyph_Length(glyphs, index++);
+    return index;
+}
+
+/******************************************************************************
+function:	Hash of everything layout reads from a glyph stream
+******************************************************************************/
+uint64_t Reader_Glyph_Hash(const READER_GLYPHS *glyphs)
+{
+    uint64_t h = Reader_Hash(glyphs->Lengths, (glyphs->Count + 3) / 4, 0);
+    return Reader_Hash(glyphs->Ids, sizeof(uint16_t) * glyphs->Count, h);
+}
+
+/******************************************************************************
+function:	Release a glyph stream
+******************************************************************************/
+void Reader_Glyph_Free(READER_GLYPHS *glyphs)
+{
+    free(glyphs->Ids);
+    free(glyphs->Lengths);
+    free(glyphs->Marks);
+    memset(glyphs, 0, sizeof(*glyphs));
+}
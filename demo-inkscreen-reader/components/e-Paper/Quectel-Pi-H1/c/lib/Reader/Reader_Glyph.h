@@ -0,0 +1,54 @@
+/*****************************************************************************
+* | File      	:   Reader_Glyph.h
+* | Function    :   Glyph stream of a TXT book
+* | Info        :
+*   The processed text is transcoded once, when the book is loaded, into
+*   one 16-bit glyph ID per character (see GLYPH_CN in fonts.h). Layout
+*   and drawing then walk glyph IDs and never decode bytes or search the
+*   font again, whatever the book's encoding.
+*
+*   Byte offsets are still what the page index and the reading history
+*   store. The byte length of each character is kept in 2 bits and the
+*   byte offset of every 64th character is kept in full, so offsets and
+*   glyph indices convert both ways without the text itself.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __READER_GLYPH_H
+#define __READER_GLYPH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../Fonts/fonts.h"
+
+#define READER_GLYPH_MARK_SHIFT 6   // A byte offset is kept for every 64th glyph
+
+/**
+ * Glyph stream
+**/
+typedef struct {
+    uint16_t *Ids;          // One glyph ID per character
+    uint8_t  *Lengths;      // Byte length - 1 of each character, 2 bits each
+    uint32_t *Marks;        // Byte offset of every 64th character
+    uint32_t Count;         // Number of characters
+    uint32_t Size;          // Bytes of text transcoded
+} READER_GLYPHS;
+
+/**
+ * Byte length of glyph index
+**/
+static inline int Reader_Glyph_Length(const READER_GLYPHS *glyphs, uint32_t index)
+{
+    return ((glyphs->Lengths[index >> 2] >> ((index & 3) * 2)) & 3) + 1;
+}
+
+int Reader_Glyph_Transcode(const char *text, size_t size, uint32_t encoding, cFONT *font,
+                           READER_GLYPHS *glyphs);
+uint32_t Reader_Glyph_Offset(const READER_GLYPHS *glyphs, uint32_t index);
+uint32_t Reader_Glyph_Find(const READER_GLYPHS *glyphs, uint32_t offset);
+uint64_t Reader_Glyph_Hash(const READER_GLYPHS *glyphs);
+void Reader_Glyph_Free(READER_GLYPHS *glyphs);
+
+#endif
@@ -0,0 +1,275 @@
+/*****************************************************************************
+* | File      	:   Reader_Index.c
+* | Function    :   Persistent page index for the TXT reader
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Index.h"
+#include "Debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/******************************************************************************
+function:	64-bit content hash, eight bytes per step
+parameter:
+    data : Bytes to hash
+    len  : Number of bytes
+    seed : Initial value, lets several buffers be chained
+******************************************************************************/
+uint64_t Reader_Hash(const void *data, size_t len, uint64_t seed)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h = seed ^ ((uint64_t)len * 0x9E3779B97F4A7C15ULL);
+    uint64_t w;
+
+    while (len >= 8) {
+        memcpy(&w, p, 8);
+        h ^= w * 0x87C37B91114253D5ULL;
+        h = (h << 31) | (h >> 33);
+        h *= 0x9E3779B97F4A7C15ULL;
+        p += 8;
+        len -= 8;
+    }
+    if (len) {
+        w = 0;
+        memcpy(&w, p, len);
+        h ^= w * 0x87C37B91114253D5ULL;
+        h = (h << 31) | (h >> 33);
+        h *= 0x9E3779B97F4A7C15ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/******************************************************************************
+function:	Build the sidecar path ".<name>.idx" next to the book
+******************************************************************************/
+static int Reader_Index_Path(const char *book_path, char *out, size_t out_size)
+{
+    const char *name = strrchr(book_path, '/');
+    int n;
+
+    if (name) {
+        name++;
+        n = snprintf(out, out_size, "%.*s.%s.idx", (int)(name - book_path), book_path, name);
+    } else {
+        n = snprintf(out, out_size, ".%s.idx", book_path);
+    }
+    return (n > 0 && (size_t)n < out_size) ? 0 : -1;
+}
+
+/******************************************************************************
+function:	Describe a book and the layout it is paginated with
+parameter:
+    book_path    : Path of the book, used for size and mtime
+    content_hash : Hash of what the layout reads, see Reader_Glyph_Hash()
+    layout       : Layout parameters that affect page breaks
+    layout_size  : Size of the layout parameters
+    key          : Filled in on success
+******************************************************************************/
+int Reader_Index_MakeKey(const char *book_path, uint64_t content_hash,
+                         const void *layout, size_t layout_size, READER_INDEX_KEY *key)
+{
+    struct stat st;
+
+    if (stat(book_path, &st) != 0)
+        return -1;
+
+    memset(key, 0, sizeof(*key));
+    key->FileSize = (uint64_t)st.st_size;
+    key->FileMtime = (int64_t)st.st_mtim.tv_sec;
+    key->FileMtimeNsec = (int64_t)st.st_mtim.tv_nsec;
+    key->ContentHash = content_hash;
+    key->LayoutHash = Reader_Hash(layout, layout_size, READER_INDEX_VERSION);
+    return 0;
+}
+
+/******************************************************************************
+function:	Map the sidecar index of a book
+parameter:
+    book_path : Path of the book
+    key       : Expected key, any mismatch makes the sidecar stale
+    index     : Filled in on success, points into the mapping
+info:
+    Returns -1 when there is no usable sidecar; the caller paginates and
+    calls Reader_Index_Save() to replace it.
+******************************************************************************/
+int Reader_Index_Load(const char *book_path, const READER_INDEX_KEY *key, READER_INDEX *index)
+{
+    char path[4096];
+    struct stat st;
+    const READER_INDEX_HEADER *hdr;
+    const uint32_t *pages;
+    uint32_t i;
+    void *map;
+    int fd;
+
+    memset(index, 0, sizeof(*index));
+    if (Reader_Index_Path(book_path, path, sizeof(path)) != 0)
+        return -1;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(READER_INDEX_HEADER)) {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    hdr = (const READER_INDEX_HEADER *)map;
+    if (hdr->Magic != READER_INDEX_MAGIC || hdr->Version != READER_INDEX_VERSION ||
+        memcmp(&hdr->Key, key, sizeof(*key)) != 0 || hdr->PageCount == 0 ||
+        (size_t)st.st_size != sizeof(*hdr) + (size_t)hdr->LineCount * sizeof(READER_LINE) +
+                              (size_t)hdr->PageCount * sizeof(uint32_t)) {
+        Debug("Stale page index %s\r\n", path);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    // Page starts must be increasing line indices, the renderer trusts them
+    pages = (const uint32_t *)((const READER_LINE *)(hdr + 1) + hdr->LineCount);
+    for (i = 0; i < hdr->PageCount; i++) {
+        if (pages[i] >= hdr->LineCount || (i > 0 && pages[i] <= pages[i - 1])) {
+            Debug("Corrupt page index %s\r\n", path);
+            munmap(map, st.st_size);
+            return -1;
+        }
+    }
+
+    index->Lines = (const READER_LINE *)(hdr + 1);
+    index->LineCount = hdr->LineCount;
+    index->Pages = pages;
+    index->Count = hdr->PageCount;
+    index->Map = map;
+    index->MapSize = st.st_size;
+    return 0;
+}
+
+/******************************************************************************
+function:	Read the encoding remembered in the sidecar index of a book
+parameter:
+    book_path : Path of the book
+    encoding  : Filled in on success
+info:
+    Only the header is read, and only the book size and mtime have to
+    match: the encoding does not depend on fonts or layout, so it stays
+    usable when the page tables are stale.
+******************************************************************************/
+int Reader_Index_LoadEncoding(const char *book_path, READER_ENCODING *encoding)
+{
+    char path[4096];
+    struct stat st;
+    READER_INDEX_HEADER hdr;
+    int fd, ok;
+
+    if (Reader_Index_Path(book_path, path, sizeof(path)) != 0 || stat(book_path, &st) != 0)
+        return -1;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    ok = pread(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr);
+    close(fd);
+
+    if (!ok || hdr.Magic != READER_INDEX_MAGIC || hdr.Version != READER_INDEX_VERSION ||
+        hdr.Key.FileSize != (uint64_t)st.st_size ||
+        hdr.Key.FileMtime != (int64_t)st.st_mtim.tv_sec ||
+        hdr.Key.FileMtimeNsec != (int64_t)st.st_mtim.tv_nsec ||
+        hdr.Encoding.Encoding > READER_ENCODING_GBK || hdr.Encoding.Confidence > 100)
+        return -1;
+
+    *encoding = hdr.Encoding;
+    return 0;
+}
+
+/******************************************************************************
+function:	Write the sidecar index of a book
+info:
+    Written to a temporary file and renamed, so a reader never maps a
+    half-written index.
+******************************************************************************/
+int Reader_Index_Save(const char *book_path, const READER_INDEX_KEY *key,
+                      const READER_ENCODING *encoding,
+                      const READER_LINE *lines, uint32_t line_count,
+                      const uint32_t *pages, uint32_t page_count)
+{
+    char path[4096], tmp[4200];
+    READER_INDEX_HEADER hdr;
+    FILE *fp;
+    int ok;
+
+    if (Reader_Index_Path(book_path, path, sizeof(path)) != 0)
+        return -1;
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+
+    fp = fopen(tmp, "wb");
+    if (!fp) {
+        printf("Warning: Could not write page index %s\n", path);
+        return -1;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.Magic = READER_INDEX_MAGIC;
+    hdr.Version = READER_INDEX_VERSION;
+    hdr.Key = *key;
+    hdr.PageCount = page_count;
+    hdr.LineCount = line_count;
+    hdr.Encoding = *encoding;
+
+    ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+         fwrite(lines, sizeof(READER_LINE), line_count, fp) == line_count &&
+         fwrite(pages, sizeof(uint32_t), page_count, fp) == page_count;
+    ok = (fclose(fp) == 0) && ok;
+
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        printf("Warning: Could not write page index %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+function:	Take ownership of line and page tables built in memory
+******************************************************************************/
+void Reader_Index_Adopt(READER_INDEX *index, READER_LINE *lines, uint32_t line_count,
+                        uint32_t *pages, uint32_t page_count)
+{
+    memset(index, 0, sizeof(*index));
+    index->Lines = lines;
+    index->LineCount = line_count;
+    index->Pages = pages;
+    index->Count = page_count;
+    index->OwnedLines = lines;
+    index->OwnedPages = pages;
+}
+
+/******************************************************************************
+function:	Release line and page tables
+******************************************************************************/
+void Reader_Index_Free(READER_INDEX *index)
+{
+    if (index->Map)
+        munmap(index->Map, index->MapSize);
+    free(index->OwnedLines);
+    free(index->OwnedPages);
+    memset(index, 0, sizeof(*index));
+}
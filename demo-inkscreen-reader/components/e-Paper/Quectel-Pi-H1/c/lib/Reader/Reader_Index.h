@@ -0,0 +1,82 @@
+/*****************************************************************************
+* | File      	:   Reader_Index.h
+* | Function    :   Persistent page index for the TXT reader
+* | Info        :
+*   The line and page tables of a book are saved next to the book as a
+*   hidden sidecar file (".<book>.idx") and memory-mapped on the next open,
+*   so a known book does not need to be laid out again.
+*
+*   The sidecar is keyed by the book size/mtime, a hash of its content and
+*   a hash of the layout parameters (fonts, margins, panel geometry).
+*   A sidecar whose key does not match is treated as missing.
+*
+*   The header also remembers the encoding detected for the book, which
+*   stays valid as long as the book file itself is unchanged.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __READER_INDEX_H
+#define __READER_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Reader_Layout.h"
+#include "Reader_Encoding.h"
+
+#define READER_INDEX_MAGIC      0x58495045  // "EPIX"
+#define READER_INDEX_VERSION    4
+
+/**
+ * Identity of a paginated book
+**/
+typedef struct {
+    uint64_t FileSize;
+    int64_t  FileMtime;     // seconds
+    int64_t  FileMtimeNsec;
+    uint64_t ContentHash;
+    uint64_t LayoutHash;
+} READER_INDEX_KEY;
+
+/**
+ * On-disk header, followed by LineCount READER_LINE entries and
+ * PageCount uint32_t indices of the first line of each page
+**/
+typedef struct {
+    uint32_t Magic;
+    uint32_t Version;
+    READER_INDEX_KEY Key;
+    uint32_t PageCount;
+    uint32_t LineCount;
+    READER_ENCODING Encoding;
+} READER_INDEX_HEADER;
+
+/**
+ * Line and page tables, either mapped from a sidecar or built in memory
+**/
+typedef struct {
+    const READER_LINE *Lines;
+    uint32_t LineCount;
+    const uint32_t *Pages;      // First line of each page
+    uint32_t Count;
+    void *Map;                  // mmap'd sidecar, NULL if built in memory
+    size_t MapSize;
+    READER_LINE *OwnedLines;    // malloc'd tables, NULL if mapped
+    uint32_t *OwnedPages;
+} READER_INDEX;
+
+uint64_t Reader_Hash(const void *data, size_t len, uint64_t seed);
+int Reader_Index_MakeKey(const char *book_path, uint64_t content_hash,
+                         const void *layout, size_t layout_size, READER_INDEX_KEY *key);
+int Reader_Index_Load(const char *book_path, const READER_INDEX_KEY *key, READER_INDEX *index);
+int Reader_Index_LoadEncoding(const char *book_path, READER_ENCODING *encoding);
+int Reader_Index_Save(const char *book_path, const READER_INDEX_KEY *key,
+                      const READER_ENCODING *encoding,
+                      const READER_LINE *lines, uint32_t line_count,
+                      const uint32_t *pages, uint32_t page_count);
+void Reader_Index_Adopt(READER_INDEX *index, READER_LINE *lines, uint32_t line_count,
+                        uint32_t *pages, uint32_t page_count);
+void Reader_Index_Free(READER_INDEX *index);
+
+#endif
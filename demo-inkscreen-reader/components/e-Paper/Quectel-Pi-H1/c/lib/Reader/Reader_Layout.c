@@ -0,0 +1,100 @@
+/*****************************************************************************
+* | File      	:   Reader_Layout.c
+* | Function    :   Line layout shared by pagination and rendering
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Layout.h"
+
+/******************************************************************************
+function:	Lay out one line
+parameter:
+    layout : Layout parameters
+    glyphs : Glyph stream of the processed text, paragraphs end with '\n'
+    first  : First glyph of the line
+    offset : Byte offset of that glyph
+    line   : Filled in with the line
+info:
+    Returns the first glyph of the next line. A line ends when the next
+    glyph does not fit or at a paragraph marker; a line that starts
+    right after a paragraph marker is indented.
+******************************************************************************/
+uint32_t Reader_Layout_Line(const READER_LAYOUT *layout, const READER_GLYPHS *glyphs,
+                            uint32_t first, uint32_t offset, READER_LINE *line)
+{
+    const uint16_t *ids = glyphs->Ids;
+    int indent = (first > 0 && ids[first - 1] == '\n');
+    int x = layout->LeftMargin + (indent ? layout->Indent : 0);
+    int x_start = x;
+    uint32_t i = first;
+    uint32_t end = offset;
+
+    line->Start = offset;
+    line->Glyph = first;
+    line->Flags = indent ? READER_LINE_INDENT : 0;
+
+    while (i < glyphs->Count) {
+        uint16_t id = ids[i];
+        if (id == '\n') {
+            line->Flags |= READER_LINE_PARA_END;
+            break;
+        }
+
+        int width = (id >= GLYPH_CN) ? layout->CnWidth : layout->EnWidth;
+
+        // Always take one glyph so a line never comes out empty
+        if (x + width > layout->MaxX && i > first)
+            break;
+
+        if (id >= GLYPH_CN)
+            line->Flags |= READER_LINE_CN;
+        end += Reader_Glyph_Length(glyphs, i);
+        i++;
+        x += width;
+    }
+
+    line->Length = (uint16_t)(end - offset);
+    line->Glyphs = (uint16_t)(i - first);
+    line->Width = (uint16_t)(x - x_start);
+    line->Height = (uint8_t)((line->Flags & READER_LINE_CN) ? layout->CnHeight : layout->EnHeight);
+    return Reader_Line_NextGlyph(line);
+}
+
+/******************************************************************************
+function:	Lay out the lines of one page
+parameter:
+    layout    : Layout parameters
+    glyphs    : Glyph stream of the processed text
+    first     : First glyph of the page
+    lines     : Receives the lines of the page
+    max_lines : Capacity of lines
+    next      : Receives the first glyph of the next page
+info:
+    Returns the number of lines. Lines are stacked from Top while they
+    end at or above Bottom; the first line is always taken.
+******************************************************************************/
+int Reader_Layout_Page(const READER_LAYOUT *layout, const READER_GLYPHS *glyphs,
+                       uint32_t first, READER_LINE *lines, int max_lines, uint32_t *next)
+{
+    uint32_t offset = Reader_Glyph_Offset(glyphs, first);
+    int y = layout->Top;
+    int count = 0;
+
+    while (first < glyphs->Count && count < max_lines) {
+        READER_LINE line;
+        uint32_t after = Reader_Layout_Line(layout, glyphs, first, offset, &line);
+
+        if (count > 0 && y + line.Height > layout->Bottom)
+            break;
+
+        lines[count++] = line;
+        y += line.Height;
+        first = after;
+        offset = Reader_Line_End(&line);
+    }
+
+    *next = first;
+    return count;
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************
+* | File      	:   Reader_Layout.h
+* | Function    :   Line layout shared by pagination and rendering
+* | Info        :
+*   Text is broken into lines once. Each line records where it starts, how
+*   many bytes and glyphs it covers, its width, its height and whether it
+*   is the indented first line of a paragraph, so the page index and the
+*   renderer work from the same line table and never measure text twice.
+*
+*   Lines are laid out from the book's glyph stream: a glyph ID alone tells
+*   the advance, no bytes are decoded here.
+*
+*   A line only depends on the glyph it starts at, so any page can also be
+*   laid out on its own and gives the same lines as a whole-book pass.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __READER_LAYOUT_H
+#define __READER_LAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Reader_Glyph.h"
+
+/**
+ * Line flags
+**/
+#define READER_LINE_INDENT      0x01    // First line of a paragraph
+#define READER_LINE_CN          0x02    // Contains multi-byte characters, drawn with the CN font
+#define READER_LINE_PARA_END    0x04    // Ended by a paragraph marker, which the line consumes
+
+/**
+ * One laid out line of text
+**/
+typedef struct {
+    uint32_t Start;     // Byte offset of the first character
+    uint16_t Length;    // Bytes drawn, excluding the paragraph marker
+    uint16_t Width;     // Sum of the glyph advances
+    uint8_t  Height;    // Line height
+    uint8_t  Flags;     // READER_LINE_*
+    uint16_t Glyphs;    // Glyphs drawn
+    uint32_t Glyph;     // Index of the first glyph
+} READER_LINE;
+
+/**
+ * Layout parameters
+**/
+typedef struct {
+    int LeftMargin;
+    int MaxX;           // Right edge of the text
+    int Indent;         // Extra left offset of the first line of a paragraph
+    int Top;            // Y of the first line on a page
+    int Bottom;         // Lines must end at or above this Y
+    int EnWidth;
+    int EnHeight;
+    int CnWidth;
+    int CnHeight;
+} READER_LAYOUT;
+
+/**
+ * Offset of the first byte after a line
+**/
+static inline uint32_t Reader_Line_End(const READER_LINE *line)
+{
+    return line->Start + line->Length + ((line->Flags & READER_LINE_PARA_END) ? 1 : 0);
+}
+
+/**
+ * Index of the first glyph after a line
+**/
+static inline uint32_t Reader_Line_NextGlyph(const READER_LINE *line)
+{
+    return line->Glyph + line->Glyphs + ((line->Flags & READER_LINE_PARA_END) ? 1 : 0);
+}
+
+uint32_t Reader_Layout_Line(const READER_LAYOUT *layout, const READER_GLYPHS *glyphs,
+                            uint32_t first, uint32_t offset, READER_LINE *line);
+int Reader_Layout_Page(const READER_LAYOUT *layout, const READER_GLYPHS *glyphs,
+                       uint32_t first, READER_LINE *lines, int max_lines, uint32_t *next);
+
+#endif
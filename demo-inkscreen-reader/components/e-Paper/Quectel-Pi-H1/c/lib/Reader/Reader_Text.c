@@ -0,0 +1,342 @@
+/*****************************************************************************
+* | File      	:   Reader_Text.c
+* | Function    :   Paragraph normalization of TXT books
+* | Info        :
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "Reader_Text.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define READER_SCAN_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Input consumed between releases of a mapped book
+#define READER_TEXT_RELEASE_WINDOW  (8 * 1024 * 1024)
+
+/**
+ * Find the first '\r', '\n' or space preceded by a space at or after pos.
+ * pos must be at least 1, returns size when there is none.
+**/
+typedef size_t (*READER_SCAN)(const uint8_t *p, size_t pos, size_t size);
+
+static size_t Reader_Scan_Scalar(const uint8_t *p, size_t pos, size_t size)
+{
+    for (; pos < size; pos++) {
+        uint8_t c = p[pos];
+        if (c > ' ')
+            continue;
+        if (c == '\r' || c == '\n' || (c == ' ' && p[pos - 1] == ' '))
+            return pos;
+    }
+    return size;
+}
+
+#ifdef READER_SCAN_X86
+static size_t Reader_Scan_SSE2(const uint8_t *p, size_t pos, size_t size)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i sp = _mm_set1_epi8(' ');
+
+    while (pos + 16 <= size) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + pos));
+        __m128i pv = _mm_loadu_si128((const __m128i *)(p + pos - 1));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)),
+                                 _mm_and_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(pv, sp)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask)
+            return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+    return Reader_Scan_Scalar(p, pos, size);
+}
+
+__attribute__((target("avx2")))
+static size_t Reader_Scan_AVX2(const uint8_t *p, size_t pos, size_t size)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i sp = _mm256_set1_epi8(' ');
+
+    while (pos + 32 <= size) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + pos));
+        __m256i pv = _mm256_loadu_si256((const __m256i *)(p + pos - 1));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf)),
+                                    _mm256_and_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(pv, sp)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+        if (mask)
+            return pos + __builtin_ctz(mask);
+        pos += 32;
+    }
+    return Reader_Scan_SSE2(p, pos, size);
+}
+#endif
+
+#ifdef __ARM_NEON
+static size_t Reader_Scan_NEON(const uint8_t *p, size_t pos, size_t size)
+{
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    const uint8x16_t lf = vdupq_n_u8('\n');
+    const uint8x16_t sp = vdupq_n_u8(' ');
+
+    while (pos + 16 <= size) {
+        uint8x16_t v = vld1q_u8(p + pos);
+        uint8x16_t pv = vld1q_u8(p + pos - 1);
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, cr), vceqq_u8(v, lf)),
+                                vandq_u8(vceqq_u8(v, sp), vceqq_u8(pv, sp)));
+        // Narrow to 4 bits per byte to get a scalar mask
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+        if (mask)
+            return pos + (__builtin_ctzll(mask) >> 2);
+        pos += 16;
+    }
+    return Reader_Scan_Scalar(p, pos, size);
+}
+#endif
+
+static READER_SCAN Reader_Scan = NULL;
+static const char *Reader_Scan_Name = "scalar";
+
+/******************************************************************************
+function:	Select the scanner
+parameter:
+    scan : READER_SCAN_*, AUTO picks the best one this CPU supports
+info:
+    Returns -1 when the scanner is not available on this build or CPU.
+******************************************************************************/
+int Reader_Text_SetScan(int scan)
+{
+    if (scan == READER_SCAN_AUTO) {
+#if defined(__ARM_NEON)
+        scan = READER_SCAN_NEON;
+#elif defined(READER_SCAN_X86)
+        scan = __builtin_cpu_supports("avx2") ? READER_SCAN_AVX2 :
+               __builtin_cpu_supports("sse2") ? READER_SCAN_SSE2 : READER_SCAN_SCALAR;
+#else
+        scan = READER_SCAN_SCALAR;
+#endif
+    }
+
+    switch (scan) {
+    case READER_SCAN_SCALAR:
+        Reader_Scan = Reader_Scan_Scalar;
+        Reader_Scan_Name = "scalar";
+        return 0;
+#ifdef READER_SCAN_X86
+    case READER_SCAN_SSE2:
+        if (!__builtin_cpu_supports("sse2"))
+            return -1;
+        Reader_Scan = Reader_Scan_SSE2;
+        Reader_Scan_Name = "sse2";
+        return 0;
+    case READER_SCAN_AVX2:
+        if (!__builtin_cpu_supports("avx2"))
+            return -1;
+        Reader_Scan = Reader_Scan_AVX2;
+        Reader_Scan_Name = "avx2";
+        return 0;
+#endif
+#ifdef __ARM_NEON
+    case READER_SCAN_NEON:
+        Reader_Scan = Reader_Scan_NEON;
+        Reader_Scan_Name = "neon";
+        return 0;
+#endif
+    default:
+        return -1;
+    }
+}
+
+/******************************************************************************
+function:	Name of the scanner in use
+******************************************************************************/
+const char *Reader_Text_ScanName(void)
+{
+    if (!Reader_Scan)
+        Reader_Text_SetScan(READER_SCAN_AUTO);
+    return Reader_Scan_Name;
+}
+
+/******************************************************************************
+function:	Whether a character starting just before pos can extend past it
+parameter:
+    base : A known character start, bytes before it are not looked at
+******************************************************************************/
+static int Reader_Text_Overlaps(const char *text, size_t size, size_t base, size_t pos,
+                                READER_CHAR_LEN char_len)
+{
+    size_t k;
+
+    for (k = 1; k < READER_TEXT_MAX_CHAR && k <= pos - base; k++) {
+        if ((size_t)char_len(text, size, pos - k) > k)
+            return 1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+function:	End of the character containing pos
+parameter:
+    base : A known character start at or before pos
+info:
+    Returns pos when a character starts there. A lead byte of malformed
+    text can swallow a following '\r', '\n' or space; the scanner does not
+    know about characters, so each byte it stops at is checked here.
+******************************************************************************/
+static size_t Reader_Text_CharEnd(const char *text, size_t size, size_t base, size_t pos,
+                                  READER_CHAR_LEN char_len)
+{
+    size_t q;
+
+    // Well-formed text never has a lead byte reaching over the byte found
+    if (!Reader_Text_Overlaps(text, size, base, pos, char_len))
+        return pos;
+
+    // Back up to a byte that is certainly a character start, then walk forward
+    q = pos - 1;
+    while (q > base && Reader_Text_Overlaps(text, size, base, q, char_len))
+        q--;
+    while (q < pos) {
+        size_t len = (size_t)char_len(text, size, q);
+        if (q + len > pos)
+            return q + len;
+        q += len;
+    }
+    return pos;
+}
+
+/******************************************************************************
+function:	Drop pages of a mapped book that the pass has moved past
+******************************************************************************/
+static void Reader_Text_Release(const char *raw, size_t *released, size_t consumed)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t end = consumed & ~(page - 1);
+
+    if (end > *released) {
+        madvise((void *)(raw + *released), end - *released, MADV_DONTNEED);
+        *released = end;
+    }
+}
+
+/******************************************************************************
+function:	Normalize the paragraphs of a book
+parameter:
+    raw          : Raw book content
+    raw_size     : Size of the raw content
+    char_len     : Character length function of the book encoding
+    out_size     : Receives the size of the result, may be NULL
+    input_mapped : raw is a read-only file mapping, consumed input is
+                   released as the pass goes
+info:
+    Returns a malloc'd, NUL-terminated buffer, or NULL.
+    - A run of line breaks ("\r\n" and "\n\r" count once) of two or more
+      ends the paragraph with '\n', a single one inside a paragraph
+      becomes a space.
+    - Spaces at the start of a paragraph are dropped and the character
+      after them is taken as is; inside a paragraph a space following a
+      space is dropped.
+    - A multi-byte character is copied whole, whatever bytes it covers.
+******************************************************************************/
+char *Reader_Text_Normalize(const char *raw, size_t raw_size, READER_CHAR_LEN char_len,
+                            size_t *out_size, int input_mapped)
+{
+    const uint8_t *p = (const uint8_t *)raw;
+    size_t src = 0, dst = 0, released = 0;
+    int in_paragraph = 0;
+    char *out, *result;
+
+    if (!raw || raw_size == 0)
+        return NULL;
+    if (!Reader_Scan)
+        Reader_Text_SetScan(READER_SCAN_AUTO);
+
+    // Output is never longer than the input, only the pages written become resident
+    out = malloc(raw_size + 1);
+    if (!out)
+        return NULL;
+
+    while (src < raw_size) {
+        uint8_t c = p[src];
+
+        if (input_mapped && src - released >= READER_TEXT_RELEASE_WINDOW)
+            Reader_Text_Release(raw, &released, src);
+
+        if (c == '\r' || c == '\n') {
+            int count = 0;
+            while (src < raw_size && (p[src] == '\r' || p[src] == '\n')) {
+                count++;
+                if (src + 1 < raw_size && p[src + 1] != p[src] && (p[src + 1] == '\r' || p[src + 1] == '\n'))
+                    src += 2;
+                else
+                    src++;
+            }
+            if (count >= 2) {
+                if (in_paragraph) {
+                    out[dst++] = '\n';
+                    in_paragraph = 0;
+                }
+            } else if (in_paragraph) {
+                out[dst++] = ' ';
+            }
+            continue;
+        }
+
+        if (c == ' ') {
+            if (!in_paragraph) {
+                while (src < raw_size && p[src] == ' ')
+                    src++;
+                if (src >= raw_size)
+                    break;
+                if (p[src] == '\r' || p[src] == '\n') {
+                    out[dst++] = (char)p[src++];
+                    in_paragraph = 1;
+                    continue;
+                }
+            } else if (out[dst - 1] == ' ') {
+                src++;
+                continue;
+            }
+        }
+
+        // Copy up to the next byte that needs attention, unless it is part of a character
+        size_t base = src;
+        size_t end = Reader_Scan(p, src + 1, raw_size);
+        while (end < raw_size) {
+            size_t char_end = Reader_Text_CharEnd(raw, raw_size, base, end, char_len);
+            if (char_end == end)
+                break;
+            if (char_end >= raw_size) {
+                end = raw_size;
+                break;
+            }
+            base = char_end;
+            end = Reader_Scan(p, char_end, raw_size);
+        }
+
+        memcpy(out + dst, raw + src, end - src);
+        dst += end - src;
+        src = end;
+        in_paragraph = 1;
+    }
+
+    out[dst] = '\0';
+    // Reallocate to appropriate size
+    result = realloc(out, dst + 1);
+    if (!result)
+        result = out;
+    if (out_size)
+        *out_size = dst;
+    return result;
+}
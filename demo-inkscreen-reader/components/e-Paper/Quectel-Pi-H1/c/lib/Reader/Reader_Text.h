@@ -0,0 +1,42 @@
+/*****************************************************************************
+* | File      	:   Reader_Text.h
+* | Function    :   Paragraph normalization of TXT books
+* | Info        :
+*   Line breaks inside a paragraph become spaces, a blank line ends the
+*   paragraph with a single '\n', leading spaces of a paragraph are dropped
+*   and repeated spaces inside it are collapsed.
+*
+*   The text is scanned a vector at a time for the few bytes that need
+*   attention ('\r', '\n' and a space after a space); everything between
+*   them is copied in bulk.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#ifndef __READER_TEXT_H
+#define __READER_TEXT_H
+
+#include <stddef.h>
+
+/**
+ * Byte length of the character at pos, at most READER_TEXT_MAX_CHAR
+**/
+typedef int (*READER_CHAR_LEN)(const char *text, size_t size, size_t pos);
+#define READER_TEXT_MAX_CHAR    4
+
+/**
+ * Scanner selection, for benchmarks; not every module has every scanner
+**/
+#define READER_SCAN_AUTO        0
+#define READER_SCAN_SCALAR      1
+#define READER_SCAN_SSE2        2
+#define READER_SCAN_AVX2        3
+#define READER_SCAN_NEON        4
+#define READER_SCAN_SSSE3       5
+
+char *Reader_Text_Normalize(const char *raw, size_t raw_size, READER_CHAR_LEN char_len,
+                            size_t *out_size, int input_mapped);
+int Reader_Text_SetScan(int scan);
+const char *Reader_Text_ScanName(void);
+
+#endif
@@ -31,12 +31,55 @@
 #include "EPD_7in5_V2.h"
 #include "Debug.h"
 
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define EPD_7IN5_V2_CHUNK_ROWS  32  // Rows per SPI transfer, within the 4096 byte spidev buffer
+
+/**
+ * Refreshes started by the _Async functions, waited for by a watcher thread
+**/
+static struct {
+    pthread_mutex_t Lock;
+    pthread_cond_t Cond;                    // Pending or Running changed
+    pthread_t Thread;
+    int Running;                            // Set by EPD_7IN5_V2_Async_Start()
+    int Pending;                            // A refresh started, BUSY not released yet
+    int Fd;                                 // eventfd, counts the refreshes done
+    EPD_7IN5_V2_IDLE_CALLBACK Callback;
+    void *Arg;
+} EPD_Async = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, .Fd = -1};
+
+/******************************************************************************
+function :	Wait for a refresh started asynchronously to finish
+parameter:
+info:
+    Every command goes through here first: the panel takes none while
+    it is busy. Only the watcher leaves a refresh pending, so until
+    EPD_7IN5_V2_Async_Start() this returns without taking the lock.
+    Async_Start() and Async_Stop() run on the thread that sends the
+    commands, and Stop joins the watcher once nothing is pending.
+******************************************************************************/
+static void EPD_WaitRefresh(void)
+{
+    if (!__atomic_load_n(&EPD_Async.Running, __ATOMIC_ACQUIRE))
+        return;
+    pthread_mutex_lock(&EPD_Async.Lock);
+    while (EPD_Async.Pending)
+        pthread_cond_wait(&EPD_Async.Cond, &EPD_Async.Lock);
+    pthread_mutex_unlock(&EPD_Async.Lock);
+}
+
 /******************************************************************************
 function :	Software reset
 parameter:
 ******************************************************************************/
 static void EPD_Reset(void)
 {
+    EPD_WaitRefresh();
     DEV_Digital_Write(EPD_RST_PIN, 1);
     DEV_Delay_ms(20);
     DEV_Digital_Write(EPD_RST_PIN, 0);
@@ -52,6 +95,7 @@ parameter:
 ******************************************************************************/
 static void EPD_SendCommand(UBYTE Reg)
 {
+    EPD_WaitRefresh();
     DEV_Digital_Write(EPD_DC_PIN, 0);
     DEV_Digital_Write(EPD_CS_PIN, 0);
     DEV_SPI_WriteByte(Reg);
@@ -71,14 +115,42 @@ static void EPD_SendData(UBYTE Data)
     DEV_Digital_Write(EPD_CS_PIN, 1);
 }
 
-static void EPD_SendData2(UBYTE *pData, UDOUBLE len)
+static void EPD_SendData2(const UBYTE *pData, UDOUBLE len)
 {
     DEV_Digital_Write(EPD_DC_PIN, 1);
     DEV_Digital_Write(EPD_CS_PIN, 0);
-    DEV_SPI_Write_nByte(pData, len);
+    DEV_SPI_Write_nByte((UBYTE *)pData, len);
     DEV_Digital_Write(EPD_CS_PIN, 1);
 }
 
+/******************************************************************************
+function :	Send an image inverted, leaving it as it is
+parameter:
+    pData : Image bytes
+    len   : Number of bytes
+info:
+    The bytes go through a bounce buffer of EPD_7IN5_V2_CHUNK_ROWS rows,
+    inverted eight at a time, and out in one transfer per chunk.
+******************************************************************************/
+static void EPD_SendDataInverted(const UBYTE *pData, UDOUBLE len)
+{
+    static UBYTE bounce[EPD_7IN5_V2_CHUNK_ROWS * (EPD_7IN5_V2_WIDTH / 8)];
+    UDOUBLE done, n, i;
+    uint64_t w;
+
+    for (done = 0; done < len; done += n) {
+        n = len - done < sizeof(bounce) ? len - done : sizeof(bounce);
+        for (i = 0; i + 8 <= n; i += 8) {
+            memcpy(&w, pData + done + i, 8);
+            w = ~w;
+            memcpy(bounce + i, &w, 8);
+        }
+        for (; i < n; i++)
+            bounce[i] = ~pData[done + i];
+        EPD_SendData2(bounce, n);
+    }
+}
+
 /******************************************************************************
 function :	Wait until the busy_pin goes LOW
 parameter:
@@ -103,6 +175,162 @@ static void EPD_7IN5_V2_TurnOnDisplay(void)
     EPD_WaitUntilIdle();
 }
 
+/******************************************************************************
+function :	Start a refresh and return without waiting for it
+parameter:
+info:
+    With the watcher running the refresh is left pending to it; without,
+    this waits as EPD_7IN5_V2_TurnOnDisplay() does.
+******************************************************************************/
+static void EPD_7IN5_V2_StartRefresh(void)
+{
+    int running;
+
+    EPD_SendCommand(0x12);			//DISPLAY REFRESH
+    pthread_mutex_lock(&EPD_Async.Lock);
+    running = EPD_Async.Running;
+    if (running) {
+        EPD_Async.Pending = 1;
+        pthread_cond_broadcast(&EPD_Async.Cond);
+    }
+    pthread_mutex_unlock(&EPD_Async.Lock);
+    if (!running) {
+        DEV_Delay_ms(10);
+        EPD_WaitUntilIdle();
+    }
+}
+
+/******************************************************************************
+function :	Watcher thread, waits out each pending refresh
+parameter:
+info:
+    BUSY is polled as EPD_WaitUntilIdle() does; the thread that started
+    the refresh does not touch the panel meanwhile. Once BUSY releases the
+    eventfd is bumped and the callback runs, here on the watcher.
+******************************************************************************/
+static void *EPD_7IN5_V2_Watch(void *arg)
+{
+    EPD_7IN5_V2_IDLE_CALLBACK callback;
+    void *callback_arg;
+    uint64_t one = 1;
+
+    (void)arg;
+    pthread_mutex_lock(&EPD_Async.Lock);
+    for (;;) {
+        while (EPD_Async.Running && !EPD_Async.Pending)
+            pthread_cond_wait(&EPD_Async.Cond, &EPD_Async.Lock);
+        if (!EPD_Async.Pending)
+            break;
+        pthread_mutex_unlock(&EPD_Async.Lock);
+
+        DEV_Delay_ms(10);	        //!!!The delay here is necessary, 200uS at least!!!
+        EPD_WaitUntilIdle();
+
+        pthread_mutex_lock(&EPD_Async.Lock);
+        EPD_Async.Pending = 0;
+        pthread_cond_broadcast(&EPD_Async.Cond);
+        callback = EPD_Async.Callback;
+        callback_arg = EPD_Async.Arg;
+        pthread_mutex_unlock(&EPD_Async.Lock);
+
+        if (write(EPD_Async.Fd, &one, sizeof(one)) != sizeof(one))
+            Debug("e-Paper idle event lost\r\n");
+        if (callback)
+            callback(callback_arg);
+        pthread_mutex_lock(&EPD_Async.Lock);
+    }
+    pthread_mutex_unlock(&EPD_Async.Lock);
+    return NULL;
+}
+
+/******************************************************************************
+function :	Let the _Async functions return once the data is sent
+parameter:
+    callback : Called on the watcher thread whenever a refresh is done, or NULL
+    arg      : Passed to callback
+info:
+    Returns an eventfd that turns readable when a refresh is done, its
+    count the refreshes done since last read; -1 on failure. Called again,
+    only the callback changes.
+******************************************************************************/
+int EPD_7IN5_V2_Async_Start(EPD_7IN5_V2_IDLE_CALLBACK callback, void *arg)
+{
+    int fd;
+
+    pthread_mutex_lock(&EPD_Async.Lock);
+    EPD_Async.Callback = callback;
+    EPD_Async.Arg = arg;
+    if (EPD_Async.Running) {
+        fd = EPD_Async.Fd;
+        pthread_mutex_unlock(&EPD_Async.Lock);
+        return fd;
+    }
+    EPD_Async.Fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (EPD_Async.Fd < 0) {
+        pthread_mutex_unlock(&EPD_Async.Lock);
+        return -1;
+    }
+    __atomic_store_n(&EPD_Async.Running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&EPD_Async.Thread, NULL, EPD_7IN5_V2_Watch, NULL) != 0) {
+        __atomic_store_n(&EPD_Async.Running, 0, __ATOMIC_RELEASE);
+        close(EPD_Async.Fd);
+        EPD_Async.Fd = -1;
+    }
+    fd = EPD_Async.Fd;
+    pthread_mutex_unlock(&EPD_Async.Lock);
+    return fd;
+}
+
+/******************************************************************************
+function :	Wait for a pending refresh and stop the watcher
+parameter:
+info:
+    The _Async functions wait for their refresh again afterwards; the
+    eventfd is closed.
+******************************************************************************/
+void EPD_7IN5_V2_Async_Stop(void)
+{
+    pthread_mutex_lock(&EPD_Async.Lock);
+    if (!EPD_Async.Running) {
+        pthread_mutex_unlock(&EPD_Async.Lock);
+        return;
+    }
+    __atomic_store_n(&EPD_Async.Running, 0, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&EPD_Async.Cond);
+    pthread_mutex_unlock(&EPD_Async.Lock);
+
+    pthread_join(EPD_Async.Thread, NULL);
+    close(EPD_Async.Fd);
+    EPD_Async.Fd = -1;
+    EPD_Async.Callback = NULL;
+}
+
+/******************************************************************************
+function :	Whether a refresh is still running
+parameter:
+******************************************************************************/
+UBYTE EPD_7IN5_V2_IsBusy(void)
+{
+    int running, pending;
+
+    pthread_mutex_lock(&EPD_Async.Lock);
+    running = EPD_Async.Running;
+    pending = EPD_Async.Pending;
+    pthread_mutex_unlock(&EPD_Async.Lock);
+    if (running)
+        return pending;
+    return !DEV_Digital_Read(EPD_BUSY_PIN);
+}
+
+/******************************************************************************
+function :	Wait until a refresh started asynchronously is done
+parameter:
+******************************************************************************/
+void EPD_7IN5_V2_WaitIdle(void)
+{
+    EPD_WaitRefresh();
+}
+
 /******************************************************************************
 function :	Initialize the e-Paper register
 parameter:
@@ -308,29 +536,48 @@ void EPD_7IN5_V2_ClearBlack(void)
 }
 
 /******************************************************************************
-function :	Sends the image buffer in RAM to e-Paper and displays
+function :	Send the image buffer as the old and new data planes
 parameter:
 ******************************************************************************/
-void EPD_7IN5_V2_Display(UBYTE *blackimage)
+static void EPD_7IN5_V2_SendFrame(const UBYTE *blackimage)
 {
-    UDOUBLE Width, Height;
+    UDOUBLE Width, Height, Rows;
     Width =(EPD_7IN5_V2_WIDTH % 8 == 0)?(EPD_7IN5_V2_WIDTH / 8 ):(EPD_7IN5_V2_WIDTH / 8 + 1);
     Height = EPD_7IN5_V2_HEIGHT;
     EPD_SendCommand(0x10);
-    for (UDOUBLE j = 0; j < Height; j++) {
-        EPD_SendData2((UBYTE *)(blackimage+j*Width), Width);
+    for (UDOUBLE j = 0; j < Height; j += Rows) {
+        Rows = Height - j < EPD_7IN5_V2_CHUNK_ROWS ? Height - j : EPD_7IN5_V2_CHUNK_ROWS;
+        EPD_SendData2(blackimage + j * Width, Rows * Width);
     }
     EPD_SendCommand(0x13);
-    for (UDOUBLE j = 0; j < Height; j++) {
-        for (UDOUBLE i = 0; i < Width; i++) {
-            blackimage[i + j * Width] = ~blackimage[i + j * Width];
-        }
-    }
-    for (UDOUBLE j = 0; j < Height; j++) {
-        EPD_SendData2((UBYTE *)(blackimage+j*Width), Width);
-    }
+    EPD_SendDataInverted(blackimage, Width * Height);
+}
+
+/******************************************************************************
+function :	Sends the image buffer in RAM to e-Paper and displays
+parameter:
+info:
+    The new data plane is the image inverted, made on the way out; the
+    image itself is left as it was and can be diffed or shown again.
+******************************************************************************/
+void EPD_7IN5_V2_Display(const UBYTE *blackimage)
+{
+    EPD_7IN5_V2_SendFrame(blackimage);
     EPD_7IN5_V2_TurnOnDisplay();
 }
+
+/******************************************************************************
+function :	EPD_7IN5_V2_Display() returning once the image is sent
+parameter:
+info:
+    The image may be reused right away. The refresh runs on, see
+    EPD_7IN5_V2_Async_Start().
+******************************************************************************/
+void EPD_7IN5_V2_Display_Async(const UBYTE *blackimage)
+{
+    EPD_7IN5_V2_SendFrame(blackimage);
+    EPD_7IN5_V2_StartRefresh();
+}
 // void EPD_7IN5_V2_ReadBusy(void)
 // {
 //     Debug("e-Paper busy\r\n");
@@ -365,12 +612,14 @@ void EPD_7IN5_V2_Display(UBYTE *blackimage)
 //     // Optional: Enter sleep to save power
 //     // EPD_7IN5_V2_Sleep();
 // }
-void EPD_7IN5_V2_Display_Part(UBYTE *blackimage,UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end)
+/******************************************************************************
+function :	Enter partial mode for a window and start its new data
+parameter:
+    x_start, y_start : Top left corner
+    x_end, y_end     : Bottom right corner, not included
+******************************************************************************/
+static void EPD_7IN5_V2_PartWindow(UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end)
 {
-    UDOUBLE Width, Height;
-    Width =((x_end - x_start) % 8 == 0)?((x_end - x_start) / 8 ):((x_end - x_start) / 8 + 1);
-    Height = y_end - y_start;
-
     EPD_SendCommand(0x50);
 	EPD_SendData(0xA9);
 	EPD_SendData(0x07);
@@ -380,23 +629,97 @@ void EPD_7IN5_V2_Display_Part(UBYTE *blackimage,UDOUBLE x_start, UDOUBLE y_start
 	EPD_SendData (x_start/256);
 	EPD_SendData (x_start%256);   //x-start    
 
-	EPD_SendData (x_end/256);		
-	EPD_SendData (x_end%256-1);  //x-end	
+	EPD_SendData ((x_end-1)/256);		
+	EPD_SendData ((x_end-1)%256);  //x-end	
 
 	EPD_SendData (y_start/256);  //
 	EPD_SendData (y_start%256);   //y-start    
 
-	EPD_SendData (y_end/256);		
-	EPD_SendData (y_end%256-1);  //y-end
+	EPD_SendData ((y_end-1)/256);		
+	EPD_SendData ((y_end-1)%256);  //y-end
 	EPD_SendData (0x01);
     
     EPD_SendCommand(0x13);
+}
+
+void EPD_7IN5_V2_Display_Part(UBYTE *blackimage,UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end)
+{
+    UDOUBLE Width, Height;
+    Width =((x_end - x_start) % 8 == 0)?((x_end - x_start) / 8 ):((x_end - x_start) / 8 + 1);
+    Height = y_end - y_start;
+
+    EPD_7IN5_V2_PartWindow(x_start, y_start, x_end, y_end);
     for (UDOUBLE j = 0; j < Height; j++) {
         EPD_SendData2((UBYTE *)(blackimage+j*Width), Width);
     }
     EPD_7IN5_V2_TurnOnDisplay();
 }
 
+/******************************************************************************
+function :	Enter partial mode for a window of a whole frame and send it
+parameter:
+info:
+    Returns 0 for an empty window, nothing is sent then.
+******************************************************************************/
+static UBYTE EPD_7IN5_V2_SendWindow(const UBYTE *frame, UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end)
+{
+    UDOUBLE Stride = EPD_7IN5_V2_WIDTH / 8;
+    UDOUBLE Width, Rows;
+
+    x_start &= ~7u;
+    x_end = (x_end + 7) & ~7u;
+    if (x_end > EPD_7IN5_V2_WIDTH)
+        x_end = EPD_7IN5_V2_WIDTH;
+    if (y_end > EPD_7IN5_V2_HEIGHT)
+        y_end = EPD_7IN5_V2_HEIGHT;
+    if (x_start >= x_end || y_start >= y_end)
+        return 0;
+    Width = (x_end - x_start) / 8;
+
+    EPD_7IN5_V2_PartWindow(x_start, y_start, x_end, y_end);
+    if (Width == Stride) {
+        for (UDOUBLE j = y_start; j < y_end; j += Rows) {
+            Rows = y_end - j < EPD_7IN5_V2_CHUNK_ROWS ? y_end - j : EPD_7IN5_V2_CHUNK_ROWS;
+            EPD_SendData2(frame + j * Stride, Rows * Width);
+        }
+    } else {
+        for (UDOUBLE j = y_start; j < y_end; j++)
+            EPD_SendData2(frame + j * Stride + x_start / 8, Width);
+    }
+    return 1;
+}
+
+/******************************************************************************
+function :	Partial refresh of a window of a whole frame
+parameter:
+    frame            : Whole panel frame, rows of EPD_7IN5_V2_WIDTH / 8 bytes
+    x_start, y_start : Top left corner
+    x_end, y_end     : Bottom right corner, not included
+info:
+    Columns are widened to whole bytes and the window is clipped to the
+    panel. Only the bytes of the window are sent, read from the frame
+    row by row; a window as wide as the panel goes out in chunks of
+    EPD_7IN5_V2_CHUNK_ROWS rows. An empty window is not refreshed.
+******************************************************************************/
+void EPD_7IN5_V2_Display_Window(const UBYTE *frame, UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end)
+{
+    if (EPD_7IN5_V2_SendWindow(frame, x_start, y_start, x_end, y_end))
+        EPD_7IN5_V2_TurnOnDisplay();
+}
+
+/******************************************************************************
+function :	EPD_7IN5_V2_Display_Window() returning once the window is sent
+parameter:
+info:
+    The frame may be reused right away. The refresh runs on, see
+    EPD_7IN5_V2_Async_Start().
+******************************************************************************/
+void EPD_7IN5_V2_Display_Window_Async(const UBYTE *frame, UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end)
+{
+    if (EPD_7IN5_V2_SendWindow(frame, x_start, y_start, x_end, y_end))
+        EPD_7IN5_V2_StartRefresh();
+}
+
 void EPD_7IN5_V2_Display_4Gray(const UBYTE *Image)
 {
     UDOUBLE i,j,k;
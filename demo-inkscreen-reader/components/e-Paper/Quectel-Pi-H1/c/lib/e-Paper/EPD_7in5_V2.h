@@ -40,14 +40,34 @@
 #define EPD_7IN5_V2_WIDTH       800
 #define EPD_7IN5_V2_HEIGHT      480
 
+/**
+ * Called on the watcher thread once BUSY releases after a refresh
+ *
+ * The _Async display calls return once the image and the refresh
+ * command are sent over SPI. After EPD_7IN5_V2_Async_Start() a watcher
+ * thread waits out the refresh, then bumps the eventfd Async_Start()
+ * returned and calls this. Any command sent meanwhile waits for it.
+ * Before Async_Start() and after Async_Stop() every call blocks as
+ * before, and commands take no lock. Call Async_Start() and Async_Stop()
+ * from the thread that drives the panel.
+**/
+typedef void (*EPD_7IN5_V2_IDLE_CALLBACK)(void *arg);
+
 UBYTE EPD_7IN5_V2_Init(void);
 UBYTE EPD_7IN5_V2_Init_Fast(void);
 UBYTE EPD_7IN5_V2_Init_Part(void);
 UBYTE EPD_7IN5_V2_Init_4Gray(void);
 void EPD_7IN5_V2_Clear(void);
 void EPD_7IN5_V2_ClearBlack(void);
-void EPD_7IN5_V2_Display(UBYTE *blackimage);
+void EPD_7IN5_V2_Display(const UBYTE *blackimage);
 void EPD_7IN5_V2_Display_Part(UBYTE *blackimage,UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end);
+void EPD_7IN5_V2_Display_Window(const UBYTE *frame, UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end);
+void EPD_7IN5_V2_Display_Async(const UBYTE *blackimage);
+void EPD_7IN5_V2_Display_Window_Async(const UBYTE *frame, UDOUBLE x_start, UDOUBLE y_start, UDOUBLE x_end, UDOUBLE y_end);
+int EPD_7IN5_V2_Async_Start(EPD_7IN5_V2_IDLE_CALLBACK callback, void *arg);
+void EPD_7IN5_V2_Async_Stop(void);
+UBYTE EPD_7IN5_V2_IsBusy(void);
+void EPD_7IN5_V2_WaitIdle(void);
 void EPD_7IN5_V2_Display_4Gray(const UBYTE *Image);
 void EPD_7IN5_V2_Sleep(void);
 void EPD_7IN5_V2_Display_Full_Image(UBYTE *image);
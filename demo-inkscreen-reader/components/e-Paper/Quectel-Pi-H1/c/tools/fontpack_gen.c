@@ -0,0 +1,276 @@
+/*****************************************************************************
+* | File      	:   fontpack_gen.c
+* | Function    :   Build a CN font pack from a TrueType/OpenType/BDF/PCF font
+* | Info        :
+*   Runs on the host:
+*       make fontpack
+*       ./bin/fontpack_gen <font file> <pixel size> <out.fpk> [gb2312|gbk] [packbits]
+*   Every ASCII character and every GB2312 (default) or GBK code is
+*   converted to Unicode, rendered 1-bit by FreeType at the given size and
+*   stored at the size of the font cell, see fontpack.h. Codes the font
+*   has no glyph for are left out. Bitmap fonts (e.g. WenQuanYi Bitmap
+*   Song PCF) are used at their strike closest to the size.
+*
+*   Typical packs for the reader: 12, 16 and 24 px from one CJK font.
+*----------------
+* |	This version:   V1.0
+* | Info        :
+******************************************************************************/
+#include "fontpack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iconv.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+typedef struct {
+    FT_Face Face;
+    int Width;
+    int Height;
+    int Baseline;
+    int GlyphBytes;
+} GEN_FONT;
+
+// Unicode code point of a GBK code, 0 if it has none
+static uint32_t gbk_to_unicode(iconv_t cd, unsigned char hi, unsigned char lo)
+{
+    char in_buf[2] = { (char)hi, (char)lo };
+    unsigned char out_buf[8];
+    char *in = in_buf, *out = (char *)out_buf;
+    size_t in_left = 2, out_left = sizeof(out_buf);
+
+    iconv(cd, NULL, NULL, NULL, NULL);
+    if (iconv(cd, &in, &in_left, &out, &out_left) == (size_t)-1 || out_left != 4)
+        return 0;
+    return out_buf[0] | (out_buf[1] << 8) | (out_buf[2] << 16) | ((uint32_t)out_buf[3] << 24);
+}
+
+// Render one character into a cell, returns the advance or -1 if the font lacks it
+static int render(const GEN_FONT *gen, uint32_t cp, int center, uint8_t *cell)
+{
+    FT_Face face = gen->Face;
+    FT_UInt index = FT_Get_Char_Index(face, cp);
+    int stride = (gen->Width + 7) / 8;
+    int advance, x0, y0, x, y;
+
+    memset(cell, 0, gen->GlyphBytes);
+    if (index == 0 || FT_Load_Glyph(face, index, FT_LOAD_RENDER | FT_LOAD_TARGET_MONO | FT_LOAD_MONOCHROME) != 0)
+        return -1;
+
+    FT_GlyphSlot slot = face->glyph;
+    FT_Bitmap *bm = &slot->bitmap;
+    advance = (int)((slot->advance.x + 63) >> 6);
+    x0 = slot->bitmap_left;
+    if (center)
+        x0 += (gen->Width - advance) / 2;
+    if (x0 < 0)
+        x0 = 0;
+    y0 = gen->Baseline - slot->bitmap_top;
+
+    for (y = 0; y < (int)bm->rows; y++) {
+        int cy = y0 + y;
+        if (cy < 0 || cy >= gen->Height)
+            continue;
+        for (x = 0; x < (int)bm->width; x++) {
+            int cx = x0 + x;
+            const unsigned char *row = bm->buffer + y * bm->pitch;
+            if (cx >= gen->Width || bm->pixel_mode != FT_PIXEL_MODE_MONO)
+                break;
+            if (row[x >> 3] & (0x80 >> (x & 7)))
+                cell[cy * stride + (cx >> 3)] |= 0x80 >> (cx & 7);
+        }
+    }
+    return advance;
+}
+
+// PackBits, returns the packed size; dst holds at least size + size / 128 + 1 bytes
+static size_t pack_bits(const uint8_t *src, size_t size, uint8_t *dst)
+{
+    size_t i = 0, n = 0;
+
+    while (i < size) {
+        size_t run = 1;
+        while (i + run < size && run < 128 && src[i + run] == src[i])
+            run++;
+        if (run >= 3) {
+            dst[n++] = (uint8_t)(257 - run);
+            dst[n++] = src[i];
+            i += run;
+            continue;
+        }
+        // Literals up to the next run of three
+        size_t start = i, len = 0;
+        while (i < size && len < 128) {
+            if (i + 2 < size && src[i] == src[i + 1] && src[i] == src[i + 2])
+                break;
+            i++;
+            len++;
+        }
+        dst[n++] = (uint8_t)(len - 1);
+        memcpy(dst + n, src + start, len);
+        n += len;
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    FT_Library library;
+    GEN_FONT gen;
+    FONT_PACK_HEADER hdr;
+    uint16_t *lookup;
+    uint8_t *glyphs, *packed = NULL;
+    uint32_t *blocks = NULL;
+    size_t count = 0, data_size, packed_size = 0;
+    int gbk = 0, packbits = 0, px, i, hi, lo, ascii_width = 1;
+    iconv_t cd;
+    FILE *fp;
+
+    if (argc < 4) {
+        printf("usage: %s <font file> <pixel size> <out.fpk> [gb2312|gbk] [packbits]\n", argv[0]);
+        return 1;
+    }
+    px = atoi(argv[2]);
+    for (i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "gbk") == 0)
+            gbk = 1;
+        else if (strcmp(argv[i], "packbits") == 0)
+            packbits = 1;
+        else if (strcmp(argv[i], "gb2312") != 0) {
+            printf("Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (px <= 0 || px > MAX_WIDTH_FONT) {
+        printf("Pixel size must be 1 to %d\n", MAX_WIDTH_FONT);
+        return 1;
+    }
+
+    if (FT_Init_FreeType(&library) != 0 || FT_New_Face(library, argv[1], 0, &gen.Face) != 0) {
+        printf("Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    if (FT_IS_SCALABLE(gen.Face)) {
+        FT_Set_Pixel_Sizes(gen.Face, 0, px);
+    } else {
+        int best = 0;
+        for (i = 1; i < gen.Face->num_fixed_sizes; i++)
+            if (abs(gen.Face->available_sizes[i].height - px) < abs(gen.Face->available_sizes[best].height - px))
+                best = i;
+        FT_Select_Size(gen.Face, best);
+    }
+
+    gen.Width = px;
+    gen.Baseline = (int)((gen.Face->size->metrics.ascender + 63) >> 6);
+    gen.Height = gen.Baseline - (int)(gen.Face->size->metrics.descender >> 6);
+    if (gen.Height < px)
+        gen.Height = px;
+    if (gen.Height > MAX_HEIGHT_FONT)
+        gen.Height = MAX_HEIGHT_FONT;
+    gen.GlyphBytes = gen.Height * ((gen.Width + 7) / 8);
+
+    lookup = malloc(sizeof(uint16_t) * FONT_CN_SLOTS);
+    glyphs = malloc((size_t)FONT_CN_SLOTS * gen.GlyphBytes);
+    cd = iconv_open("UTF-32LE", "GBK");
+    if (!lookup || !glyphs || cd == (iconv_t)-1) {
+        printf("Out of memory or no GBK support in iconv\n");
+        return 1;
+    }
+    for (i = 0; i < FONT_CN_SLOTS; i++)
+        lookup[i] = FONT_CN_NONE;
+
+    // ASCII first, then the double-byte codes in code order
+    for (i = 0x20; i < 0x7F; i++) {
+        int advance = render(&gen, i, 0, glyphs + count * gen.GlyphBytes);
+        if (advance < 0)
+            continue;
+        if (advance > ascii_width)
+            ascii_width = advance;
+        lookup[Font_CN_Slot(i, 0)] = (uint16_t)count++;
+    }
+    for (hi = gbk ? 0x81 : 0xA1; hi <= 0xFE; hi++) {
+        for (lo = gbk ? 0x40 : 0xA1; lo <= 0xFE; lo++) {
+            uint32_t cp = gbk_to_unicode(cd, hi, lo);
+            if (cp == 0 || (cp >= 0xE000 && cp <= 0xF8FF))  // User-defined areas map to private use
+                continue;
+            if (render(&gen, cp, 1, glyphs + count * gen.GlyphBytes) < 0)
+                continue;
+            lookup[Font_CN_Slot(hi, lo)] = (uint16_t)count++;
+        }
+    }
+    iconv_close(cd);
+    if (ascii_width > gen.Width)
+        ascii_width = gen.Width;
+    data_size = count * gen.GlyphBytes;
+
+    if (packbits) {
+        size_t nblocks = (count + FONT_PACK_BLOCK - 1) / FONT_PACK_BLOCK;
+        size_t block_bytes = (size_t)FONT_PACK_BLOCK * gen.GlyphBytes;
+        uint8_t *check = malloc(block_bytes);
+        blocks = malloc(sizeof(uint32_t) * (nblocks + 1));
+        packed = malloc(data_size + data_size / 128 + nblocks + 1);
+        if (!blocks || !packed || !check) {
+            printf("Out of memory\n");
+            return 1;
+        }
+        for (i = 0; i < (int)nblocks; i++) {
+            size_t start = (size_t)i * block_bytes;
+            size_t len = start + block_bytes <= data_size ? block_bytes : data_size - start;
+            blocks[i] = (uint32_t)packed_size;
+            size_t n = pack_bits(glyphs + start, len, packed + packed_size);
+            if (Font_Pack_Unpack(packed + packed_size, n, check, len) != len ||
+                memcmp(check, glyphs + start, len) != 0) {
+                printf("PackBits round trip failed in block %d\n", i);
+                return 1;
+            }
+            packed_size += n;
+        }
+        blocks[nblocks] = (uint32_t)packed_size;
+        free(check);
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.Magic = FONT_PACK_MAGIC;
+    hdr.Version = FONT_PACK_VERSION;
+    hdr.Width = gen.Width;
+    hdr.Height = gen.Height;
+    hdr.ASCII_Width = ascii_width;
+    hdr.GlyphBytes = gen.GlyphBytes;
+    hdr.Count = count;
+    hdr.Flags = packbits ? FONT_PACK_PACKBITS : 0;
+    hdr.LookupOffset = sizeof(hdr);
+    hdr.BlockOffset = packbits ? hdr.LookupOffset + sizeof(uint16_t) * FONT_CN_SLOTS : 0;
+    hdr.DataOffset = packbits ? hdr.BlockOffset + sizeof(uint32_t) * ((count + FONT_PACK_BLOCK - 1) / FONT_PACK_BLOCK + 1)
+                              : hdr.LookupOffset + sizeof(uint16_t) * FONT_CN_SLOTS;
+    hdr.DataSize = packbits ? packed_size : data_size;
+
+    fp = fopen(argv[3], "wb");
+    if (!fp) {
+        printf("Cannot create %s\n", argv[3]);
+        return 1;
+    }
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    fwrite(lookup, sizeof(uint16_t), FONT_CN_SLOTS, fp);
+    if (packbits) {
+        fwrite(blocks, sizeof(uint32_t), (count + FONT_PACK_BLOCK - 1) / FONT_PACK_BLOCK + 1, fp);
+        fwrite(packed, 1, packed_size, fp);
+    } else {
+        fwrite(glyphs, 1, data_size, fp);
+    }
+    if (fclose(fp) != 0) {
+        printf("Cannot write %s\n", argv[3]);
+        return 1;
+    }
+
+    printf("%s: %zu glyphs, cell %dx%d, ASCII width %d, %u bytes of glyphs%s\n", argv[3], count,
+           gen.Width, gen.Height, ascii_width, hdr.DataSize, packbits ? " (PackBits)" : "");
+    FT_Done_Face(gen.Face);
+    FT_Done_FreeType(library);
+    free(lookup);
+    free(glyphs);
+    free(blocks);
+    free(packed);
+    return 0;
+}